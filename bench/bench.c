@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "bench.h"
+#include "errors.h"
+#include "timer.h"
+
+#define TM_BENCH_MAX_REPEATS 1000
+
+/**
+ * Create a new benchmark runner, and start the JSON report.
+ * Hardware counters are used if available.
+ * @pre \code{.c}
+ * repeats > 1 && repeats <= TM_BENCH_MAX_REPEATS
+ * \endcode
+ * @param json where to write the JSON report (may be \p NULL)
+ * @param repeats number of timed repetitions for each benchmark
+ * @return a new runner, \p NULL if \p malloc failed
+ */
+tm_bench* tm_bench_new(FILE* json, int repeats) {
+    assert(repeats > 1 && repeats <= TM_BENCH_MAX_REPEATS);
+
+    tm_bench* bench = malloc(sizeof(tm_bench));
+
+    if(bench != NULL) {
+        bench->json = json;
+        bench->repeats = repeats;
+        bench->warmup_time = .1;
+        bench->min_time = .01;
+        bench->filter = NULL;
+        bench->N_results = 0;
+
+        bench->counters = tm_perf_counters_new();
+        if(bench->counters != NULL && bench->counters->N_available == 0) {
+            tm_perf_counters_delete(bench->counters);
+            bench->counters = NULL;
+        }
+
+        if(bench->counters == NULL)
+            fprintf(stderr, "(hardware counters are not available)\n");
+
+        if(json != NULL)
+            fprintf(json, "{\n  \"repeats\": %d,\n  \"benchmarks\": [", repeats);
+    }
+
+    return bench;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *((double*) a), y = *((double*) b);
+    return (x > y) - (x < y);
+}
+
+/**
+ * Run a benchmark: \p func is first called until \p bench->warmup_time is elapsed, which gives an estimate of its cost.
+ * Then, \p bench->repeats repetitions of (at least) \p bench->min_time are timed.
+ * The metric is computed from the median time per call, and both a line on \p stdout and a JSON record are written.
+ * If available, hardware counters are read around the timed repetitions, and reported per unit of work.
+ * @pre \code{.c}
+ * bench != NULL && name != NULL && func != NULL && work > 0 && unit != NULL
+ * \endcode
+ * @param bench the runner
+ * @param name name of the benchmark
+ * @param params parameters of the benchmark, as the inside of a JSON object (e.g., \p "\"N\": 64"), may be \p NULL
+ * @param func function to benchmark
+ * @param data passed to \p func
+ * @param work amount of work done by each call to \p func (number of items, or bytes for \p TM_BENCH_MB_PER_S)
+ * @param metric how to report the result
+ * @param unit name of the unit of work (e.g., \p "pair")
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the samples could not be allocated
+ */
+int tm_bench_run(tm_bench* bench, char* name, char* params, tm_bench_func func, void* data, double work, tm_bench_metric metric, char* unit) {
+    assert(bench != NULL && name != NULL && func != NULL && work > 0 && unit != NULL);
+
+    if(bench->filter != NULL && strstr(name, bench->filter) == NULL)
+        return TM_ERR_OK;
+
+    double* samples = malloc(2 * bench->repeats * sizeof(double));
+    if(samples == NULL)
+        return TM_ERR_MALLOC;
+
+    double* sorted = samples + bench->repeats;
+    struct timespec t;
+
+    // warm-up (also gives an estimate of the time per call)
+    long calls = 0;
+    double elapsed = 0;
+    timer_start(&t);
+    do {
+        func(data);
+        calls++;
+        elapsed = timer_stop(&t);
+    } while (elapsed < bench->warmup_time);
+
+    long inner = (long) ceil(bench->min_time / (elapsed / calls));
+    if(inner < 1)
+        inner = 1;
+
+    // timed repetitions
+    double counts_start[TM_PERF_LAST], counts[TM_PERF_LAST];
+    if(bench->counters != NULL)
+        tm_perf_counters_read(bench->counters, counts_start);
+
+    for(int r=0; r < bench->repeats; r++) {
+        timer_start(&t);
+        for(long c=0; c < inner; c++)
+            func(data);
+        samples[r] = timer_stop(&t) / inner;
+    }
+
+    if(bench->counters != NULL) {
+        tm_perf_counters_read(bench->counters, counts);
+        for(int i=0; i < TM_PERF_LAST; i++)
+            counts[i] = (counts[i] - counts_start[i]) / ((double) bench->repeats * inner * work);
+    }
+
+    // statistics
+    double mean = 0, stddev = 0, median;
+    for(int r=0; r < bench->repeats; r++) {
+        mean += samples[r];
+        sorted[r] = samples[r];
+    }
+
+    mean /= bench->repeats;
+
+    for(int r=0; r < bench->repeats; r++)
+        stddev += (samples[r] - mean) * (samples[r] - mean);
+
+    stddev = sqrt(stddev / (bench->repeats - 1));
+
+    qsort(sorted, bench->repeats, sizeof(double), compare_doubles);
+    median = bench->repeats % 2 == 0 ? (sorted[bench->repeats / 2 - 1] + sorted[bench->repeats / 2]) / 2 : sorted[bench->repeats / 2];
+
+    double value;
+    char metric_unit[64];
+    switch (metric) {
+        case TM_BENCH_NS_PER_ITEM:
+            value = median / work * 1e9;
+            snprintf(metric_unit, 64, "ns/%s", unit);
+            break;
+        case TM_BENCH_ITEMS_PER_S:
+            value = work / median;
+            snprintf(metric_unit, 64, "%s/s", unit);
+            break;
+        default:
+            value = work / median * 1e-6;
+            snprintf(metric_unit, 64, "MB/s");
+            break;
+    }
+
+    printf("%-16s %-32s %12.4g %-10s (median of %d x %ld calls, rel. stddev %.1f%%)",
+           name, params != NULL ? params : "", value, metric_unit, bench->repeats, inner, stddev / mean * 100);
+
+    if(bench->counters != NULL)
+        printf(" IPC = %.2f, L1d misses = %.3g/%s", counts[TM_PERF_INSTRUCTIONS] / counts[TM_PERF_CYCLES], counts[TM_PERF_L1D_MISSES], unit);
+
+    printf("\n");
+
+    if(bench->json != NULL) {
+        fprintf(bench->json,
+                "%s\n    {\"name\": \"%s\", \"params\": {%s}, \"value\": %.6g, \"unit\": \"%s\", \"work\": %.17g, \"inner\": %ld, "
+                "\"time\": {\"min\": %.6e, \"median\": %.6e, \"mean\": %.6e, \"stddev\": %.6e}",
+                bench->N_results > 0 ? "," : "", name, params != NULL ? params : "", value, metric_unit, work, inner,
+                sorted[0], median, mean, stddev);
+
+        // counters, per unit of work (unavailable ones are skipped)
+        if(bench->counters != NULL) {
+            int first = 1;
+            fprintf(bench->json, ", \"counters\": {");
+            for(int i=0; i < TM_PERF_LAST; i++) {
+                if(!isnan(counts[i])) {
+                    fprintf(bench->json, "%s\"%s\": %.6g", first ? "" : ", ", tm_perf_counters_name(i), counts[i]);
+                    first = 0;
+                }
+            }
+
+            fprintf(bench->json, "}");
+        }
+
+        fprintf(bench->json, "}");
+    }
+
+    bench->N_results++;
+
+    free(samples);
+    return TM_ERR_OK;
+}
+
+/**
+ * Close the JSON report and free the runner.
+ * @pre \code{.c}
+ * bench != NULL
+ * \endcode
+ * @param bench the runner
+ * @return \p TM_ERR_OK
+ */
+int tm_bench_delete(tm_bench* bench) {
+    assert(bench != NULL);
+
+    if(bench->json != NULL)
+        fprintf(bench->json, "\n  ]\n}\n");
+
+    if(bench->counters != NULL)
+        tm_perf_counters_delete(bench->counters);
+
+    free(bench);
+    return TM_ERR_OK;
+}
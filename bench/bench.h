@@ -0,0 +1,46 @@
+#ifndef TOYMC_BENCH_H
+#define TOYMC_BENCH_H
+
+#include <stdio.h>
+
+#include "perf_counters.h"
+
+/**
+ * @brief How the result of a benchmark is reported
+ */
+typedef enum tm_bench_metric_ {
+    TM_BENCH_NS_PER_ITEM, // time per unit of work (e.g., ns/pair)
+    TM_BENCH_ITEMS_PER_S, // unit of work per second (e.g., moves/s)
+    TM_BENCH_MB_PER_S, // throughput, the unit of work being the byte
+} tm_bench_metric;
+
+/**
+ * @brief Benchmark runner.
+ * Fields are \code{.c}
+ * FILE* json; // where the JSON report is written (may be NULL)
+ * int repeats; // number of timed repetitions
+ * double warmup_time; // minimum duration of the warm-up (in second)
+ * double min_time; // minimum duration of a repetition (in second)
+ * char* filter; // only run benchmarks whose name contains this string (NULL for all)
+ * tm_perf_counters* counters; // hardware counters (NULL if none is available)
+ * int N_results; // number of results written so far
+ * \endcode
+ */
+typedef struct tm_bench_ {
+    FILE* json;
+    int repeats;
+    double warmup_time;
+    double min_time;
+    char* filter;
+    tm_perf_counters* counters;
+
+    int N_results;
+} tm_bench;
+
+typedef void (*tm_bench_func)(void* data);
+
+tm_bench* tm_bench_new(FILE* json, int repeats);
+int tm_bench_run(tm_bench* bench, char* name, char* params, tm_bench_func func, void* data, double work, tm_bench_metric metric, char* unit);
+int tm_bench_delete(tm_bench* bench);
+
+#endif //TOYMC_BENCH_H
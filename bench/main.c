@@ -0,0 +1,479 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bench.h"
+#include "errors.h"
+#include "mc.h"
+#include "pcg32.h"
+#include "potentials.h"
+#include "tabulated.h"
+#include "xyz_parser.h"
+#include "xyz_writer.h"
+#include "param_file_parser.h"
+
+#define MAX_PAIRS (1l << 18)
+#define RNG_BATCH 4096
+
+/* A box of LJ particles, perturbed from a cubic lattice, and what the benchmarks needs around it.
+ */
+typedef struct config_ {
+    long N;
+    double rho;
+    double L;
+    double rc2;
+    tm_mc* mc; // a box with these positions
+    double* positions; // 4*stride (see tm_mc)
+
+    long N_pairs;
+    double* r2; // square distances of (at most MAX_PAIRS) pairs
+    double* rv; // 2*N_pairs, input of tm_potential_LJ_N()
+    tm_pair_tables* tables; // LJ, tabulated
+    tm_potential* potential; // of the registry (see bench_pair_kernel())
+    double params[TM_POTENTIAL_MAX_PARAMS];
+
+    long i; // current atom
+
+    double U, vir; // sinks
+    uint32_t sink;
+} config;
+
+static config* config_new(long N, double rho) {
+    config* c = malloc(sizeof(config));
+    if(c == NULL)
+        return NULL;
+
+    c->N = N;
+    c->rho = rho;
+    c->L = pow(N / rho, 1. / 3);
+    c->rc2 = fmin(2.5, c->L / 2) * fmin(2.5, c->L / 2);
+    c->i = 0;
+    c->U = c->vir = 0;
+    c->sink = 0;
+
+    c->N_pairs = N * (N - 1) / 2;
+    if(c->N_pairs > MAX_PAIRS)
+        c->N_pairs = MAX_PAIRS;
+
+    pcg32_init(42);
+    c->mc = tm_mc_new(N, rho, .9, sqrt(c->rc2), .3);
+    c->r2 = malloc(c->N_pairs * sizeof(double));
+    c->rv = malloc(2 * c->N_pairs * sizeof(double));
+
+    c->tables = c->mc != NULL ? tm_pair_tables_new_from_coefs(c->mc->coefs, 1024) : NULL;
+
+    if(c->mc == NULL || c->tables == NULL || c->r2 == NULL || c->rv == NULL) {
+        if(c->mc != NULL)
+            tm_mc_delete(c->mc);
+        if(c->tables != NULL)
+            tm_pair_tables_delete(c->tables);
+        free(c->r2);
+        free(c->rv);
+        free(c);
+        return NULL;
+    }
+
+    // lattice, slightly perturbed (so that distances are not all the same)
+    c->positions = c->mc->positions;
+    long S = c->mc->stride;
+    for(int k=0; k < 3; k++) {
+        for(long i=0; i < N; i++)
+            c->positions[k * S + i] += (drand() - .5) * .1;
+    }
+
+    // pair distances
+    long p = 0;
+    for(long i=0; i < N - 1 && p < c->N_pairs; i++) {
+        for(long j=i+1; j < N && p < c->N_pairs; j++, p++) {
+            c->r2[p] = 0;
+            for(int k=0; k < 3; k++) {
+                double dq = c->positions[k * S + j] - c->positions[k * S + i];
+                dq -= c->L * round(dq / c->L);
+                c->r2[p] += dq * dq;
+            }
+        }
+    }
+
+    return c;
+}
+
+static void config_delete(config* c) {
+    tm_mc_delete(c->mc);
+    tm_pair_tables_delete(c->tables);
+    free(c->r2);
+    free(c->rv);
+    free(c);
+}
+
+/* Benchmarks
+ */
+
+static void bench_potential_LJ(void* data) {
+    config* c = data;
+    for(long p=0; p < c->N_pairs; p++)
+        tm_potential_LJ(c->r2[p], 1., c->rc2, &c->U, &c->vir);
+}
+
+// tm_potential_LJ_N() overwrites its input, so that the cost of refilling it is included.
+static void bench_potential_LJ_N(void* data) {
+    config* c = data;
+    memcpy(c->rv, c->r2, c->N_pairs * sizeof(double));
+    for(long p=0; p < c->N_pairs; p++)
+        c->rv[c->N_pairs + p] = 1.;
+
+    tm_potential_LJ_N(c->N_pairs, c->rv, c->rc2, &c->U, &c->vir);
+}
+
+static void bench_table_sum_N(void* data) {
+    config* c = data;
+    tm_table_sum_N(&(c->tables->tables[0]), c->N_pairs, c->r2, &c->U, &c->vir);
+}
+
+static void bench_pair_kernel(void* data) {
+    config* c = data;
+    c->potential->kernels[1][1](c->N_pairs, c->r2, c->params, c->rc2, &c->U, &c->vir);
+}
+
+static void bench_compute_U(void* data) {
+    config* c = data;
+    tm_mc_compute_U(c->mc, &c->U, &c->vir);
+}
+
+// number of atoms of a tile of bench_compute_U_tiled() (two blocks of positions take 12 kB, and fit in L1)
+#define BENCH_TILE 256
+
+// Same as tm_mc_compute_U(), but by tiles: the pairs between a block of atoms i and a block of atoms j are computed
+// together, so that both blocks stay in cache. Measured against compute_U, this made no difference beyond the noise
+// from N=64 to N=4096 (the evaluation of the potential dominates), so that the library does not use it.
+static void bench_compute_U_tiled(void* data) {
+    config* c = data;
+    tm_mc* mc = c->mc;
+    long N = mc->N;
+
+    c->U = 0;
+    c->vir = 0;
+
+    for(long istart=0; istart < N; istart += BENCH_TILE) {
+        long iend = istart + BENCH_TILE < N ? istart + BENCH_TILE : N;
+        for(long jstart=istart; jstart < N; jstart += BENCH_TILE) {
+            long jend = jstart + BENCH_TILE < N ? jstart + BENCH_TILE : N;
+            for(long i=istart; i < iend; i++) {
+                long start = i + 1 > jstart ? i + 1 : jstart;
+                if(start < jend)
+                    mc->energy_kernel_double(mc, mc->pair_kernel_virial, i, start, jend, &c->U, &c->vir);
+            }
+        }
+    }
+}
+
+static void bench_compute_Ui(void* data) {
+    config* c = data;
+    tm_mc_compute_Ui(c->mc, c->i, &c->U, &c->vir);
+    c->i = (c->i + 1) % c->N;
+}
+
+static void bench_mc_sweep(void* data) {
+    tm_mc_sweep((tm_mc*) data);
+}
+
+static void bench_pcg32(void* data) {
+    config* c = data;
+    for(int r=0; r < RNG_BATCH; r++)
+        c->sink += pcg32();
+}
+
+static void bench_drand(void* data) {
+    config* c = data;
+    for(int r=0; r < RNG_BATCH; r++)
+        c->U += drand();
+}
+
+static void bench_xyz_loads(void* data) {
+    tm_geometry* g = tm_xyz_loads((char*) data);
+    if(g == NULL) {
+        fprintf(stderr, "error while parsing XYZ\n");
+        exit(EXIT_FAILURE);
+    }
+
+    tm_geometry_delete(g);
+}
+
+/* Writing a frame, compared to one fprintf() per atom.
+ */
+typedef struct frame_ {
+    tm_geometry* geometry;
+    FILE* f;
+} frame;
+
+static void bench_xyz_write(void* data) {
+    frame* fr = data;
+    rewind(fr->f);
+    if(tm_xyz_write(fr->f, fr->geometry, "generated", 1) != TM_ERR_OK) {
+        fprintf(stderr, "error while writing XYZ\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void bench_xyz_write_printf(void* data) {
+    frame* fr = data;
+    tm_geometry* g = fr->geometry;
+    rewind(fr->f);
+    fprintf(fr->f, "%ld\ngenerated\n", g->N);
+    for(long i=0; i < g->N; i++)
+        fprintf(fr->f, "%s %9.5f %9.5f %9.5f\n", g->type_vals[g->types[i]], g->positions[i], g->positions[g->stride + i], g->positions[2 * g->stride + i]);
+}
+
+static void bench_parf_loads(void* data) {
+    tm_parf_t* obj = tm_parf_loads((char*) data);
+    if(obj == NULL) {
+        fprintf(stderr, "error while parsing parameter file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    tm_parf_delete(obj);
+}
+
+/* Inputs for the parsers
+ */
+
+static char* make_xyz(config* c) {
+    char* out = malloc(32 + 48 * c->N);
+    if(out == NULL)
+        return NULL;
+
+    int pos = sprintf(out, "%ld\ngenerated\n", c->N);
+    for(long i=0; i < c->N; i++)
+        pos += sprintf(out + pos, "He %9.5f %9.5f %9.5f\n", c->positions[i], c->positions[c->mc->stride + i], c->positions[2 * c->mc->stride + i]);
+
+    return out;
+}
+
+static char* make_parf(config* c) {
+    char* out = malloc(64 + 48 * c->N);
+    if(out == NULL)
+        return NULL;
+
+    int pos = sprintf(out, "# generated\nseed 42\ncoordinates \"out.xyz\"\n");
+    for(long i=0; i < c->N / 4; i++)
+        pos += sprintf(out + pos, "key_%ld %.6f\n", i, c->positions[i]);
+
+    pos += sprintf(out + pos, "positions [");
+    for(long i=0; i < c->N; i++)
+        pos += sprintf(out + pos, " %.6f", c->positions[i]);
+
+    sprintf(out + pos, " ]\n");
+    return out;
+}
+
+static int run_all(tm_bench* bench, long* Ns, int N_Ns, double* rhos, int N_rhos) {
+    char params[128];
+    int err;
+
+    for(int n=0; n < N_Ns; n++) {
+        for(int d=0; d < N_rhos; d++) {
+            config* c = config_new(Ns[n], rhos[d]);
+            if(c == NULL)
+                return TM_ERR_MALLOC;
+
+            long N = c->N;
+            snprintf(params, 128, "\"N\": %ld, \"rho\": %.2f", N, c->rho);
+
+            if((err = tm_bench_run(bench, "potential_LJ", params, bench_potential_LJ, c, (double) c->N_pairs, TM_BENCH_NS_PER_ITEM, "pair")) != TM_ERR_OK
+                || (err = tm_bench_run(bench, "potential_LJ_N", params, bench_potential_LJ_N, c, (double) c->N_pairs, TM_BENCH_NS_PER_ITEM, "pair")) != TM_ERR_OK
+                || (err = tm_bench_run(bench, "table_sum_N", params, bench_table_sum_N, c, (double) c->N_pairs, TM_BENCH_NS_PER_ITEM, "pair")) != TM_ERR_OK
+                || (err = tm_bench_run(bench, "compute_U", params, bench_compute_U, c, (double) N * (N - 1) / 2, TM_BENCH_NS_PER_ITEM, "pair")) != TM_ERR_OK
+                || (err = tm_bench_run(bench, "compute_Ui", params, bench_compute_Ui, c, (double) N - 1, TM_BENCH_NS_PER_ITEM, "pair")) != TM_ERR_OK) {
+                config_delete(c);
+                return err;
+            }
+
+            // by tiles, for comparison with compute_U
+            if((err = tm_bench_run(bench, "compute_U_tiled", params, bench_compute_U_tiled, c, (double) N * (N - 1) / 2, TM_BENCH_NS_PER_ITEM, "pair")) != TM_ERR_OK) {
+                config_delete(c);
+                return err;
+            }
+
+            // the variant of the kernels without virial, then with distances in single precision, then in fixed point
+            tm_mc_select_kernels(c->mc, 0);
+            err = tm_bench_run(bench, "compute_Ui_no_virial", params, bench_compute_Ui, c, (double) N - 1, TM_BENCH_NS_PER_ITEM, "pair");
+            tm_mc_select_kernels(c->mc, 1);
+
+            if(err == TM_ERR_OK && (err = tm_mc_use_single_precision(c->mc, 1)) == TM_ERR_OK) {
+                err = tm_bench_run(bench, "compute_Ui_single", params, bench_compute_Ui, c, (double) N - 1, TM_BENCH_NS_PER_ITEM, "pair");
+                tm_mc_use_single_precision(c->mc, 0);
+            }
+
+            if(err == TM_ERR_OK && (err = tm_mc_use_fixed_point(c->mc, 1)) == TM_ERR_OK) {
+                err = tm_bench_run(bench, "compute_Ui_fixed", params, bench_compute_Ui, c, (double) N - 1, TM_BENCH_NS_PER_ITEM, "pair");
+                tm_mc_use_fixed_point(c->mc, 0);
+            }
+
+            if(err != TM_ERR_OK) {
+                config_delete(c);
+                return err;
+            }
+
+            // two types of atoms, sorted by type (coefficients are the same over blocks) or not (they are gathered)
+            for(int sort=0; sort < 2 && err == TM_ERR_OK; sort++) {
+                long composition[] = {N / 2, N - N / 2};
+                double epsilon[] = {1., .5}, sigma[] = {1., 1.2};
+
+                config cm = *c;
+                cm.i = 0;
+                cm.mc = tm_mc_new_mixture(2, composition, epsilon, sigma, TM_MIXING_LORENTZ_BERTHELOT, c->rho, .9, sqrt(c->rc2) / 1.2, .3, sort);
+                if(cm.mc == NULL) {
+                    err = TM_ERR_MALLOC;
+                } else {
+                    char params_mixture[160];
+                    snprintf(params_mixture, 160, "%s, \"sorted\": %d", params, sort);
+                    err = tm_bench_run(bench, "compute_Ui_mixture", params_mixture, bench_compute_Ui, &cm, (double) N - 1, TM_BENCH_NS_PER_ITEM, "pair");
+                    tm_mc_delete(cm.mc);
+                }
+            }
+
+            if(err != TM_ERR_OK) {
+                config_delete(c);
+                return err;
+            }
+
+            // each potential of the registry, through its kernel (with the cutoff of the config)
+            char* potentials[] = {"lj", "wca", "sf-lj", "morse", "buckingham"};
+            for(int k=0; k < 5 && err == TM_ERR_OK; k++) {
+                char params_potential[160];
+                config cp = *c;
+                double rc2 = c->rc2;
+
+                tm_potential_find(potentials[k], &(cp.potential));
+                cp.potential->setup(1., 1., cp.potential->alpha, cp.params, &rc2);
+                snprintf(params_potential, 160, "%s, \"potential\": \"%s\"", params, potentials[k]);
+                err = tm_bench_run(bench, "pair_kernel", params_potential, bench_pair_kernel, &cp, (double) c->N_pairs, TM_BENCH_NS_PER_ITEM, "pair");
+            }
+
+            if(err != TM_ERR_OK) {
+                config_delete(c);
+                return err;
+            }
+
+            // a full sweep, as in the main loop of the program
+            pcg32_init(42);
+            tm_mc* mc = tm_mc_new(N, c->rho, .9, sqrt(c->rc2), .3);
+            if(mc == NULL)
+                err = TM_ERR_MALLOC;
+            else {
+                err = tm_bench_run(bench, "mc_sweep", params, bench_mc_sweep, mc, (double) N, TM_BENCH_ITEMS_PER_S, "move");
+
+                // energy only, as in the program (the virial is computed when the pressure is sampled)
+                if(err == TM_ERR_OK) {
+                    tm_mc_select_kernels(mc, 0);
+                    err = tm_bench_run(bench, "mc_sweep_no_virial", params, bench_mc_sweep, mc, (double) N, TM_BENCH_ITEMS_PER_S, "move");
+                }
+
+                tm_mc_delete(mc);
+            }
+
+            if(err != TM_ERR_OK) {
+                config_delete(c);
+                return err;
+            }
+
+            // parsers only depend on N
+            if(d == 0) {
+                snprintf(params, 128, "\"N\": %ld", N);
+                char* xyz = make_xyz(c);
+                char* parf = make_parf(c);
+
+                if(xyz == NULL || parf == NULL)
+                    err = TM_ERR_MALLOC;
+                else if((err = tm_bench_run(bench, "xyz_loads", params, bench_xyz_loads, xyz, (double) strlen(xyz), TM_BENCH_MB_PER_S, "B")) == TM_ERR_OK)
+                    err = tm_bench_run(bench, "parf_loads", params, bench_parf_loads, parf, (double) strlen(parf), TM_BENCH_MB_PER_S, "B");
+
+                // writers
+                frame fr = {NULL, NULL};
+                if(err == TM_ERR_OK) {
+                    fr.geometry = tm_xyz_loads(xyz);
+                    fr.f = fopen("/dev/null", "w");
+                    if(fr.geometry == NULL || fr.f == NULL)
+                        err = TM_ERR_MALLOC;
+                }
+
+                if(err == TM_ERR_OK && (err = tm_bench_run(bench, "xyz_write", params, bench_xyz_write, &fr, (double) strlen(xyz), TM_BENCH_MB_PER_S, "B")) == TM_ERR_OK)
+                    err = tm_bench_run(bench, "xyz_write_printf", params, bench_xyz_write_printf, &fr, (double) strlen(xyz), TM_BENCH_MB_PER_S, "B");
+
+                if(fr.geometry != NULL)
+                    tm_geometry_delete(fr.geometry);
+                if(fr.f != NULL)
+                    fclose(fr.f);
+
+                free(xyz);
+                free(parf);
+            }
+
+            // RNG does not depend on anything
+            if(n == 0 && d == 0 && err == TM_ERR_OK) {
+                if((err = tm_bench_run(bench, "pcg32", NULL, bench_pcg32, c, RNG_BATCH, TM_BENCH_NS_PER_ITEM, "call")) == TM_ERR_OK)
+                    err = tm_bench_run(bench, "drand", NULL, bench_drand, c, RNG_BATCH, TM_BENCH_NS_PER_ITEM, "call");
+            }
+
+            config_delete(c);
+
+            if(err != TM_ERR_OK)
+                return err;
+        }
+    }
+
+    return TM_ERR_OK;
+}
+
+int main(int argc, char* argv[]) {
+    long Ns[] = {64, 256, 1024, 4096};
+    double rhos[] = {.1, .8};
+    int N_Ns = 4, repeats = 10;
+    char* out = NULL;
+    char* filter = NULL;
+
+    for(int i=1; i < argc; i++) {
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+            if(repeats < 2 || repeats > 1000)
+                return EXIT_FAILURE;
+        } else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if(strcmp(argv[i], "-q") == 0) { // quick: only the smallest sizes
+            N_Ns = 2;
+        } else {
+            fprintf(stderr, "usage: %s [-o report.json] [-r repeats] [-f filter] [-q]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE* json = NULL;
+    if(out != NULL) {
+        json = fopen(out, "w");
+        if(json == NULL) {
+            fprintf(stderr, "error while opening %s\n", out);
+            return EXIT_FAILURE;
+        }
+    }
+
+    tm_bench* bench = tm_bench_new(json, repeats);
+    if(bench == NULL)
+        return EXIT_FAILURE;
+
+    bench->filter = filter;
+
+    int err = run_all(bench, Ns, N_Ns, rhos, 2);
+
+    tm_bench_delete(bench);
+    if(json != NULL)
+        fclose(json);
+
+    if(err != TM_ERR_OK) {
+        fprintf(stderr, "error: %s\n", ERROR_EXPLS[err]);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mc.h"
+#include "pcg32.h"
+#include "timer.h"
+
+/* End-to-end scenarios: each one is a full simulation with a fixed seed, whose average energy and pressure
+ * (per atom, tail corrections included) are checked against reference values.
+ * Since any change in the order of floating point operations changes the trajectory, the tolerances are
+ * statistical: references are averages over many seeds, and tolerances are about 4 times the standard deviation
+ * of the averages obtained with different seeds (for the same number of sweeps).
+ */
+typedef struct scenario_ {
+    char* name;
+    long N;
+    double rho;
+    double T;
+    double rc;
+    double delta;
+    long seed;
+    long n_equilibration; // number of sweeps before the averages are computed
+    long n_production; // number of sweeps for the averages
+
+    double U_ref, U_tol; // reference <U>/N
+    double P_ref, P_tol; // reference <P>
+} scenario;
+
+// references obtained from 16 seeds (Release build)
+static scenario scenarios[] = {
+        {"dilute_gas", 216, .05, 2., 2.5, 1.5, 1024, 200, 400, -.338, .025, .0940, .002},
+        {"liquid", 512, .8, .9, 4., .3, 1024, 300, 300, -5.627, .055, .516, .25},
+        {"triple_point", 343, .85, .75, 3., .25, 1024, 300, 300, -6.086, .055, .436, .26},
+        // mostly for throughput: too short to be fully equilibrated, but still reproducible
+        {"large_N", 1728, .8, .9, 4., .3, 1024, 100, 100, -5.600, .035, .627, .18},
+};
+
+/* Run a scenario, and return 1 if the averages are within the tolerances.
+ */
+static int run_scenario(scenario* s, long seed) {
+    struct timespec t;
+    double U_avg = 0, P_avg = 0, elapsed;
+
+    pcg32_init(seed);
+    tm_mc* mc = tm_mc_new(s->N, s->rho, s->T, s->rc, s->delta);
+    if(mc == NULL) {
+        fprintf(stderr, "cannot allocate %s\n", s->name);
+        return 0;
+    }
+
+    timer_start(&t);
+    for(long i=0; i < s->n_equilibration; i++)
+        tm_mc_sweep(mc);
+
+    for(long i=0; i < s->n_production; i++) {
+        tm_mc_sweep(mc);
+        U_avg += tm_mc_energy(mc) / s->N;
+        P_avg += tm_mc_pressure(mc);
+    }
+    elapsed = timer_stop(&t);
+
+    U_avg /= s->n_production;
+    P_avg /= s->n_production;
+
+    int ok = fabs(U_avg - s->U_ref) <= s->U_tol && fabs(P_avg - s->P_ref) <= s->P_tol;
+
+    printf("%-14s seed=%-6ld %10.2f sweeps/s, acceptance = %5.1f%%, <U>/N = %8.4f (ref. %8.4f ± %.4f), <P> = %8.4f (ref. %8.4f ± %.4f): %s\n",
+           s->name, seed,
+           (s->n_equilibration + s->n_production) / elapsed,
+           100. * mc->N_accepted / mc->N_moves,
+           U_avg, s->U_ref, s->U_tol,
+           P_avg, s->P_ref, s->P_tol,
+           ok ? "OK" : "FAILED");
+
+    tm_mc_delete(mc);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    char* filter = NULL;
+    long seed = -1;
+
+    for(int i=1; i < argc; i++) {
+        if(strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc) { // override the seeds (to compute new references)
+            seed = atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [-f filter] [-s seed]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    int failed = 0;
+    for(unsigned long i=0; i < sizeof(scenarios) / sizeof(scenario); i++) {
+        if(filter != NULL && strstr(scenarios[i].name, filter) == NULL)
+            continue;
+
+        if(!run_scenario(&scenarios[i], seed < 0 ? scenarios[i].seed : seed))
+            failed++;
+    }
+
+    if(failed > 0) {
+        printf("%d scenario(s) failed\n", failed);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
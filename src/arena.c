@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <assert.h>
+
+#include "arena.h"
+#include "memory.h"
+#include "errors.h"
+
+// size of the header of a chunk, so that data are aligned
+#define TM_ARENA_HEADER_SIZE ((sizeof(tm_arena_chunk) + TM_ARENA_ALIGN - 1) / TM_ARENA_ALIGN * TM_ARENA_ALIGN)
+
+/**
+ * Create a new arena. Nothing is allocated until the first call to \p tm_arena_alloc().
+ * @param chunk_size size of the first chunk
+ * @return the arena, or \p NULL if malloc failed
+ */
+tm_arena* tm_arena_new(size_t chunk_size) {
+    tm_arena* arena = tm_malloc(sizeof(tm_arena), TM_MEM_PARAMETERS);
+
+    if(arena != NULL) {
+        arena->current = NULL;
+        arena->chunk_size = chunk_size < TM_ARENA_ALIGN ? TM_ARENA_ALIGN : chunk_size;
+        arena->allocated = 0;
+    }
+
+    return arena;
+}
+
+/**
+ * Allocate a new chunk of (at least) \p size bytes.
+ * @param arena the arena
+ * @param size requested size
+ * @return the chunk, or \p NULL if malloc failed
+ */
+static tm_arena_chunk* arena_chunk_new(tm_arena* arena, size_t size) {
+    tm_arena_chunk* chunk = tm_malloc(TM_ARENA_HEADER_SIZE + size, TM_MEM_PARAMETERS);
+
+    if(chunk != NULL) {
+        chunk->prev = NULL;
+        chunk->size = size;
+        chunk->used = 0;
+
+        arena->allocated += size;
+    }
+
+    return chunk;
+}
+
+/**
+ * Get \p size bytes (aligned on \p TM_ARENA_ALIGN) from \p arena.
+ * Large requests get their own chunk, which is placed behind the current one, so that the latter is not wasted.
+ * @pre \code{.c}
+ * arena != NULL
+ * \endcode
+ * @param arena the arena
+ * @param size the number of bytes
+ * @return a pointer to the memory, or \p NULL if malloc failed. It must \b not be free'd.
+ */
+void* tm_arena_alloc(tm_arena* arena, size_t size) {
+    assert(arena != NULL);
+
+    size = (size + TM_ARENA_ALIGN - 1) / TM_ARENA_ALIGN * TM_ARENA_ALIGN;
+
+    tm_arena_chunk* chunk = arena->current;
+
+    if(chunk == NULL || chunk->size - chunk->used < size) {
+        if(chunk != NULL && size > arena->chunk_size / 4) { // dedicated chunk
+            tm_arena_chunk* large = arena_chunk_new(arena, size);
+            if(large == NULL)
+                return NULL;
+
+            large->prev = chunk->prev;
+            chunk->prev = large;
+            large->used = size;
+
+            return (char*) large + TM_ARENA_HEADER_SIZE;
+        }
+
+        chunk = arena_chunk_new(arena, size > arena->chunk_size ? size : arena->chunk_size);
+        if(chunk == NULL)
+            return NULL;
+
+        chunk->prev = arena->current;
+        arena->current = chunk;
+
+        if(arena->chunk_size < TM_ARENA_MAX_CHUNK_SIZE)
+            arena->chunk_size *= 2;
+    }
+
+    void* ptr = (char*) chunk + TM_ARENA_HEADER_SIZE + chunk->used;
+    chunk->used += size;
+
+    return ptr;
+}
+
+/**
+ * Delete \p arena, and release all the memory that was given by it.
+ * @pre \code{.c} arena != NULL \endcode
+ * @param arena the arena
+ * @return \p TM_ERR_OK
+ */
+int tm_arena_delete(tm_arena* arena) {
+    assert(arena != NULL);
+
+    tm_arena_chunk* chunk = arena->current, *prev;
+    while(chunk != NULL) {
+        prev = chunk->prev;
+        tm_free(chunk);
+        chunk = prev;
+    }
+
+    tm_free(arena);
+    return TM_ERR_OK;
+}
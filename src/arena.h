@@ -0,0 +1,41 @@
+#ifndef TOYMC_ARENA_H
+#define TOYMC_ARENA_H
+
+#include <stddef.h>
+
+#define TM_ARENA_ALIGN 16
+#define TM_ARENA_MAX_CHUNK_SIZE (1 << 20)
+
+/**
+ * @brief A chunk of memory of the arena, followed by its data.
+ * Fields are \code{.c}
+ * struct tm_arena_chunk_* prev; // previous chunk
+ * size_t size; // size of the data
+ * size_t used; // number of bytes of the data already given
+ * \endcode
+ */
+typedef struct tm_arena_chunk_ {
+    struct tm_arena_chunk_* prev;
+    size_t size;
+    size_t used;
+} tm_arena_chunk;
+
+/**
+ * @brief Bump-pointer allocator: memory is given from large chunks, and is only released all at once.
+ * Fields are \code{.c}
+ * tm_arena_chunk* current; // chunk from which memory is given
+ * size_t chunk_size; // size of the next chunk (doubles every time, up to TM_ARENA_MAX_CHUNK_SIZE)
+ * size_t allocated; // total number of bytes allocated for the chunks
+ * \endcode
+ */
+typedef struct tm_arena_ {
+    tm_arena_chunk* current;
+    size_t chunk_size;
+    size_t allocated;
+} tm_arena;
+
+tm_arena* tm_arena_new(size_t chunk_size);
+void* tm_arena_alloc(tm_arena* arena, size_t size);
+int tm_arena_delete(tm_arena* arena);
+
+#endif //TOYMC_ARENA_H
@@ -1,17 +1,109 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdarg.h>
 #include <assert.h>
 
 #include "errors.h"
 
-int DEBUG_LVL = 0;
+#define TM_LOG_BUFFER_SIZE 4096
+
+int tm_debug_level = 0;
+
+/* Each thread formats its messages in its own buffer, which is then written at once (so that messages of different
+ * threads never interleave). Debug messages stay in the buffer until it is full or flushed, so that threads do not
+ * compete for the stream each time.
+ */
+static __thread char log_buffer[TM_LOG_BUFFER_SIZE];
+static __thread size_t log_length = 0;
+static __thread FILE* log_stream = NULL;
+static int log_atexit = 0;
 
 void tm_set_debug_level(int level) {
-    DEBUG_LVL = level;
+    __atomic_store_n(&tm_debug_level, level, __ATOMIC_RELAXED);
+}
+
+/**
+ * Write the pending messages of the calling thread.
+ * Must be called by a thread before it exits (it is done automatically for the main thread).
+ */
+void tm_log_flush() {
+    if(log_length > 0 && log_stream != NULL) {
+        fwrite(log_buffer, 1, log_length, log_stream);
+        fflush(log_stream);
+    }
+
+    log_length = 0;
+}
+
+static void log_exit() {
+    tm_log_flush();
+}
+
+/**
+ * Format a message as \p "LEVEL (file:line) :: message suffix\\n" in the buffer of the calling thread.
+ * Messages that do not fit in the buffer are truncated.
+ * @pre \code{.c}
+ * stream != NULL && level != NULL && file != NULL && format != NULL
+ * \endcode
+ * @param stream where the message should be written
+ * @param flush if not 0, the message (and any pending one) is written immediately
+ * @param level level of the message (e.g., \p "DEBUG")
+ * @param file source file (use \p __FILE__ )
+ * @param line line (use \p __LINE__)
+ * @param suffix extra string after the message (may be \p NULL)
+ * @param format format of the string
+ * @param args extra parameters
+ */
+void tm_log_vwrite(FILE* stream, int flush, char* level, char* file, int line, char* suffix, char* format, va_list args) {
+    assert(stream != NULL && level != NULL && file != NULL && format != NULL);
+
+    if(!__atomic_exchange_n(&log_atexit, 1, __ATOMIC_RELAXED))
+        atexit(log_exit);
+
+    if(log_stream != stream) {
+        tm_log_flush();
+        log_stream = stream;
+    }
+
+    for(int attempt=0; attempt < 2; attempt++) {
+        size_t available = TM_LOG_BUFFER_SIZE - log_length, length = 0;
+        char* start = log_buffer + log_length;
+        va_list args_copy;
+        int r;
+
+        r = snprintf(start, available, "%s (%s:%d) :: ", level, file, line);
+        length += r > 0 ? r : 0;
+
+        if(length < available) {
+            va_copy(args_copy, args);
+            r = vsnprintf(start + length, available - length, format, args_copy);
+            va_end(args_copy);
+            length += r > 0 ? r : 0;
+        }
+
+        if(length < available)
+            length += snprintf(start + length, available - length, "%s\n", suffix != NULL ? suffix : "");
+
+        if(length < available) { // it fits
+            log_length += length;
+            break;
+        } else if(log_length > 0) { // make some room, then retry
+            tm_log_flush();
+        } else { // too long anyway: truncate
+            log_buffer[TM_LOG_BUFFER_SIZE - 2] = '\n';
+            log_length = TM_LOG_BUFFER_SIZE - 1;
+            break;
+        }
+    }
+
+    if(flush)
+        tm_log_flush();
 }
 
 /**
- * Print a debug message in \p stdout, if \p DEBUG_LVL is above 0.
+ * Print a debug message in \p stdout, if \p tm_debug_level is above 0.
+ * Prefer the \p TM_DEBUG() macro, which does not evaluate the arguments otherwise.
  * @pre \code{.c}
  * file != NULL && format != NULL
  * \endcode
@@ -23,16 +115,14 @@ void tm_set_debug_level(int level) {
 void tm_print_debug_msg(char *file, int line, char *format, ...) {
     assert(file != NULL && format != NULL);
 
-    if(DEBUG_LVL < 1)
+    if(__atomic_load_n(&tm_debug_level, __ATOMIC_RELAXED) < 1)
         return;
 
     va_list arglist;
 
-    printf("DEBUG (%s:%d) :: ", file, line);
     va_start(arglist, format);
-    vprintf(format, arglist);
+    tm_log_vwrite(stdout, 0, "DEBUG", file, line, NULL, format, arglist);
     va_end(arglist);
-    printf("\n");
 }
 
 /**
@@ -50,11 +140,9 @@ void tm_print_warning_msg(char *file, int line, char *format, ...) {
 
     va_list arglist;
 
-    printf("WARNING (%s:%d) :: ", file, line);
     va_start(arglist, format);
-    vprintf(format, arglist);
+    tm_log_vwrite(stdout, 1, "WARNING", file, line, NULL, format, arglist);
     va_end(arglist);
-    printf("\n");
 }
 
 /**
@@ -72,11 +160,9 @@ void tm_print_error_msg(char *file, int line, char *format, ...) {
 
     va_list arglist;
 
-    fprintf(stderr, "ERROR (%s:%d) :: ", file, line);
     va_start(arglist, format);
-    vfprintf(stderr, format, arglist);
+    tm_log_vwrite(stderr, 1, "ERROR", file, line, NULL, format, arglist);
     va_end(arglist);
-    fprintf(stderr, "\n");
 }
 
 /**
@@ -92,7 +178,7 @@ void tm_print_error_code(char* file, int line, int errcode) {
     assert(file != NULL);
 
     if(errcode < 0 || errcode >= TM_ERR_LAST)
-        tm_print_error_msg(__FILE__, __LINE__, "errcode %d (thrown from %d:%d) is unknown", errcode, file, line);
+        tm_print_error_msg(__FILE__, __LINE__, "errcode %d (thrown from %s:%d) is unknown", errcode, file, line);
     else
-        tm_print_error_msg(file, line, ERROR_EXPLS[errcode]);
+        tm_print_error_msg(file, line, "%s", ERROR_EXPLS[errcode]);
 }
@@ -5,12 +5,16 @@
 #ifndef TOYMC_ERRORS_H
 #define TOYMC_ERRORS_H
 
+#include <stdio.h>
+#include <stdarg.h>
+
 enum {
     TM_ERR_OK,
 
     // unexpected
     TM_ERR_MALLOC,
     TM_ERR_READ,
+    TM_ERR_WRITE,
     TM_ERR_NOT_FOUND,
 
     // module
@@ -18,6 +22,7 @@ enum {
     TM_ERR_PARAMETER_FILE,
     TM_ERR_SIMULATION_PARAMETERS,
     TM_ERR_XYZ,
+    TM_ERR_GEOMETRY,
 
     TM_ERR_LAST
 };
@@ -27,17 +32,56 @@ static char* ERROR_EXPLS[] = {
 
         "malloc() failed",
         "Error while reading file",
+        "Error while writing file",
         "Not found",
 
         "Error in lexer",
         "Error in parameter file",
         "Error in simulation parameter",
         "Error in xyz",
+        "Error in geometry",
 
         "Not an error (LAST)"
 };
 
+// log levels
+#define TM_LOG_LEVEL_ERROR 0
+#define TM_LOG_LEVEL_WARNING 1
+#define TM_LOG_LEVEL_DEBUG 2
+
+/* Messages above `TM_LOG_LEVEL` are not compiled at all.
+ * By default, debug messages are only compiled without `NDEBUG`.
+ */
+#ifndef TM_LOG_LEVEL
+#ifdef NDEBUG
+#define TM_LOG_LEVEL TM_LOG_LEVEL_WARNING
+#else
+#define TM_LOG_LEVEL TM_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+extern int tm_debug_level;
+
+/* Use these macros rather than the functions: arguments are not evaluated if the message is not printed.
+ * When compiled out, the call is kept behind `if(0)`, so that arguments are still type-checked (but no code is generated).
+ */
+#if TM_LOG_LEVEL >= TM_LOG_LEVEL_DEBUG
+#define TM_DEBUG(...) do { if(__atomic_load_n(&tm_debug_level, __ATOMIC_RELAXED) > 0) tm_print_debug_msg(__FILE__, __LINE__, __VA_ARGS__); } while(0)
+#else
+#define TM_DEBUG(...) do { if(0) tm_print_debug_msg(__FILE__, __LINE__, __VA_ARGS__); } while(0)
+#endif
+
+#if TM_LOG_LEVEL >= TM_LOG_LEVEL_WARNING
+#define TM_WARNING(...) tm_print_warning_msg(__FILE__, __LINE__, __VA_ARGS__)
+#else
+#define TM_WARNING(...) do { if(0) tm_print_warning_msg(__FILE__, __LINE__, __VA_ARGS__); } while(0)
+#endif
+
+#define TM_ERROR(...) tm_print_error_msg(__FILE__, __LINE__, __VA_ARGS__)
+
 void tm_set_debug_level(int level);
+void tm_log_vwrite(FILE* stream, int flush, char* level, char* file, int line, char* suffix, char* format, va_list args);
+void tm_log_flush();
 void tm_print_debug_msg(char* file, int line, char* format, ...);
 void tm_print_warning_msg(char *file, int line, char *format, ...);
 void tm_print_error_msg(char* file, int line, char* format, ...);
@@ -1,14 +1,16 @@
 #include "files.h"
+#include "memory.h"
 #include "errors.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 /**
  * Read the whole file in one shot.
  * @param f an open file
  * @param buffer pointer to the buffer
- * @post \p *buffer contains the content of the file, caller is responsible to free it.
+ * @post \p *buffer contains the content of the file, caller is responsible to free it (with tm_free()).
  * @return  \p TM_ERR_OK if everything was ok, something else otherwise.
  */
 int tm_read_file(FILE *f, char **buffer) {
@@ -20,14 +22,14 @@ int tm_read_file(FILE *f, char **buffer) {
     fseek(f, 0, SEEK_SET);
 
     // allocate
-    *buffer = malloc((length + 1) * sizeof (char));
+    *buffer = tm_malloc((length + 1) * sizeof (char), TM_MEM_IO);
 
     if(*buffer == NULL)
         return TM_ERR_MALLOC;
 
     // read
     if(fread(*buffer, 1, length, f) != length) {
-        free(*buffer);
+        tm_free(*buffer);
         return TM_ERR_READ;
     }
 
@@ -35,3 +37,47 @@ int tm_read_file(FILE *f, char **buffer) {
 
     return TM_ERR_OK;
 }
+
+/**
+ * Read a line (including the final \p '\\n', if any) and append it to \p buffer, which grows if needed.
+ * @pre \code{.c}
+ * f != NULL && buffer != NULL && size != NULL && length != NULL
+ * && (*buffer == NULL || *length < *size)
+ * \endcode
+ * @param f an open file
+ * @param buffer pointer to the buffer (may point to \p NULL, otherwise allocated with tm_malloc()), caller is responsible to free it (with tm_free())
+ * @param size (input/output) allocated size of the buffer
+ * @param length (input/output) length of the content of the buffer
+ * @post the line is appended to \p *buffer, which is NUL-terminated, and \p *length is updated.
+ * @return \p TM_ERR_OK if a line was read, \p TM_ERR_NOT_FOUND if the end of file was reached before reading
+ * anything, something else otherwise.
+ */
+int tm_read_line(FILE* f, char** buffer, size_t* size, size_t* length) {
+    assert(f != NULL && buffer != NULL && size != NULL && length != NULL);
+
+    size_t start = *length;
+
+    do {
+        // make room
+        if(*buffer == NULL || *size - *length < 2) {
+            size_t new_size = *size < 64 ? 128 : 2 * *size;
+            char* new_buffer = tm_realloc(*buffer, new_size * sizeof(char), TM_MEM_IO);
+            if(new_buffer == NULL)
+                return TM_ERR_MALLOC;
+
+            *buffer = new_buffer;
+            *size = new_size;
+        }
+
+        (*buffer)[*length] = '\0';
+        if(fgets(*buffer + *length, (int) (*size - *length), f) == NULL)
+            break;
+
+        *length += strlen(*buffer + *length);
+    } while((*buffer)[*length - 1] != '\n');
+
+    if(ferror(f))
+        return TM_ERR_READ;
+
+    return *length == start ? TM_ERR_NOT_FOUND : TM_ERR_OK;
+}
@@ -4,5 +4,6 @@
 #include <stdio.h>
 
 int tm_read_file(FILE* f, char** buffer);
+int tm_read_line(FILE* f, char** buffer, size_t* size, size_t* length);
 
 #endif //TOYMC_FILES_H
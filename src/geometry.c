@@ -1,10 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "geometry.h"
+#include "memory.h"
 #include "errors.h"
 
+// initial number of slots in the type hash table (must be a power of 2)
+#define TM_GEOMETRY_TYPE_HASH_INIT 16
+
 /**
  * Create a new geometry
  * @param N number of atoms
@@ -15,31 +20,41 @@ tm_geometry *tm_geometry_new(long N) {
         return NULL;
 
     // create
-    tm_geometry* g = malloc(sizeof(tm_geometry));
+    tm_geometry* g = tm_malloc(sizeof(tm_geometry), TM_MEM_GEOMETRY);
     if (g == NULL)
         return NULL;
 
     // assign
     g->N = N;
+    g->stride = TM_MEMORY_PADDED(N);
     g->positions = NULL;
     g->types = NULL;
     g->type_vals = NULL;
+    g->N_types = 0;
+    g->type_hash = NULL;
+    g->type_hash_size = TM_GEOMETRY_TYPE_HASH_INIT;
 
     // fill
-    g->positions = malloc(3 * N * sizeof(double));
+    g->positions = tm_calloc_aligned(3 * g->stride, sizeof(double), TM_MEM_GEOMETRY);
     if(g->positions == NULL) {
         tm_geometry_delete(g);
         return NULL;
     }
 
-    g->types = malloc(N * sizeof(int));
-    if (g->positions == NULL) {
+    g->types = tm_malloc(N * sizeof(tm_type_id), TM_MEM_GEOMETRY);
+    if (g->types == NULL) {
+        tm_geometry_delete(g);
+        return NULL;
+    }
+
+    g->type_vals = tm_calloc(g->type_hash_size / 2, sizeof(char*), TM_MEM_GEOMETRY);
+    if (g->type_vals == NULL) {
         tm_geometry_delete(g);
         return NULL;
     }
 
-    g->type_vals = calloc(N, sizeof(char*));
-    if (g->positions == NULL) {
+    g->type_hash = tm_calloc(g->type_hash_size, sizeof(uint8_t), TM_MEM_GEOMETRY);
+    if (g->type_hash == NULL) {
         tm_geometry_delete(g);
         return NULL;
     }
@@ -47,6 +62,41 @@ tm_geometry *tm_geometry_new(long N) {
     return g;
 }
 
+/**
+ * Change the number of atoms of \p geometry. Positions and types are \b not kept, but the types table is.
+ * @pre \code{.c}
+ * geometry != NULL && N >= 0
+ * \endcode
+ * @param geometry the geometry
+ * @param N new number of atoms
+ * @post \p geometry->N is \p N, and the positions and types are allocated accordingly.
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+int tm_geometry_resize(tm_geometry *geometry, long N) {
+    assert(geometry != NULL && N >= 0);
+
+    // (aligned blocks cannot be reallocated, but the padding often leaves room for the new atoms)
+    long stride = TM_MEMORY_PADDED(N);
+    if(stride != geometry->stride) {
+        double* positions = tm_calloc_aligned(3 * stride, sizeof(double), TM_MEM_GEOMETRY);
+        if(positions == NULL)
+            return TM_ERR_MALLOC;
+
+        tm_free(geometry->positions);
+        geometry->positions = positions;
+        geometry->stride = stride;
+    }
+
+    tm_type_id* types = tm_realloc(geometry->types, N * sizeof(tm_type_id), TM_MEM_GEOMETRY);
+    if(types == NULL)
+        return TM_ERR_MALLOC;
+
+    geometry->types = types;
+    geometry->N = N;
+
+    return TM_ERR_OK;
+}
+
 /**
  * Get a given atom, stored in \p geometry
  * @pre \code{.c}
@@ -64,9 +114,9 @@ int tm_geometry_get_atom(tm_geometry *geometry, int n, int *type, double **posit
     assert(n >= 0 && n < geometry->N);
 
     *type = geometry->types[n];
-    (*position)[0] = geometry->positions[0 * geometry->N * n];
-    (*position)[1] = geometry->positions[1 * geometry->N * n];
-    (*position)[2] = geometry->positions[2 * geometry->N * n];
+    (*position)[0] = geometry->positions[0 * geometry->stride + n];
+    (*position)[1] = geometry->positions[1 * geometry->stride + n];
+    (*position)[2] = geometry->positions[2 * geometry->stride + n];
 
     return TM_ERR_OK;
 }
@@ -81,18 +131,164 @@ int tm_geometry_delete(tm_geometry *geometry) {
     assert(geometry != NULL);
 
     if(geometry->positions != NULL)
-        free(geometry->positions);
+        tm_free(geometry->positions);
 
     if(geometry->type_vals != NULL) {
-        for(int i = 0; i < geometry->N && geometry->type_vals[i] != NULL; i++) {
-            free(geometry->type_vals[i]);
+        for(int i = 0; i < geometry->N_types; i++) {
+            tm_free(geometry->type_vals[i]);
         }
-        free(geometry->type_vals);
+        tm_free(geometry->type_vals);
     }
 
     if(geometry->types != NULL)
-        free(geometry->types);
+        tm_free(geometry->types);
+
+    if(geometry->type_hash != NULL)
+        tm_free(geometry->type_hash);
+
+    tm_free(geometry);
+    return TM_ERR_OK;
+}
+
+/**
+ * Hash (FNV-1a) of a type name
+ * @param name the name (not necessarily NUL-terminated)
+ * @param len length of the name
+ * @return the hash
+ */
+static uint32_t geometry_type_hash(char* name, size_t len) {
+    uint32_t h = 2166136261u;
+    for(size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) name[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+/**
+ * Find the slot of the hash table that contains type \p name, or the empty slot where it should be inserted.
+ * @param geometry the geometry
+ * @param name the name (not necessarily NUL-terminated)
+ * @param len length of the name
+ * @return the slot
+ */
+static int geometry_type_slot(tm_geometry* geometry, char* name, size_t len) {
+    int mask = geometry->type_hash_size - 1;
+    int slot = (int) (geometry_type_hash(name, len) & (uint32_t) mask);
+    char* val;
+
+    while(geometry->type_hash[slot] != 0) {
+        val = geometry->type_vals[geometry->type_hash[slot] - 1];
+        if(strncmp(val, name, len) == 0 && val[len] == '\0')
+            break;
+
+        slot = (slot + 1) & mask; // linear probing
+    }
+
+    return slot;
+}
+
+/**
+ * Double the size of the hash table (and the capacity of \p type_vals).
+ * @param geometry the geometry
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+static int geometry_type_grow(tm_geometry* geometry) {
+    int new_size = 2 * geometry->type_hash_size;
+
+    char** new_vals = tm_realloc(geometry->type_vals, (new_size / 2) * sizeof(char*), TM_MEM_GEOMETRY);
+    if(new_vals == NULL)
+        return TM_ERR_MALLOC;
+
+    geometry->type_vals = new_vals;
+
+    uint8_t* new_hash = tm_calloc(new_size, sizeof(uint8_t), TM_MEM_GEOMETRY);
+    if(new_hash == NULL)
+        return TM_ERR_MALLOC;
+
+    tm_free(geometry->type_hash);
+    geometry->type_hash = new_hash;
+    geometry->type_hash_size = new_size;
+
+    // re-insert
+    int slot;
+    for(int i = 0; i < geometry->N_types; i++) {
+        slot = geometry_type_slot(geometry, geometry->type_vals[i], strlen(geometry->type_vals[i]));
+        geometry->type_hash[slot] = (uint8_t) (i + 1);
+    }
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Find the id of type \p name.
+ * @pre \code{.c}
+ * geometry != NULL && name != NULL && id != NULL
+ * \endcode
+ * @param geometry the geometry
+ * @param name the name of the type (not necessarily NUL-terminated)
+ * @param len length of \p name
+ * @param id (output) the id of the type
+ * @post \p id is set, if found
+ * @return \p TM_ERR_OK if the type was found, \p TM_ERR_NOT_FOUND otherwise
+ */
+int tm_geometry_type_find(tm_geometry* geometry, char* name, size_t len, tm_type_id* id) {
+    assert(geometry != NULL && name != NULL && id != NULL);
+
+    int slot = geometry_type_slot(geometry, name, len);
+    if(geometry->type_hash[slot] == 0)
+        return TM_ERR_NOT_FOUND;
+
+    *id = (tm_type_id) (geometry->type_hash[slot] - 1);
+    return TM_ERR_OK;
+}
+
+/**
+ * Get the id of type \p name, and register it in \p type_vals (as a copy) if it does not exist yet.
+ * @pre \code{.c}
+ * geometry != NULL && name != NULL && id != NULL
+ * \endcode
+ * @param geometry the geometry
+ * @param name the name of the type (not necessarily NUL-terminated)
+ * @param len length of \p name
+ * @param id (output) the id of the type
+ * @post \p id is set
+ * @return \p TM_ERR_OK, \p TM_ERR_GEOMETRY if there is already \p TM_GEOMETRY_MAX_TYPES types,
+ * or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+int tm_geometry_type_intern(tm_geometry* geometry, char* name, size_t len, tm_type_id* id) {
+    assert(geometry != NULL && name != NULL && id != NULL);
+
+    int slot = geometry_type_slot(geometry, name, len);
+    if(geometry->type_hash[slot] != 0) {
+        *id = (tm_type_id) (geometry->type_hash[slot] - 1);
+        return TM_ERR_OK;
+    }
+
+    if(geometry->N_types == TM_GEOMETRY_MAX_TYPES)
+        return TM_ERR_GEOMETRY;
+
+    // keep the load factor below 1/2
+    if(2 * (geometry->N_types + 1) > geometry->type_hash_size) {
+        int r = geometry_type_grow(geometry);
+        if(r != TM_ERR_OK)
+            return r;
+
+        slot = geometry_type_slot(geometry, name, len);
+    }
+
+    char* val = tm_malloc((len + 1) * sizeof(char), TM_MEM_GEOMETRY);
+    if(val == NULL)
+        return TM_ERR_MALLOC;
+
+    memcpy(val, name, len);
+    val[len] = '\0';
+
+    geometry->type_vals[geometry->N_types] = val;
+    geometry->N_types++;
+    geometry->type_hash[slot] = (uint8_t) geometry->N_types;
 
-    free(geometry);
+    *id = (tm_type_id) (geometry->N_types - 1);
     return TM_ERR_OK;
 }
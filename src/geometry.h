@@ -1,24 +1,45 @@
 #ifndef TOYMC_GEOMETRY_H
 #define TOYMC_GEOMETRY_H
 
+#include <stdint.h>
+#include <stddef.h>
+
+#define TM_GEOMETRY_MAX_TYPES 255
+
+typedef uint8_t tm_type_id;
+
 /**
  * @brief Store the geometry, i.e., the position of each atoms
  * Fields are \code{.c}
- * int N; // number of atoms
- * float* positions; // positions, as array of size 3*N, {X, Y, Z} (each of size N)
- * int* types; // type of each atom, as array of size N
- * char** type_vals; // value of each type, as array of size N
+ * long N; // number of atoms
+ * long stride; // distance between the rows of positions (N, padded with TM_MEMORY_PADDED())
+ * double* positions; // positions, as array of size 3*stride, {X, Y, Z} (each of size N, then padding), aligned (see tm_calloc_aligned())
+ * tm_type_id* types; // type of each atom, as array of size N
+ * char** type_vals; // value of each type, as array of size N_types
+ * int N_types; // number of (distinct) types
+ * uint8_t* type_hash; // hash table of the types (slot is 0 if empty, type + 1 otherwise)
+ * int type_hash_size; // number of slots in the hash table (power of 2)
  * \endcode
  */
 typedef struct tm_geometry_ {
     long N;
-    double * positions;
-    int* types;
+    long stride;
+    double* positions;
+    tm_type_id* types;
     char** type_vals;
+
+    int N_types;
+    uint8_t* type_hash;
+    int type_hash_size;
 } tm_geometry;
 
 tm_geometry *tm_geometry_new(long N);
+int tm_geometry_resize(tm_geometry* geometry, long N);
 int tm_geometry_get_atom(tm_geometry* geometry, int n, int* type, double **position);
 int tm_geometry_delete(tm_geometry* geometry);
 
+// types
+int tm_geometry_type_find(tm_geometry* geometry, char* name, size_t len, tm_type_id* id);
+int tm_geometry_type_intern(tm_geometry* geometry, char* name, size_t len, tm_type_id* id);
+
 #endif //TOYMC_GEOMETRY_H
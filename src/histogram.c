@@ -0,0 +1,188 @@
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include "histogram.h"
+#include "memory.h"
+#include "errors.h"
+
+/* Small values get their own bucket, then the bucket is given by the position of the most significant bit and the
+ * TM_HISTOGRAM_SUB_BITS bits that follow.
+ */
+static int histogram_bucket(uint64_t value) {
+    if(value < TM_HISTOGRAM_SUB)
+        return (int) value;
+
+    int shift = 63 - __builtin_clzll(value) - TM_HISTOGRAM_SUB_BITS;
+    return (shift + 1) * TM_HISTOGRAM_SUB + (int) ((value >> shift) - TM_HISTOGRAM_SUB);
+}
+
+// largest value that falls in a bucket
+static uint64_t histogram_bucket_upper(int bucket) {
+    if(bucket < TM_HISTOGRAM_SUB)
+        return (uint64_t) bucket;
+
+    int shift = bucket / TM_HISTOGRAM_SUB - 1;
+    uint64_t mantissa = (uint64_t) (bucket % TM_HISTOGRAM_SUB + TM_HISTOGRAM_SUB);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * Create an empty histogram.
+ * @return a new histogram, \p NULL if \p malloc failed
+ */
+tm_histogram* tm_histogram_new() {
+    tm_histogram* histogram = tm_malloc(sizeof(tm_histogram), TM_MEM_INSTRUMENTATION);
+
+    if(histogram != NULL)
+        tm_histogram_reset(histogram);
+
+    return histogram;
+}
+
+/**
+ * Record a value.
+ * @pre \code{.c}
+ * histogram != NULL
+ * \endcode
+ * @param histogram the histogram
+ * @param value the value
+ */
+void tm_histogram_record(tm_histogram* histogram, uint64_t value) {
+    assert(histogram != NULL);
+
+    histogram->counts[histogram_bucket(value)]++;
+    histogram->N++;
+    histogram->sum += (double) value;
+
+    if(value < histogram->min)
+        histogram->min = value;
+    if(value > histogram->max)
+        histogram->max = value;
+}
+
+/**
+ * Get the value below which (at least) a given percentage of the values fall.
+ * The result is the upper bound of the corresponding bucket (but never more than the largest value).
+ * @pre \code{.c}
+ * histogram != NULL && percentile >= 0 && percentile <= 100
+ * \endcode
+ * @param histogram the histogram
+ * @param percentile the percentile (e.g., 99.9)
+ * @return the value, 0 if the histogram is empty
+ */
+uint64_t tm_histogram_percentile(tm_histogram* histogram, double percentile) {
+    assert(histogram != NULL && percentile >= 0 && percentile <= 100);
+
+    if(histogram->N == 0)
+        return 0;
+
+    uint64_t target = (uint64_t) ceil(percentile / 100 * (double) histogram->N), cumulated = 0;
+    if(target < 1)
+        target = 1;
+
+    for(int i=0; i < TM_HISTOGRAM_N_BUCKETS; i++) {
+        cumulated += histogram->counts[i];
+        if(cumulated >= target) {
+            uint64_t upper = histogram_bucket_upper(i);
+            return upper < histogram->max ? upper : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+/**
+ * Add the values of a histogram to another.
+ * @pre \code{.c}
+ * dest != NULL && src != NULL
+ * \endcode
+ * @param dest the histogram to which values are added
+ * @param src the histogram from which values are taken (it is not modified)
+ * @return \p TM_ERR_OK
+ */
+int tm_histogram_merge(tm_histogram* dest, tm_histogram* src) {
+    assert(dest != NULL && src != NULL);
+
+    for(int i=0; i < TM_HISTOGRAM_N_BUCKETS; i++)
+        dest->counts[i] += src->counts[i];
+
+    dest->N += src->N;
+    dest->sum += src->sum;
+
+    if(src->min < dest->min)
+        dest->min = src->min;
+    if(src->max > dest->max)
+        dest->max = src->max;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Remove all values.
+ * @pre \code{.c}
+ * histogram != NULL
+ * \endcode
+ * @param histogram the histogram
+ * @return \p TM_ERR_OK
+ */
+int tm_histogram_reset(tm_histogram* histogram) {
+    assert(histogram != NULL);
+
+    for(int i=0; i < TM_HISTOGRAM_N_BUCKETS; i++)
+        histogram->counts[i] = 0;
+
+    histogram->N = 0;
+    histogram->min = UINT64_MAX;
+    histogram->max = 0;
+    histogram->sum = 0;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Print a summary of the histogram: number of values, mean, min, p50, p99, p99.9 and max.
+ * @pre \code{.c}
+ * histogram != NULL && f != NULL && name != NULL && ticks_per_us > 0
+ * \endcode
+ * @param histogram the histogram, with values in ticks
+ * @param f where to print
+ * @param name name of the histogram
+ * @param ticks_per_us ticks per microsecond, to convert the values (see timer_ticks_per_us())
+ * @return \p TM_ERR_OK
+ */
+int tm_histogram_print(tm_histogram* histogram, FILE* f, char* name, double ticks_per_us) {
+    assert(histogram != NULL && f != NULL && name != NULL && ticks_per_us > 0);
+
+    if(histogram->N == 0) {
+        fprintf(f, "%s: no value\n", name);
+        return TM_ERR_OK;
+    }
+
+    fprintf(f, "%s: N=%lu, mean=%.3f, min=%.3f, p50=%.3f, p99=%.3f, p99.9=%.3f, max=%.3f (us)\n",
+            name,
+            (unsigned long) histogram->N,
+            histogram->sum / (double) histogram->N / ticks_per_us,
+            (double) histogram->min / ticks_per_us,
+            (double) tm_histogram_percentile(histogram, 50) / ticks_per_us,
+            (double) tm_histogram_percentile(histogram, 99) / ticks_per_us,
+            (double) tm_histogram_percentile(histogram, 99.9) / ticks_per_us,
+            (double) histogram->max / ticks_per_us);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Delete a histogram.
+ * @pre \code{.c}
+ * histogram != NULL
+ * \endcode
+ * @param histogram the histogram
+ * @return \p TM_ERR_OK
+ */
+int tm_histogram_delete(tm_histogram* histogram) {
+    assert(histogram != NULL);
+
+    tm_free(histogram);
+    return TM_ERR_OK;
+}
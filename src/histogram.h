@@ -0,0 +1,39 @@
+#ifndef TOYMC_HISTOGRAM_H
+#define TOYMC_HISTOGRAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// each power of two is split in 2^TM_HISTOGRAM_SUB_BITS buckets, so values are known within 1/32 (~3%)
+#define TM_HISTOGRAM_SUB_BITS 5
+#define TM_HISTOGRAM_SUB (1 << TM_HISTOGRAM_SUB_BITS)
+#define TM_HISTOGRAM_N_BUCKETS ((64 - TM_HISTOGRAM_SUB_BITS + 1) * TM_HISTOGRAM_SUB)
+
+/**
+ * @brief Histogram of (positive integer) values with logarithmic buckets, HDR-style
+ * (i.e., the relative error on a value is bounded).
+ * Fields are \code{.c}
+ * uint64_t counts[TM_HISTOGRAM_N_BUCKETS]; // number of values in each bucket
+ * uint64_t N; // number of values
+ * uint64_t min; // smallest value
+ * uint64_t max; // largest value
+ * double sum; // sum of the values
+ * \endcode
+ */
+typedef struct tm_histogram_ {
+    uint64_t counts[TM_HISTOGRAM_N_BUCKETS];
+    uint64_t N;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} tm_histogram;
+
+tm_histogram* tm_histogram_new();
+void tm_histogram_record(tm_histogram* histogram, uint64_t value);
+uint64_t tm_histogram_percentile(tm_histogram* histogram, double percentile);
+int tm_histogram_merge(tm_histogram* dest, tm_histogram* src);
+int tm_histogram_reset(tm_histogram* histogram);
+int tm_histogram_print(tm_histogram* histogram, FILE* f, char* name, double ticks_per_us);
+int tm_histogram_delete(tm_histogram* histogram);
+
+#endif //TOYMC_HISTOGRAM_H
@@ -180,15 +180,12 @@ void tm_print_error_msg_with_token(char *file, int line, tm_parf_token* tk, char
 
     va_list arglist;
 
-    char buff[24];
-
-    fprintf(stderr, "ERROR (%s:%d) :: ", file, line);
+    char buff[24], suffix[128];
 
     sprintf(buff, isgraph(*(tk->value)) ? "`%c`": "0x%x", *(tk->value));
+    snprintf(suffix, 128, " (from token@%d:%d = {type=%d, value=%s})", tk->line, tk->pos_in_line, tk->type, buff);
 
     va_start(arglist, format);
-    vfprintf(stderr, format, arglist);
+    tm_log_vwrite(stderr, 1, "ERROR", file, line, suffix, format, arglist);
     va_end(arglist);
-    fprintf(stderr, " (from token@%d:%d = {type=%d, value=%s})", tk->line, tk->pos_in_line, tk->type, buff);
-    fprintf(stderr, "\n");
 }
@@ -1,99 +1,34 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include "timer.h"
+#include <time.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "errors.h"
+#include "mc.h"
+#include "pcg32.h"
+#include "profile.h"
+#include "histogram.h"
+#include "timer.h"
+#include "status.h"
+#include "memory.h"
+#include "observables.h"
+#include "geometry.h"
+#include "xyz_writer.h"
+#include "simulation_parameters.h"
 
-int init_positions(double* positions, int N, double L) {
-    int ppL = (int) ceil(pow(N, 1./3));
-    double dist = L / ppL;
-    printf("ppL = %d, dist = %f\n", ppL, dist);
-    int x, y = 0, z = 0;
-    
-    for(int i=0; i < N; i++) {
-        if(i != 0 && (i % (ppL * ppL) == 0)) {
-            z += 1;
-            x = y = 0;
-        } else if (i != 0 && (i % ppL == 0)) {
-            y += 1;
-            x = 0;
-        } else {
-            x = i % ppL;
-        }
-        
-        positions[0 * N + i] = x * dist;
-        positions[1 * N + i] = y * dist;
-        positions[2 * N + i] = z * dist;
-    }
-}
-
-void compute_LJ(double r2, double rc2, double* U, double* vir) {
-    if (r2 < rc2) {
-        double r6i = 1. / (r2 * r2 * r2);
-        *U += 4. * (r6i * (r6i - 1));
-        *vir += 16. * (r6i * (r6i - .5));
-    }
-}
-
-double rnd() { // yeah, it is bad, I know
-    return ((double) rand()) / RAND_MAX;
-}
-
-void compute_Ui(double* positions, int N, double L, int i, double rc2, double* U_i, double* vir_i) {
-    double Ui = .0f, hL = L/2, q, dq;
-    double* restrict q1;
-    
-    for(int j=0; j < N; j++)
-        positions[3 * N + j] = .0; 
-
-    for(int k=0; k < 3; k++) {
-        q1 = positions + k * N;
-        #pragma omp for simd
-        for(int j=0; j < N; j++) {
-            dq = *(q1 + j) - *(q1 + i);
-            dq += (dq>hL) * (-L) + (dq<-hL) * L;
-            positions[3 * N + j] += dq * dq;
-        }
-    }
-    
-    for(int j=0; j < N; j++) {
-        if (j != i)
-            compute_LJ(positions[3 * N + j], rc2, U_i, vir_i);
-    }
-}
-
-void compute_U(double* positions, int N, double L, double rc2, double* U, double* vir) {
-    double q, dq, hL = L / 2;
-    double* restrict q1;
-    *U = 0;
-    *vir = 0;
-    
-    for(int i=0; i < N - 1; i++) {
-        for(int j=i + 1; j < N; j++)
-            positions[3 * N + j] = .0; 
-
-        for(int k=0; k < 3; k++) {
-            q1 = positions + k * N;
-            #pragma omp for simd
-            for(int j=i+1; j < N; j++) {
-                dq = *(q1 + j) - *(q1 + i);
-                dq += (dq>hL) * (-L) + (dq<-hL) * L;
-                positions[3 * N + j] += dq * dq;
-            }
-        }
-        
-        for(int j=i + 1; j < N; j++) {
-            compute_LJ(positions[3 * N + j], rc2, U, vir);
-        }
-    }
-}
 
 int main(int argc, char* argv[]) {
-    double rho = 0.8, rc= 4.f, *positions = NULL, U = .0, vir=.0, delta=0.1f, U_old, U_new, vir_old, vir_new, p_old[3], p_new[3], T=0.9, e;
-    int N = 512, trials=100, accepted=0;
+    double rho = 0.8, rc= 4.f, delta=0.1f, T=0.9;
+    int N = 512, trials=100;
     int seed = time(NULL);
     char* out = "out.xyz";
+    char* trace = NULL;
+    char* status_path = NULL;
+    char* observables_path = NULL;
+    char* parameters_path = NULL;
+    int profile = 0, counters = 0, latency = 0, memory = 0;
     
     // read args
     if(argc > 1) {
@@ -164,82 +99,298 @@ int main(int argc, char* argv[]) {
                 } else {
                     out = argv[i + 1];
                 }
+            } else if(strcmp(argv[i], "-p") == 0) { // print a summary of the profiling regions at the end
+                profile = 1;
+            } else if(strcmp(argv[i], "-S") == 0) {
+                if((i+1) == argc) { // `-S`, but nothing!
+                    return -1;
+                } else {
+                    status_path = argv[i + 1]; // serve the status of the run on this Unix socket
+                }
+            } else if(strcmp(argv[i], "-O") == 0) {
+                if((i+1) == argc) { // `-O`, but nothing!
+                    return -1;
+                } else {
+                    observables_path = argv[i + 1]; // CSV if the extension is `.csv`, binary otherwise
+                }
+            } else if(strcmp(argv[i], "-F") == 0) {
+                if((i+1) == argc) { // `-F`, but nothing!
+                    return -1;
+                } else {
+                    parameters_path = argv[i + 1]; // read the species from a parameter file
+                }
+            } else if(strcmp(argv[i], "-m") == 0) { // memory statistics at the end
+                memory = 1;
+            } else if(strcmp(argv[i], "-l") == 0) { // latency of moves and sweeps
+                latency = 1;
+            } else if(strcmp(argv[i], "-c") == 0) { // ... with hardware counters
+                profile = 1;
+                counters = 1;
+            } else if(strcmp(argv[i], "-t") == 0) {
+                if((i+1) == argc) { // `-t`, but nothing!
+                    return -1;
+                } else {
+                    profile = 1;
+                    trace = argv[i + 1];
+                }
             }
         }
     }
     
-    srand(seed);
+    // only the outer regions (run, setup, sweeps, I/O) are traced, to keep the trace small
+    if(profile && tm_profile_init(trace != NULL ? 2 : 0) != TM_ERR_OK) {
+        printf("cannot allocate the trace :(");
+        return EXIT_FAILURE;
+    }
+    
+    // counters are only read around the outer regions, since it requires system calls
+    if(counters && tm_profile_use_counters(2) != TM_ERR_OK)
+        printf("hardware counters are not available\n");
+    
+    TM_PROFILE_BEGIN(TM_REGION_RUN);
+    
+    pcg32_init(seed);
     printf("seed = %d\n", seed);
     
-    // prepare box
-    double V = N / rho;
-    double L = pow(V, 1./3);
+    // species
+    tm_simulation_parameters* parameters = tm_simulation_parameters_new();
+    if(parameters == NULL) {
+        printf("cannot allocate parameters :(");
+        return EXIT_FAILURE;
+    }
     
-    printf("rho = %.3f, box volume = %.3f\nbox length = %.3f\n", rho, V, L); 
+    if(parameters_path != NULL) {
+        FILE* f = fopen(parameters_path, "r");
+        if(f == NULL) {
+            printf("error while opening %s\n", parameters_path);
+            return EXIT_FAILURE;
+        }
+        
+        int err = tm_simulation_parameters_read(parameters, f);
+        fclose(f);
+        
+        if(err != TM_ERR_OK) {
+            tm_print_error_code(__FILE__, __LINE__, err);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    // prepare box
+    tm_mc* mc;
+    if(parameters->N_species > 0) {
+        N = 0;
+        for(int t=0; t < parameters->N_species; t++) {
+            printf("species %s: %ld atoms, epsilon = %.3f, sigma = %.3f\n", parameters->species[t], parameters->composition[t], parameters->epsilon[t], parameters->sigma[t]);
+            N += parameters->composition[t];
+        }
+        
+        mc = tm_mc_new_mixture(
+                parameters->N_species, parameters->composition, parameters->epsilon, parameters->sigma,
+                parameters->mixing_rule, rho, T, rc, delta, parameters->sort_species);
+    } else {
+        mc = tm_mc_new(N, rho, T, rc, delta);
+    }
     
-    positions = malloc(4 * N * sizeof(double));
-    if (positions == NULL) {
+    if (mc == NULL) {
         printf("cannot allocate positions :(");
         return EXIT_FAILURE;
     }
     
-    init_positions(positions, N, L);
+    if(parameters->potential != mc->coefs->potential)
+        tm_mc_use_potential(mc, parameters->potential, parameters->potential_alpha);
     
-    // compute tail correction
+    if(parameters->box_length[0] != parameters->box_length[1] || parameters->box_length[0] != parameters->box_length[2])
+        tm_mc_set_box(mc, parameters->box_length);
+    
+    printf("potential = %s\n", mc->coefs->potential->name);
+    printf("rho = %.3f, box volume = %.3f\nbox length = %.3f %.3f %.3f\n", rho, mc->V, mc->box[0], mc->box[1], mc->box[2]); 
     printf("rc = %.3f\n", rc);
-    double rc2 = rc * rc;
-    double irc3 = 1. / (rc * rc * rc);
-    double U_tail = N * 8. * M_PI * rho * (irc3 * (irc3 * irc3 / 9 - 1./3));
-    double P_tail = 16./3*M_PI*rho*rho*(irc3 * (2*irc3*irc3/3-1.));
-    printf("U_tail = %f, P_tail=%.3f\n", U_tail, P_tail);
+    printf("U_tail = %f, P_tail=%.3f\n", mc->U_tail, mc->P_tail);
     
     // compute the energy of that box
-    struct timespec t;
-    double time, total_time = 0;
+    printf("U = %.3f\n", tm_mc_energy(mc));
+    
+    // only the energy is tracked during the moves, the virial is computed when the pressure is sampled
+    long pressure_freq = parameters->pressure_freq;
+    if(pressure_freq < 1) {
+        printf("pressure_freq should be at least 1\n");
+        return EXIT_FAILURE;
+    }
+    
+    // observables are recorded every `print_freq` sweeps, and summarized on stdout about 10 times for the whole run
+    long print_freq = parameters->print_freq;
+    if(print_freq < 1) {
+        printf("print_freq should be at least 1\n");
+        return EXIT_FAILURE;
+    }
+    
+    tm_mc_select_kernels(mc, 0);
+    printf("pressure is sampled every %ld sweep(s)\n", pressure_freq);
+    
+    // atoms are reordered for locality, but written in their initial order
+    long reorder_freq = parameters->reorder_freq;
+    if(reorder_freq < 0) {
+        printf("reorder_freq should be positive\n");
+        return EXIT_FAILURE;
+    }
+    
+    if(reorder_freq > 0)
+        printf("atoms are reordered every %ld sweep(s)\n", reorder_freq);
+    
+    if(parameters->single_precision) {
+        if(tm_mc_use_single_precision(mc, 1) != TM_ERR_OK) {
+            printf("cannot allocate positions :(");
+            return EXIT_FAILURE;
+        }
+        
+        printf("distances are computed in single precision\n");
+    }
+    
+    if(parameters->fixed_point) {
+        if(tm_mc_use_fixed_point(mc, 1) != TM_ERR_OK) {
+            printf("cannot allocate positions :(");
+            return EXIT_FAILURE;
+        }
+        
+        printf("positions are stored in fixed point\n");
+    }
+    
+    // latency histograms: moves are reported for each interval, then for the whole run
+    tm_histogram *move_latency = NULL, *move_latency_total = NULL, *sweep_latency = NULL;
+    double ticks_per_us = 1.;
+    if(latency) {
+        move_latency = tm_histogram_new();
+        move_latency_total = tm_histogram_new();
+        sweep_latency = tm_histogram_new();
+        if(move_latency == NULL || move_latency_total == NULL || sweep_latency == NULL) {
+            printf("cannot allocate histograms :(");
+            return EXIT_FAILURE;
+        }
+        
+        mc->move_latency = move_latency;
+        mc->sweep_latency = sweep_latency;
+        ticks_per_us = timer_ticks_per_us(.01);
+    }
+    
+    // status endpoint
+    tm_status_server* status_server = NULL;
+    double P = tm_mc_pressure(mc);
+    tm_status status = {0, trials, 0, 0, 0, tm_mc_energy(mc), P};
+    struct timespec t_start;
+    
+    if(status_path != NULL) {
+        status_server = tm_status_server_new(status_path);
+        if(status_server == NULL) {
+            printf("cannot serve status on %s\n", status_path);
+            return EXIT_FAILURE;
+        }
+        
+        tm_status_server_publish(status_server, &status);
+    }
     
-    compute_U(positions, N, L, rc2, &U, &vir);
-    printf("U = %.3f\n", U + U_tail);
+    // observables
+    tm_observables_sink* sink = NULL;
+    if(observables_path != NULL) {
+        size_t length = strlen(observables_path);
+        tm_observables_format format = TM_OBSERVABLES_BINARY;
+        if(length > 4 && strcmp(observables_path + length - 4, ".csv") == 0)
+            format = TM_OBSERVABLES_CSV;
+        
+        sink = tm_observables_sink_new(observables_path, format);
+        if(sink == NULL) {
+            printf("error while opening %s\n", observables_path);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    // a multiple of `print_freq`, so that each summary is also a record
+    long summary_freq = trials / 10 > print_freq ? trials / 10 / print_freq * print_freq : print_freq;
+    
+    long summary_moves = 0, summary_accepted = 0;
+    
+    timer_start(&t_start);
     
     // iterate through the thing
-    double sq_delta = delta / pow(3, .5);
-    printf("delta = %.3f, sq_delta = %.3f\n", delta, sq_delta);
+    printf("delta = %.3f, sq_delta = %.3f\n", delta, delta / pow(3, .5));
     for(int i=0; i < trials; i++) { 
-        for(int p=0; p < N; p++) { // sweep through all particles
-            U_old = U_new = vir_old = vir_new = 0;
-            compute_Ui(positions, N, L, p, rc2, &U_old, &vir_old);
+        tm_mc_sweep(mc);
         
-            // new position
-            for(int k=0; k <3; k++) {
-                p_old[k] = positions[k * N + p];
-                positions[k * N + p] += (1 - 2 * rnd()) * sq_delta; 
-                
-                // boundary
-                if(positions[k * N + p] < 0)
-                    positions[k * N + p] += L;
-                else if(positions[k * N + p] > L)
-                    positions[k * N + p] -= L;
-            }
-            
-            compute_Ui(positions, N, L, p, rc2, &U_new, &vir_new);
-            e = exp(-(U_new - U_old) / T);
+        if(reorder_freq > 0 && (i + 1) % reorder_freq == 0 && tm_mc_reorder(mc) != TM_ERR_OK) {
+            printf("cannot allocate reordering :(");
+            return EXIT_FAILURE;
+        }
+        
+        // pressure is sampled every `pressure_freq` sweeps, and for each summary
+        int summary = (i + 1) % summary_freq == 0 || i + 1 == trials;
+        int sample_pressure = (i + 1) % pressure_freq == 0 || summary;
+        if(sample_pressure) {
+            // the pass that recomputes the virial also resynchronizes the energy (and checks its drift)
+            if(!mc->vir_is_valid)
+                tm_mc_check_energy(mc);
             
-            if (rnd() < e) {
-                accepted++;
-                U += U_new - U_old;
-                vir += vir_new - vir_old;
-            } else {
-                for(int k=0; k <3; k++) {
-                    positions[k * N + p] = p_old[k];
-                }
+            P = tm_mc_pressure(mc);
+        }
+        
+        if(sink != NULL && (i + 1) % print_freq == 0) {
+            tm_observables_record record = {i + 1, mc->N_moves, mc->N_accepted, tm_mc_energy(mc), sample_pressure ? P : NAN};
+            if(tm_observables_sink_append(sink, &record) != TM_ERR_OK) {
+                printf("error while writing %s\n", observables_path);
+                return EXIT_FAILURE;
             }
         }
         
-        printf("%4d: U = %.3f, p=%.3f\n", i, U + U_tail, vir/V + rho * T + P_tail);
+        if(status_server != NULL) {
+            status.sweep = i + 1;
+            status.elapsed = timer_stop(&t_start);
+            status.N_moves = mc->N_moves;
+            status.N_accepted = mc->N_accepted;
+            status.U = tm_mc_energy(mc);
+            status.P = P;
+            tm_status_server_publish(status_server, &status);
+        }
+        
+        if(!summary)
+            continue;
+        
+        TM_PROFILE_BEGIN(TM_REGION_IO);
+        printf(
+                "%4d: U = %.3f, p=%.3f, acceptance = %.1f%%\n", i + 1, tm_mc_energy(mc), P,
+                ((double) (mc->N_accepted - summary_accepted)) / (double) (mc->N_moves - summary_moves) * 100.0);
+        
+        summary_moves = mc->N_moves;
+        summary_accepted = mc->N_accepted;
+        
+        if(latency) {
+            tm_histogram_print(move_latency, stdout, "      moves", ticks_per_us);
+            tm_histogram_merge(move_latency_total, move_latency);
+            tm_histogram_reset(move_latency);
+        }
+        TM_PROFILE_END(TM_REGION_IO);
     }
     
-    printf("r=%d, acceptance = %.1f\%\n", accepted, ((double) accepted ) / (N * trials) * 100.0f);
+    if(sink != NULL && tm_observables_sink_delete(sink) != TM_ERR_OK) {
+        printf("error while writing %s\n", observables_path);
+        return EXIT_FAILURE;
+    }
+    
+    printf("r=%ld, acceptance = %.1f\%\n", mc->N_accepted, ((double) mc->N_accepted) / mc->N_moves * 100.0f);
+    
+    if(parameters->single_precision || parameters->fixed_point) {
+        tm_mc_check_energy(mc);
+        printf("largest energy drift = %.3e\n", mc->U_drift);
+    }
+    
+    if(latency) {
+        tm_histogram_print(move_latency_total, stdout, "moves", ticks_per_us);
+        tm_histogram_print(sweep_latency, stdout, "sweeps", ticks_per_us);
+        
+        tm_histogram_delete(move_latency);
+        tm_histogram_delete(move_latency_total);
+        tm_histogram_delete(sweep_latency);
+    }
     
     // write positions
+    TM_PROFILE_BEGIN(TM_REGION_IO);
     FILE*f = NULL;
     f = fopen(out, "w");
     if(f == NULL) {
@@ -247,14 +398,69 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
     
-    fprintf(f, "%d\nE=%.3f, p=%.3f\n", N, U + U_tail, vir/V + rho * T + P_tail);
-    for(int p=0; p < N; p++) {
-        fprintf(f, "He %9.5f %9.5f %9.5f\n", positions[0 * N + p],positions[1 * N + p], positions[2 * N + p]);
+    // types are interned in the same order as the species, so that they get the same id
+    tm_geometry* geometry = tm_geometry_new(N);
+    if(geometry == NULL) {
+        printf("cannot allocate geometry :(");
+        return EXIT_FAILURE;
+    }
+    
+    tm_type_id type;
+    for(int t=0; t < (parameters->N_species > 0 ? parameters->N_species : 1); t++) {
+        char* name = parameters->N_species > 0 ? parameters->species[t] : "He";
+        if(tm_geometry_type_intern(geometry, name, strlen(name), &type) != TM_ERR_OK) {
+            printf("cannot allocate geometry :(");
+            return EXIT_FAILURE;
+        }
     }
     
+    for(long i=0; i < N; i++) {
+        for(int k=0; k < 3; k++)
+            geometry->positions[k * geometry->stride + mc->order[i]] = mc->positions[k * mc->stride + i];
+        
+        geometry->types[mc->order[i]] = mc->types[i];
+    }
+    
+    char title[64];
+    P = tm_mc_pressure(mc);
+    snprintf(title, 64, "E=%.3f, p=%.3f", tm_mc_energy(mc), P);
+    
+    if(tm_xyz_write(f, geometry, title, (int) sysconf(_SC_NPROCESSORS_ONLN)) != TM_ERR_OK) {
+        printf("error while writing %s\n", out);
+        return EXIT_FAILURE;
+    }
+    
+    tm_geometry_delete(geometry);
     fclose(f);
+    TM_PROFILE_END(TM_REGION_IO);
     
     // done!
-    free(positions);
+    if(status_server != NULL)
+        tm_status_server_delete(status_server);
+    
+    tm_mc_delete(mc);
+    tm_simulation_parameters_delete(parameters);
+    TM_PROFILE_END(TM_REGION_RUN);
+    
+    if(profile) {
+        tm_profile_report(stdout);
+        
+        if(trace != NULL) {
+            f = fopen(trace, "w");
+            if(f == NULL) {
+                printf("error while opening %s\n", trace);
+                return EXIT_FAILURE;
+            }
+            
+            tm_profile_write_trace(f);
+            fclose(f);
+        }
+        
+        tm_profile_finalize();
+    }
+    
+    if(memory)
+        tm_memory_report(stdout);
+    
     return EXIT_SUCCESS;
 }
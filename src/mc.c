@@ -0,0 +1,929 @@
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mc.h"
+#include "memory.h"
+#include "pcg32.h"
+#include "errors.h"
+#include "profile.h"
+#include "timer.h"
+
+/**
+ * Create a simulation box of a single type of atoms (in reduced units, i.e., \f$\epsilon=\sigma=1\f$), on a cubic
+ * lattice, and compute its energy.
+ * The random number generator (\p pcg32) is not seeded.
+ * @pre \code{.c}
+ * N > 0 && rho > 0 && T > 0 && rc > 0 && delta > 0
+ * \endcode
+ * @param N number of atoms
+ * @param rho density
+ * @param T temperature
+ * @param rc cutoff distance
+ * @param delta maximum displacement, along the diagonal (i.e., \f$\delta/\sqrt{3}\f$ along each direction)
+ * @return a new simulation, \p NULL if \p malloc failed
+ */
+tm_mc* tm_mc_new(long N, double rho, double T, double rc, double delta) {
+    assert(N > 0);
+
+    double one = 1.;
+    return tm_mc_new_mixture(1, &N, &one, &one, TM_MIXING_LORENTZ_BERTHELOT, rho, T, rc, delta, 1);
+}
+
+/* Tail corrections of each pair of types, assuming an uniform density beyond the cutoff. They only need the integral
+ * of r^2 U(r) beyond rc, since (by parts) the one of r^3 U'(r) is -rc^3 U(rc) - 3 times that.
+ */
+static void mc_tail_corrections(tm_mc* mc) {
+    tm_pair_coefs* coefs = mc->coefs;
+    tm_potential* potential = coefs->potential;
+    int N_types = coefs->N_types;
+    long composition[TM_GEOMETRY_MAX_TYPES] = {0};
+
+    mc->U_tail = 0;
+    mc->P_tail = 0;
+
+    if(potential->tail == NULL)
+        return;
+
+    for(long i=0; i < mc->N; i++)
+        composition[mc->types[i]]++;
+
+    for(int a=0; a < N_types; a++) {
+        for(int b=0; b < N_types; b++) {
+            double* params = coefs->params + (a * N_types + b) * TM_POTENTIAL_MAX_PARAMS;
+            double rc2 = coefs->rc2[a * N_types + b], rc3 = rc2 * sqrt(rc2), U_rc, vir_rc;
+            double NN = (double) composition[a] * (double) composition[b];
+            double u_int = potential->tail(params, rc2);
+
+            potential->function(rc2, params, &U_rc, &vir_rc);
+
+            mc->U_tail += 2. * M_PI * NN / mc->V * u_int;
+            mc->P_tail += 2. / 3 * M_PI * NN / (mc->V * mc->V) * (rc3 * U_rc + 3 * u_int);
+        }
+    }
+}
+
+/**
+ * Create a simulation box of a mixture of atoms, on a cubic lattice (with the types randomly distributed over the
+ * lattice sites), and compute its energy.
+ * The random number generator (\p pcg32) is not seeded.
+ * @pre \code{.c}
+ * N_types > 0 && N_types <= TM_GEOMETRY_MAX_TYPES
+ * && composition != NULL && epsilon != NULL && sigma != NULL
+ * && rho > 0 && T > 0 && rc > 0 && delta > 0
+ * \endcode
+ * @param N_types number of types
+ * @param composition number of atoms of each type, as array of size N_types (the total must be positive)
+ * @param epsilon LJ epsilon of each type, as array of size N_types
+ * @param sigma LJ sigma of each type, as array of size N_types
+ * @param rule mixing rule for pairs of different types
+ * @param rho density
+ * @param T temperature
+ * @param rc cutoff distance, in unit of the sigma of each pair
+ * @param delta maximum displacement, along the diagonal (i.e., \f$\delta/\sqrt{3}\f$ along each direction)
+ * @param sort_types if 1, atoms are kept sorted by type, so that energies are computed by blocks of the same type
+ * @return a new simulation, \p NULL if \p malloc failed
+ */
+tm_mc* tm_mc_new_mixture(
+        int N_types, long* composition, double* epsilon, double* sigma, tm_mixing_rule rule,
+        double rho, double T, double rc, double delta, int sort_types) {
+    assert(N_types > 0 && N_types <= TM_GEOMETRY_MAX_TYPES);
+    assert(composition != NULL && epsilon != NULL && sigma != NULL);
+    assert(rho > 0 && T > 0 && rc > 0 && delta > 0);
+
+    long N = 0;
+    for(int t=0; t < N_types; t++) {
+        assert(composition[t] >= 0);
+        N += composition[t];
+    }
+
+    assert(N > 0);
+
+    TM_PROFILE_BEGIN(TM_REGION_SETUP);
+
+    tm_mc* mc = tm_malloc(sizeof(tm_mc), TM_MEM_SIMULATION);
+
+    if(mc != NULL) {
+        mc->stride = TM_MEMORY_PADDED(N);
+        mc->positions = tm_calloc_aligned(4 * mc->stride, sizeof(double), TM_MEM_SIMULATION);
+        mc->types = tm_malloc(N * sizeof(tm_type_id), TM_MEM_SIMULATION);
+        mc->order = tm_malloc(N * sizeof(long), TM_MEM_SIMULATION);
+        mc->coefs = tm_pair_coefs_new(N_types, epsilon, sigma, rc, rule);
+        mc->tables = NULL;
+        mc->positions_f = NULL;
+        mc->positions_u = NULL;
+        mc->type_start = sort_types ? tm_malloc((N_types + 1) * sizeof(long), TM_MEM_SIMULATION) : NULL;
+
+        if(mc->positions == NULL || mc->types == NULL || mc->order == NULL || mc->coefs == NULL || (sort_types && mc->type_start == NULL)) {
+            tm_mc_delete(mc);
+            TM_PROFILE_END(TM_REGION_SETUP);
+            return NULL;
+        }
+
+        mc->N = N;
+        mc->rho = rho;
+        mc->T = T;
+        mc->V = N / rho;
+        mc->L = pow(mc->V, 1./3);
+        mc->box[0] = mc->box[1] = mc->box[2] = mc->L;
+        mc->rc2 = rc * rc;
+        mc->delta = delta;
+        mc->N_moves = 0;
+        mc->N_accepted = 0;
+        mc->move_latency = NULL;
+        mc->sweep_latency = NULL;
+        mc->with_virial = 1;
+        mc->vir_is_valid = 1;
+        mc->U_drift = 0;
+
+        tm_mc_init_positions(mc->positions, N, mc->stride, mc->L);
+
+        for(long i=0; i < N; i++)
+            mc->order[i] = i;
+
+        // types are contiguous ...
+        long i = 0;
+        for(int t=0; t < N_types; t++) {
+            if(sort_types)
+                mc->type_start[t] = i;
+
+            for(long n=0; n < composition[t]; n++, i++)
+                mc->types[i] = (tm_type_id) t;
+        }
+
+        if(sort_types)
+            mc->type_start[N_types] = N;
+
+        mc_tail_corrections(mc);
+
+        // ... and randomly distributed over the lattice (by shuffling the sites if they should stay sorted)
+        if(N_types > 1) {
+            for(long j=N - 1; j > 0; j--) {
+                long k = (long) (drand() * (double) (j + 1));
+                if(sort_types) {
+                    for(int d=0; d < 3; d++) {
+                        double tmp = mc->positions[d * mc->stride + j];
+                        mc->positions[d * mc->stride + j] = mc->positions[d * mc->stride + k];
+                        mc->positions[d * mc->stride + k] = tmp;
+                    }
+                } else {
+                    tm_type_id tmp = mc->types[j];
+                    mc->types[j] = mc->types[k];
+                    mc->types[k] = tmp;
+                }
+            }
+        }
+
+        tm_mc_select_kernels(mc, 1);
+        tm_mc_recompute(mc);
+    }
+
+    TM_PROFILE_END(TM_REGION_SETUP);
+
+    return mc;
+}
+
+/**
+ * Use another potential of the registry (LJ by default), with the same epsilon and sigma for each pair of types, and
+ * recompute the tail corrections and the energy of the box.
+ * @pre \code{.c}
+ * mc != NULL && potential != NULL && TM_POTENTIAL_ALPHA_IS_VALID(potential, alpha)
+ * \endcode
+ * @param mc the simulation
+ * @param potential the potential
+ * @param alpha shape parameter of the potential (if it uses one), 0 for the default of the potential
+ * @return \p TM_ERR_OK
+ */
+int tm_mc_use_potential(tm_mc* mc, tm_potential* potential, double alpha) {
+    assert(mc != NULL && potential != NULL && TM_POTENTIAL_ALPHA_IS_VALID(potential, alpha));
+
+    tm_pair_coefs_use_potential(mc->coefs, potential, alpha);
+    mc_tail_corrections(mc);
+    tm_mc_select_kernels(mc, mc->with_virial);
+    return tm_mc_recompute(mc);
+}
+
+/**
+ * Use a tabulated potential instead of the one of \p mc->coefs (or go back to it), and recompute the energy of the box.
+ * Tail corrections are not changed: they should be set in \p mc->U_tail and \p mc->P_tail if the tabulated potential
+ * is not the one of \p mc->coefs.
+ * @pre \code{.c}
+ * mc != NULL && (tables == NULL || tables->N_types == mc->coefs->N_types)
+ * \endcode
+ * @param mc the simulation
+ * @param tables the tables (which should outlive the simulation), or \p NULL for the potential of \p mc->coefs
+ * @return \p TM_ERR_OK
+ */
+int tm_mc_use_tables(tm_mc* mc, tm_pair_tables* tables) {
+    assert(mc != NULL);
+    assert(tables == NULL || tables->N_types == mc->coefs->N_types);
+
+    mc->tables = tables;
+    tm_mc_select_kernels(mc, mc->with_virial);
+    return tm_mc_recompute(mc);
+}
+
+// fixed point: a coordinate is a fraction of the length of the box, in unit of 2^-32
+#define MC_FIXED_POINT_ONE 4294967296.
+
+/* Derive the positions from the ones in fixed point (if used), then copy them in single precision (if used).
+ */
+static void mc_sync_positions(tm_mc* mc) {
+    long N = mc->N, S = mc->stride;
+
+    if(mc->positions_u != NULL) {
+        for(int k=0; k < 3; k++) {
+            for(long i=0; i < N; i++)
+                mc->positions[k * S + i] = mc->positions_u[k * S + i] / MC_FIXED_POINT_ONE * mc->box[k];
+        }
+    }
+
+    if(mc->positions_f != NULL) {
+        for(long k=0; k < 3 * S; k++)
+            mc->positions_f[k] = (float) mc->positions[k];
+    }
+}
+
+/**
+ * Compute the distances in single precision (or go back to double precision), while sums are still accumulated in
+ * double precision. Positions are kept in double precision (moves are done there), and copied after each move.
+ * Since tm_mc_compute_U() is always in double precision, the energy updated move after move can be checked against it
+ * with tm_mc_check_energy().
+ *
+ * Measured against tm_mc_compute_U() (LJ, N=1000, rho=0.8, T=0.9, rc=4):
+ *
+ * - energy: the energy of an atom is within 5e-5 (relative error below 1e-5) of the one in double precision, and the
+ *   drift of the energy of the box is below 1e-3 after 10 to 100 sweeps (for \f$U \approx -5000\f$, it does not
+ *   grow, since errors of the moves mostly cancel);
+ * - pressure: the virial of an atom is within 3e-4 of the one in double precision. If the virial is tracked move after
+ *   move, the pressure is within 2e-6 of the one in double precision after 10 to 100 sweeps (for \f$P \approx 1\f$).
+ *   If it is only computed when sampled (see tm_mc_select_kernels()), it is computed in double precision, so it is
+ *   exact.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @param single whether distances should be computed in single precision
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+int tm_mc_use_single_precision(tm_mc* mc, int single) {
+    assert(mc != NULL);
+
+    if(single && mc->positions_f == NULL) {
+        mc->positions_f = tm_calloc_aligned(4 * mc->stride, sizeof(float), TM_MEM_SIMULATION);
+        if(mc->positions_f == NULL)
+            return TM_ERR_MALLOC;
+
+        mc_sync_positions(mc);
+    } else if(!single && mc->positions_f != NULL) {
+        tm_free(mc->positions_f);
+        mc->positions_f = NULL;
+    }
+
+    return tm_mc_select_kernels(mc, mc->with_virial);
+}
+
+/**
+ * Store the positions in fixed point (or go back to floating point): each coordinate is an unsigned 32-bit fraction
+ * of the length of the box. Periodic boundaries are then handled by the overflow of integers, both for the moves and
+ * for the minimum image (the difference of two coordinates, as a signed integer, is the one of the closest image).
+ * The difference is converted to single precision for the square distance, which is accumulated in double precision.
+ *
+ * The positions in fixed point are then the reference: moves are done there, and \p mc->positions (used by
+ * tm_mc_compute_U(), and thus tm_mc_check_energy()) are derived from them. Since the moves are rounded to integers,
+ * the positions are exactly reproducible across platforms for a given sequence of random numbers. The positions are
+ * rounded to the closest fraction (\f$L/2^{32}\f$, e.g., \f$2\times 10^{-9}\f$ for \f$L=8.6\f$) first, and the
+ * energy of the box is recomputed. Going back to floating point keeps those positions.
+ * If distances are also computed in single precision (see tm_mc_use_single_precision()), fixed point is used instead.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @param fixed whether positions should be stored in fixed point
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+int tm_mc_use_fixed_point(tm_mc* mc, int fixed) {
+    assert(mc != NULL);
+
+    long N = mc->N, S = mc->stride;
+
+    if(fixed && mc->positions_u == NULL) {
+        mc->positions_u = tm_calloc_aligned(3 * S, sizeof(uint32_t), TM_MEM_SIMULATION);
+        if(mc->positions_u == NULL)
+            return TM_ERR_MALLOC;
+
+        // positions are in [0, L], so that L wraps to 0
+        for(int k=0; k < 3; k++) {
+            for(long i=0; i < N; i++)
+                mc->positions_u[k * S + i] = (uint32_t) llrint(mc->positions[k * S + i] / mc->box[k] * MC_FIXED_POINT_ONE);
+        }
+
+        mc_sync_positions(mc);
+    } else if(!fixed && mc->positions_u != NULL) {
+        tm_free(mc->positions_u);
+        mc->positions_u = NULL;
+    }
+
+    tm_mc_select_kernels(mc, mc->with_virial);
+    return tm_mc_recompute(mc);
+}
+
+/**
+ * Change the shape of the box, keeping its volume: positions are scaled accordingly, and the energy of the box is
+ * recomputed.
+ * @pre \code{.c}
+ * mc != NULL && shape != NULL && shape[0] > 0 && shape[1] > 0 && shape[2] > 0
+ * \endcode
+ * @param mc the simulation
+ * @param shape the lengths of the box are proportional to those
+ * @return \p TM_ERR_OK
+ */
+int tm_mc_set_box(tm_mc* mc, double* shape) {
+    assert(mc != NULL && shape != NULL);
+    assert(shape[0] > 0 && shape[1] > 0 && shape[2] > 0);
+
+    double f = cbrt(mc->V / (shape[0] * shape[1] * shape[2]));
+
+    // (in fixed point, positions are fractions of the box, so they do not change)
+    for(int k=0; k < 3; k++) {
+        double L = shape[k] * f;
+        for(long i=0; i < mc->N; i++)
+            mc->positions[k * mc->stride + i] *= L / mc->box[k];
+
+        mc->box[k] = L;
+    }
+
+    mc_sync_positions(mc);
+    tm_mc_select_kernels(mc, mc->with_virial);
+    return tm_mc_recompute(mc);
+}
+
+// number of bits of the cell coordinates along each direction, for tm_mc_reorder() (so that the key fits in 62 bits,
+// with the type)
+#define MC_MORTON_BITS 18
+
+struct mc_key {
+    uint64_t key;
+    long index;
+};
+
+static int mc_key_compare(const void* a, const void* b) {
+    uint64_t ka = ((struct mc_key*) a)->key, kb = ((struct mc_key*) b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// spread the lower MC_MORTON_BITS bits of x, so that there are two zeros between each of them
+static uint64_t mc_morton_spread(uint64_t x) {
+    x &= 0x3ffff;
+    x = (x | x << 32) & 0x1f00000000ffffULL;
+    x = (x | x << 16) & 0x1f0000ff0000ffULL;
+    x = (x | x << 8) & 0x100f00f00f00f00fULL;
+    x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+    x = (x | x << 2) & 0x1249249249249249ULL;
+    return x;
+}
+
+// apply the permutation to a row of n elements of the given size (tmp has room for the row)
+static void mc_permute(void* row, void* tmp, size_t size, struct mc_key* keys, long n) {
+    for(long j=0; j < n; j++)
+        memcpy((char*) tmp + j * size, (char*) row + keys[j].index * size, size);
+
+    memcpy(row, tmp, n * size);
+}
+
+/**
+ * Reorder the atoms along a space-filling curve (Morton order of a grid of \f$2^{18}\f$ cells along each direction),
+ * so that atoms that are close in space are also close in memory. If atoms are sorted by type, they stay so (the type
+ * is the first part of the key). Positions (in any precision) and types are permuted, and \p mc->order keeps track of
+ * the initial index of each atom. The energy is not changed.
+ * Since tm_mc_sweep() moves the atoms in order, this also changes the sequence of moves.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+int tm_mc_reorder(tm_mc* mc) {
+    assert(mc != NULL);
+
+    long N = mc->N, S = mc->stride;
+
+    struct mc_key* keys = tm_malloc(N * sizeof(struct mc_key), TM_MEM_SIMULATION);
+    void* tmp = tm_malloc(N * sizeof(double), TM_MEM_SIMULATION);
+    if(keys == NULL || tmp == NULL) {
+        tm_free(keys);
+        tm_free(tmp);
+        return TM_ERR_MALLOC;
+    }
+
+    for(long i=0; i < N; i++) {
+        uint64_t key = 0;
+        for(int k=0; k < 3; k++) {
+            double x = mc->positions[k * S + i] / mc->box[k] * (1 << MC_MORTON_BITS);
+            uint64_t cell = x <= 0 ? 0 : x >= (1 << MC_MORTON_BITS) ? (1 << MC_MORTON_BITS) - 1 : (uint64_t) x;
+            key |= mc_morton_spread(cell) << k;
+        }
+
+        if(mc->type_start != NULL)
+            key |= (uint64_t) mc->types[i] << (3 * MC_MORTON_BITS);
+
+        keys[i].key = key;
+        keys[i].index = i;
+    }
+
+    qsort(keys, N, sizeof(struct mc_key), mc_key_compare);
+
+    for(int k=0; k < 3; k++) {
+        mc_permute(mc->positions + k * S, tmp, sizeof(double), keys, N);
+
+        if(mc->positions_f != NULL)
+            mc_permute(mc->positions_f + k * S, tmp, sizeof(float), keys, N);
+
+        if(mc->positions_u != NULL)
+            mc_permute(mc->positions_u + k * S, tmp, sizeof(uint32_t), keys, N);
+    }
+
+    mc_permute(mc->types, tmp, sizeof(tm_type_id), keys, N);
+    mc_permute(mc->order, tmp, sizeof(long), keys, N);
+
+    tm_free(keys);
+    tm_free(tmp);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Recompute the energy and virial of the box from scratch.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @post \p mc->U and \p mc->vir are set, and \p mc->vir_is_valid as well
+ * @return \p TM_ERR_OK
+ */
+int tm_mc_recompute(tm_mc* mc) {
+    assert(mc != NULL);
+
+    TM_PROFILE_BEGIN(TM_REGION_ENERGY);
+    tm_mc_compute_U(mc, &(mc->U), &(mc->vir));
+    TM_PROFILE_END(TM_REGION_ENERGY);
+
+    mc->vir_is_valid = 1;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Recompute the energy and virial of the box (in double precision), and check the energy that was updated move after
+ * move against it.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @post \p mc->U and \p mc->vir are set, and \p mc->U_drift is updated
+ * @return the difference between the two energies
+ */
+double tm_mc_check_energy(tm_mc* mc) {
+    assert(mc != NULL);
+
+    double U = mc->U;
+    tm_mc_recompute(mc);
+
+    double drift = fabs(mc->U - U);
+    if(drift > mc->U_drift)
+        mc->U_drift = drift;
+
+    return drift;
+}
+
+/**
+ * Perform a sweep, i.e., a trial move for each atom (in order), accepted with the Metropolis criterion.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @return \p TM_ERR_OK
+ * @post positions, energy, virial (if \p mc->with_virial, otherwise it is marked as not up to date) and move counters
+ * of \p mc are updated, and latencies are recorded (if requested).
+ */
+int tm_mc_sweep(tm_mc* mc) {
+    assert(mc != NULL);
+
+    long N = mc->N, S = mc->stride;
+    double sq_delta = mc->delta / sqrt(3), U_old, U_new, vir_old, vir_new, p_old[3];
+    double* positions = mc->positions;
+    float* positions_f = mc->positions_f;
+    uint32_t* positions_u = mc->positions_u, u_old[3];
+    uint64_t sweep_start = 0, move_start = 0;
+
+    TM_PROFILE_BEGIN(TM_REGION_SWEEP);
+
+    if(mc->sweep_latency != NULL)
+        sweep_start = timer_ticks();
+
+    for(long p=0; p < N; p++) {
+        if(mc->move_latency != NULL)
+            move_start = timer_ticks();
+
+        U_old = U_new = vir_old = vir_new = 0;
+
+        TM_PROFILE_BEGIN(TM_REGION_ENERGY);
+        tm_mc_compute_Ui(mc, p, &U_old, &vir_old);
+        TM_PROFILE_END(TM_REGION_ENERGY);
+
+        // new position
+        TM_PROFILE_BEGIN(TM_REGION_MOVE);
+        for(int k=0; k < 3; k++) {
+            p_old[k] = positions[k * S + p];
+
+            if(positions_u != NULL) {
+                // boundary: wraps around
+                u_old[k] = positions_u[k * S + p];
+                positions_u[k * S + p] += (uint32_t) lrint((1 - 2 * drand()) * sq_delta / mc->box[k] * MC_FIXED_POINT_ONE);
+                positions[k * S + p] = positions_u[k * S + p] / MC_FIXED_POINT_ONE * mc->box[k];
+            } else {
+                positions[k * S + p] += (1 - 2 * drand()) * sq_delta;
+
+                // boundary
+                if(positions[k * S + p] < 0)
+                    positions[k * S + p] += mc->box[k];
+                else if(positions[k * S + p] > mc->box[k])
+                    positions[k * S + p] -= mc->box[k];
+            }
+
+            if(positions_f != NULL)
+                positions_f[k * S + p] = (float) positions[k * S + p];
+        }
+        TM_PROFILE_END(TM_REGION_MOVE);
+
+        TM_PROFILE_BEGIN(TM_REGION_ENERGY);
+        tm_mc_compute_Ui(mc, p, &U_new, &vir_new);
+        TM_PROFILE_END(TM_REGION_ENERGY);
+
+        TM_PROFILE_BEGIN(TM_REGION_ACCEPT);
+        if(drand() < exp(-(U_new - U_old) / mc->T)) {
+            mc->N_accepted++;
+            mc->U += U_new - U_old;
+            mc->vir += vir_new - vir_old;
+            mc->vir_is_valid = mc->with_virial && mc->vir_is_valid;
+        } else {
+            for(int k=0; k < 3; k++) {
+                positions[k * S + p] = p_old[k];
+                if(positions_u != NULL)
+                    positions_u[k * S + p] = u_old[k];
+                if(positions_f != NULL)
+                    positions_f[k * S + p] = (float) p_old[k];
+            }
+        }
+        TM_PROFILE_END(TM_REGION_ACCEPT);
+
+        if(mc->move_latency != NULL)
+            tm_histogram_record(mc->move_latency, timer_ticks() - move_start);
+    }
+
+    if(mc->sweep_latency != NULL)
+        tm_histogram_record(mc->sweep_latency, timer_ticks() - sweep_start);
+
+    TM_PROFILE_END(TM_REGION_SWEEP);
+
+    mc->N_moves += N;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Get the energy of the box, including the tail correction.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @return the energy
+ */
+double tm_mc_energy(tm_mc* mc) {
+    assert(mc != NULL);
+
+    return mc->U + mc->U_tail;
+}
+
+/**
+ * Get the pressure of the box, including the tail correction.
+ * If the virial is not up to date (because it is not tracked during the moves), it is recomputed first, in one pass
+ * over the box. Only the virial is kept: the energy updated move after move is left as is (use tm_mc_check_energy()
+ * beforehand to resynchronize it in the same pass).
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @post \p mc->vir is up to date, \p mc->U and \p mc->U_drift are unchanged
+ * @return the pressure
+ */
+double tm_mc_pressure(tm_mc* mc) {
+    assert(mc != NULL);
+
+    if(!mc->vir_is_valid) {
+        double U;
+
+        TM_PROFILE_BEGIN(TM_REGION_ENERGY);
+        tm_mc_compute_U(mc, &U, &(mc->vir));
+        TM_PROFILE_END(TM_REGION_ENERGY);
+
+        mc->vir_is_valid = 1;
+    }
+
+    return mc->vir / mc->V + mc->rho * mc->T + mc->P_tail;
+}
+
+/**
+ * Delete a simulation.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @return \p TM_ERR_OK
+ */
+int tm_mc_delete(tm_mc* mc) {
+    assert(mc != NULL);
+
+    if(mc->positions != NULL)
+        tm_free(mc->positions);
+
+    if(mc->positions_f != NULL)
+        tm_free(mc->positions_f);
+
+    if(mc->positions_u != NULL)
+        tm_free(mc->positions_u);
+
+    if(mc->types != NULL)
+        tm_free(mc->types);
+
+    if(mc->order != NULL)
+        tm_free(mc->order);
+
+    if(mc->coefs != NULL)
+        tm_pair_coefs_delete(mc->coefs);
+
+    if(mc->type_start != NULL)
+        tm_free(mc->type_start);
+
+    tm_free(mc);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Put \p N atoms on a simple cubic lattice that fills a cubic box of side \p L.
+ * @pre \code{.c}
+ * positions != NULL && N > 0 && stride >= N && L > 0
+ * \endcode
+ * @param positions positions, as array of size 3*stride, {X, Y, Z} (each of size N)
+ * @param N number of atoms
+ * @param stride distance between the rows of \p positions
+ * @param L length of the box
+ * @post \p positions are set
+ */
+void tm_mc_init_positions(double* positions, long N, long stride, double L) {
+    assert(positions != NULL && N > 0 && stride >= N && L > 0);
+
+    long ppL = (long) ceil(pow(N, 1./3));
+    double dist = L / ppL;
+
+    for(long i=0; i < N; i++) {
+        positions[0 * stride + i] = (i % ppL) * dist;
+        positions[1 * stride + i] = ((i / ppL) % ppL) * dist;
+        positions[2 * stride + i] = (i / (ppL * ppL)) * dist;
+    }
+}
+
+/* Add the energy and virial of atom i (of type ti) with atoms [start, end), from the square distances in the
+ * scratch space. If atoms are sorted by type, the kernel (or the table) is called once for each block of atoms of the
+ * same type, otherwise for each run of atoms of the same type.
+ */
+static void mc_sum_pairs(tm_mc* mc, tm_pair_kernel kernel, tm_type_id ti, long start, long end, double* U, double* vir) {
+    double* restrict r2 = mc->positions + 3 * mc->stride;
+    tm_pair_coefs* coefs = mc->coefs;
+    int N_types = coefs->N_types;
+    double* params = coefs->params + ti * N_types * TM_POTENTIAL_MAX_PARAMS;
+    double* rc2 = coefs->rc2 + ti * N_types;
+    double sU = 0, svir = 0;
+
+    if(mc->tables != NULL) {
+        tm_table* tables = mc->tables->tables + ti * N_types;
+        if(mc->type_start != NULL) {
+            for(int t=0; t < N_types; t++) {
+                long bstart = mc->type_start[t] > start ? mc->type_start[t] : start;
+                long bend = mc->type_start[t + 1] < end ? mc->type_start[t + 1] : end;
+                if(bend > bstart)
+                    tm_table_sum_N(&(tables[t]), bend - bstart, r2 + bstart, &sU, &svir);
+            }
+        } else {
+            for(long j=start; j < end; j++)
+                tm_table_eval(&(tables[mc->types[j]]), r2[j], &sU, &svir);
+        }
+    } else if(mc->type_start != NULL) {
+        for(int t=0; t < N_types; t++) {
+            long bstart = mc->type_start[t] > start ? mc->type_start[t] : start;
+            long bend = mc->type_start[t + 1] < end ? mc->type_start[t + 1] : end;
+            if(bend > bstart)
+                kernel(bend - bstart, r2 + bstart, params + t * TM_POTENTIAL_MAX_PARAMS, rc2[t], &sU, &svir);
+        }
+    } else {
+        tm_type_id* types = mc->types;
+        long j = start, jend;
+
+        while(j < end) {
+            tm_type_id t = types[j];
+            for(jend = j + 1; jend < end && types[jend] == t; jend++);
+
+            kernel(jend - j, r2 + j, params + t * TM_POTENTIAL_MAX_PARAMS, rc2[t], &sU, &svir);
+            j = jend;
+        }
+    }
+
+    *U += sU;
+    *vir += svir;
+}
+
+/* Add the energy and virial of atom i with atoms [start, end), except itself, from the square distances in the
+ * scratch space (multiple_types is a compile-time constant in the energy kernels).
+ */
+static inline void mc_sum_except_self(
+        tm_mc* mc, tm_pair_kernel pair_kernel, int multiple_types, long i, long start, long end, double* U, double* vir) {
+    double* restrict r2 = mc->positions + 3 * mc->stride;
+    long skip = i >= start && i < end ? i : end;
+
+    if(multiple_types) {
+        mc_sum_pairs(mc, pair_kernel, mc->types[i], start, skip, U, vir);
+        mc_sum_pairs(mc, pair_kernel, mc->types[i], skip + 1, end, U, vir);
+    } else {
+        pair_kernel(skip - start, r2 + start, mc->coefs->params, mc->coefs->rc2[0], U, vir);
+        if(end > skip + 1)
+            pair_kernel(end - skip - 1, r2 + skip + 1, mc->coefs->params, mc->coefs->rc2[0], U, vir);
+    }
+}
+
+/* Energy kernels (see tm_mc_energy_kernel).
+ * The variants, for cubic or orthorhombic boxes, for a single type or multiple types (or tables) and for distances in
+ * double or single precision (real is double or float, and q the corresponding positions in tm_mc) are generated
+ * by MC_ENERGY_KERNEL(), and the ones in fixed point by MC_ENERGY_KERNEL_FIXED_POINT(). All are compile-time
+ * constants, so that each variant only contains the code it needs.
+ * Since the rows are aligned and padded, distances are computed over [start, end) extended to full vectors, so that
+ * loops need no peeling (distances of the padding, or of atoms before start, are computed but not used).
+ */
+#define MC_ENERGY_KERNEL(name, orthorhombic, multiple_types, real, q) \
+    static void name(tm_mc* mc, tm_pair_kernel pair_kernel, long i, long start, long end, double* U, double* vir) { \
+        long S = mc->stride, vstart = TM_MEMORY_ROUNDED_DOWN(start), vend = TM_MEMORY_PADDED(end); \
+        real* restrict q1; \
+        real* restrict r2_q = __builtin_assume_aligned(mc->q + 3 * S, TM_MEMORY_ALIGNMENT); /* same as r2 in double precision */ \
+        double* restrict r2 = __builtin_assume_aligned(mc->positions + 3 * S, TM_MEMORY_ALIGNMENT); \
+        \
+        for(long j=vstart; j < vend; j++) \
+            r2_q[j] = 0; \
+        \
+        for(int k=0; k < 3; k++) { \
+            real L = (real) ((orthorhombic) ? mc->box[k] : mc->L), hL = L / 2; \
+            q1 = __builtin_assume_aligned(mc->q + k * S, TM_MEMORY_ALIGNMENT); \
+            real qi = q1[i]; \
+            _Pragma("omp simd") \
+            for(long j=vstart; j < vend; j++) { \
+                real dq = q1[j] - qi; \
+                dq += (dq>hL) * (-L) + (dq<-hL) * L; \
+                r2_q[j] += dq * dq; \
+            } \
+        } \
+        \
+        if(sizeof(real) != sizeof(double)) { \
+            _Pragma("omp simd") \
+            for(long j=vstart; j < vend; j++) \
+                r2[j] = r2_q[j]; \
+        } \
+        \
+        mc_sum_except_self(mc, pair_kernel, multiple_types, i, start, end, U, vir); \
+    }
+
+/* In fixed point, the difference of two coordinates (modulo 2^32), as a signed integer, is the minimum image (two's
+ * complement is assumed for the conversion), so that only the conversion to a length remains.
+ */
+#define MC_ENERGY_KERNEL_FIXED_POINT(name, orthorhombic, multiple_types) \
+    static void name(tm_mc* mc, tm_pair_kernel pair_kernel, long i, long start, long end, double* U, double* vir) { \
+        long S = mc->stride, vstart = TM_MEMORY_ROUNDED_DOWN(start), vend = TM_MEMORY_PADDED(end); \
+        uint32_t* restrict u1; \
+        double* restrict r2 = __builtin_assume_aligned(mc->positions + 3 * S, TM_MEMORY_ALIGNMENT); \
+        \
+        for(long j=vstart; j < vend; j++) \
+            r2[j] = 0; \
+        \
+        for(int k=0; k < 3; k++) { \
+            float scale = (float) (((orthorhombic) ? mc->box[k] : mc->L) / MC_FIXED_POINT_ONE); \
+            u1 = __builtin_assume_aligned(mc->positions_u + k * S, TM_MEMORY_ALIGNMENT); \
+            uint32_t ui = u1[i]; \
+            _Pragma("omp simd") \
+            for(long j=vstart; j < vend; j++) { \
+                float dq = (float) (int32_t) (u1[j] - ui) * scale; \
+                r2[j] += dq * dq; \
+            } \
+        } \
+        \
+        mc_sum_except_self(mc, pair_kernel, multiple_types, i, start, end, U, vir); \
+    }
+
+MC_ENERGY_KERNEL(mc_energy_cubic, 0, 0, double, positions)
+MC_ENERGY_KERNEL(mc_energy_cubic_types, 0, 1, double, positions)
+MC_ENERGY_KERNEL(mc_energy_orthorhombic, 1, 0, double, positions)
+MC_ENERGY_KERNEL(mc_energy_orthorhombic_types, 1, 1, double, positions)
+MC_ENERGY_KERNEL(mc_energy_cubic_f, 0, 0, float, positions_f)
+MC_ENERGY_KERNEL(mc_energy_cubic_types_f, 0, 1, float, positions_f)
+MC_ENERGY_KERNEL(mc_energy_orthorhombic_f, 1, 0, float, positions_f)
+MC_ENERGY_KERNEL(mc_energy_orthorhombic_types_f, 1, 1, float, positions_f)
+MC_ENERGY_KERNEL_FIXED_POINT(mc_energy_cubic_u, 0, 0)
+MC_ENERGY_KERNEL_FIXED_POINT(mc_energy_cubic_types_u, 0, 1)
+MC_ENERGY_KERNEL_FIXED_POINT(mc_energy_orthorhombic_u, 1, 0)
+MC_ENERGY_KERNEL_FIXED_POINT(mc_energy_orthorhombic_types_u, 1, 1)
+
+// [double, single precision or fixed point][orthorhombic][multiple_types]
+static tm_mc_energy_kernel MC_ENERGY_KERNELS[3][2][2] = {
+        {{mc_energy_cubic, mc_energy_cubic_types}, {mc_energy_orthorhombic, mc_energy_orthorhombic_types}},
+        {{mc_energy_cubic_f, mc_energy_cubic_types_f}, {mc_energy_orthorhombic_f, mc_energy_orthorhombic_types_f}},
+        {{mc_energy_cubic_u, mc_energy_cubic_types_u}, {mc_energy_orthorhombic_u, mc_energy_orthorhombic_types_u}}
+};
+
+/**
+ * Select the variants of the kernels that fit the simulation: cubic or orthorhombic box, a single type or multiple
+ * types (or tables), with a cutoff or not (if the cutoff of each pair of types is larger than any distance in the box),
+ * with or without virial, and distances in double or single precision or in fixed point (only for tm_mc_compute_Ui()).
+ * This is done when the simulation is created or changed, so it is only needed to change \p with_virial.
+ * @pre \code{.c}
+ * mc != NULL
+ * \endcode
+ * @param mc the simulation
+ * @param with_virial whether tm_mc_compute_Ui() should compute the virial (and tm_mc_sweep() update it). If not,
+ * the virial is only computed when needed, by tm_mc_pressure()
+ * @return \p TM_ERR_OK
+ */
+int tm_mc_select_kernels(tm_mc* mc, int with_virial) {
+    assert(mc != NULL);
+
+    tm_pair_coefs* coefs = mc->coefs;
+    int orthorhombic = mc->box[0] != mc->box[1] || mc->box[0] != mc->box[2];
+    int multiple_types = coefs->N_types > 1 || mc->tables != NULL;
+    int cutoff = 0;
+
+    // largest distance, with the minimum image convention
+    double r2_max = (mc->box[0] * mc->box[0] + mc->box[1] * mc->box[1] + mc->box[2] * mc->box[2]) / 4;
+    for(int p=0; p < coefs->N_types * coefs->N_types; p++)
+        cutoff |= coefs->rc2[p] <= r2_max;
+
+    mc->with_virial = with_virial != 0;
+    int precision = mc->positions_u != NULL ? 2 : mc->positions_f != NULL;
+    mc->energy_kernel = MC_ENERGY_KERNELS[precision][orthorhombic][multiple_types];
+    mc->energy_kernel_double = MC_ENERGY_KERNELS[0][orthorhombic][multiple_types];
+    mc->pair_kernel = coefs->potential->kernels[cutoff][mc->with_virial];
+    mc->pair_kernel_virial = coefs->potential->kernels[cutoff][1];
+
+    // from now on, the virial is tracked
+    if(mc->with_virial && !mc->vir_is_valid)
+        tm_mc_recompute(mc);
+
+    TM_DEBUG("kernels: orthorhombic=%d, multiple_types=%d, cutoff=%d, virial=%d", orthorhombic, multiple_types, cutoff, mc->with_virial);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Compute the energy and virial of the whole box (always in double precision).
+ * @pre \code{.c}
+ * mc != NULL && U != NULL && vir != NULL
+ * \endcode
+ * @param mc the simulation (the scratch space of \p mc->positions is overwritten)
+ * @param [out] U the energy
+ * @param [out] vir the virial
+ * @post \p U and \p vir are set
+ */
+void tm_mc_compute_U(tm_mc* mc, double* U, double* vir) {
+    assert(mc != NULL && U != NULL && vir != NULL);
+
+    *U = 0;
+    *vir = 0;
+
+    for(long i=0; i < mc->N - 1; i++)
+        mc->energy_kernel_double(mc, mc->pair_kernel_virial, i, i + 1, mc->N, U, vir);
+}
+
+/**
+ * Compute the energy and virial (if \p mc->with_virial) of atom \p i with all the others.
+ * @pre \code{.c}
+ * mc != NULL && 0 <= i < mc->N && U_i != NULL && vir_i != NULL
+ * \endcode
+ * @param mc the simulation (the scratch space of \p mc->positions is overwritten)
+ * @param i the atom
+ * @param [out] U_i the energy
+ * @param [out] vir_i the virial
+ * @post results for the energy and virial are added to \p U_i and \p vir_i.
+ */
+void tm_mc_compute_Ui(tm_mc* mc, long i, double* U_i, double* vir_i) {
+    assert(mc != NULL && i >= 0 && i < mc->N && U_i != NULL && vir_i != NULL);
+
+    mc->energy_kernel(mc, mc->pair_kernel, i, 0, mc->N, U_i, vir_i);
+}
@@ -0,0 +1,120 @@
+#ifndef TOYMC_MC_H
+#define TOYMC_MC_H
+
+#include <stdint.h>
+
+#include "histogram.h"
+#include "geometry.h"
+#include "pair_coefs.h"
+#include "tabulated.h"
+
+struct tm_mc_;
+
+/**
+ * @brief A variant of the computation of the energy (and virial, if \p pair_kernel computes it) of atom \p i with
+ * atoms in [\p start, \p end), except itself. Results are added to \p U and \p vir.
+ */
+typedef void (*tm_mc_energy_kernel)(
+        struct tm_mc_* mc, tm_pair_kernel pair_kernel, long i, long start, long end, double* U, double* vir);
+
+/**
+ * @brief A (NVT) Monte Carlo simulation of particles (possibly of different types) interacting through a pair potential,
+ * in an orthorhombic (by default, cubic) box.
+ * Fields are \code{.c}
+ * long N; // number of atoms
+ * tm_type_id* types; // type of each atom, as array of size N
+ * long* order; // index of each atom in the initial order, as array of size N (see tm_mc_reorder())
+ * tm_pair_coefs* coefs; // parameters of the potential of each pair of types
+ * tm_pair_tables* tables; // if not NULL, tabulated potential used instead of the one of coefs (not owned by the simulation)
+ * long* type_start; // if not NULL, atoms are sorted by type, and atoms of type t are in [type_start[t], type_start[t+1])
+ * double rho; // density
+ * double T; // temperature
+ * double L; // length of the box (if not cubic, the one of a cubic box of the same volume)
+ * double box[3]; // lengths of the box, along each direction
+ * double V; // volume of the box
+ * double rc2; // square of the cutoff distance (in unit of the sigma of each pair)
+ * double delta; // maximum displacement (along the diagonal)
+ * long stride; // distance between the rows of positions (N, padded with TM_MEMORY_PADDED())
+ * double* positions; // positions, as array of size 4*stride: {X, Y, Z} (each of size N, then zeros), then stride values used as scratch space
+ * float* positions_f; // if not NULL, copy of the positions in single precision, with the same layout (see tm_mc_use_single_precision())
+ * uint32_t* positions_u; // if not NULL, positions in fixed point, as array of size 3*stride (see tm_mc_use_fixed_point())
+ * double U; // energy (without tail correction)
+ * double vir; // virial (without tail correction), only up to date if vir_is_valid
+ * double U_tail; // tail correction to the energy
+ * double P_tail; // tail correction to the pressure
+ * long N_moves; // number of trial moves
+ * long N_accepted; // number of accepted moves
+ * tm_histogram* move_latency; // if not NULL, duration of each move is recorded (in ticks, see timer_ticks())
+ * tm_histogram* sweep_latency; // if not NULL, duration of each sweep is recorded
+ * int with_virial; // if not set, tm_mc_compute_Ui() does not compute the virial, and tm_mc_sweep() does not update it
+ * int vir_is_valid; // if not set, the virial must be recomputed (see tm_mc_recompute())
+ * double U_drift; // largest difference between the energy updated move after move and its recomputation
+ * tm_mc_energy_kernel energy_kernel; // variant used by tm_mc_compute_Ui() (see tm_mc_select_kernels())
+ * tm_mc_energy_kernel energy_kernel_double; // variant used by tm_mc_compute_U() (in double precision)
+ * tm_pair_kernel pair_kernel; // variant of the kernel of the potential used by tm_mc_compute_Ui()
+ * tm_pair_kernel pair_kernel_virial; // variant of the kernel of the potential used by tm_mc_compute_U()
+ * \endcode
+ */
+typedef struct tm_mc_ {
+    long N;
+    tm_type_id* types;
+    long* order;
+    tm_pair_coefs* coefs;
+    tm_pair_tables* tables;
+    long* type_start;
+
+    double rho;
+    double T;
+    double L;
+    double box[3];
+    double V;
+    double rc2;
+    double delta;
+    long stride;
+    double* positions;
+    float* positions_f;
+    uint32_t* positions_u;
+
+    double U;
+    double vir;
+    double U_tail;
+    double P_tail;
+
+    long N_moves;
+    long N_accepted;
+
+    tm_histogram* move_latency;
+    tm_histogram* sweep_latency;
+
+    int with_virial;
+    int vir_is_valid;
+    double U_drift;
+    tm_mc_energy_kernel energy_kernel;
+    tm_mc_energy_kernel energy_kernel_double;
+    tm_pair_kernel pair_kernel;
+    tm_pair_kernel pair_kernel_virial;
+} tm_mc;
+
+tm_mc* tm_mc_new(long N, double rho, double T, double rc, double delta);
+tm_mc* tm_mc_new_mixture(
+        int N_types, long* composition, double* epsilon, double* sigma, tm_mixing_rule rule,
+        double rho, double T, double rc, double delta, int sort_types);
+int tm_mc_use_potential(tm_mc* mc, tm_potential* potential, double alpha);
+int tm_mc_use_tables(tm_mc* mc, tm_pair_tables* tables);
+int tm_mc_set_box(tm_mc* mc, double* shape);
+int tm_mc_use_single_precision(tm_mc* mc, int single);
+int tm_mc_use_fixed_point(tm_mc* mc, int fixed);
+int tm_mc_reorder(tm_mc* mc);
+int tm_mc_select_kernels(tm_mc* mc, int with_virial);
+int tm_mc_sweep(tm_mc* mc);
+int tm_mc_recompute(tm_mc* mc);
+double tm_mc_check_energy(tm_mc* mc);
+double tm_mc_energy(tm_mc* mc);
+double tm_mc_pressure(tm_mc* mc);
+int tm_mc_delete(tm_mc* mc);
+
+void tm_mc_init_positions(double* positions, long N, long stride, double L);
+void tm_mc_compute_U(tm_mc* mc, double* U, double* vir);
+void tm_mc_compute_Ui(tm_mc* mc, long i, double* U_i, double* vir_i);
+
+#endif //TOYMC_MC_H
@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "memory.h"
+#include "errors.h"
+
+/* Each block starts with a header that keeps its size and tag, so that it can be accounted for when free'd.
+ * It is 16 bytes long (on 64-bit), so that the block keeps the alignment of `malloc()`.
+ * For aligned blocks, the header is right before the block, and offset is the distance to the start of the memory
+ * allocated by `malloc()` (0 otherwise).
+ */
+typedef struct memory_header_ {
+    size_t size;
+    uint32_t tag;
+    uint32_t offset;
+} memory_header;
+
+static char* tag_names[] = {
+        "geometry",
+        "simulation",
+        "parameters",
+        "io",
+        "instrumentation",
+        "total"
+};
+
+static tm_memory_stats stats[TM_MEM_LAST + 1];
+
+static void memory_account(tm_memory_tag tag, long change, int is_alloc) {
+    int tags[] = {tag, TM_MEM_LAST};
+
+    for(int i=0; i < 2; i++) {
+        tm_memory_stats* s = &stats[tags[i]];
+        long current = __atomic_add_fetch(&s->current, change, __ATOMIC_RELAXED);
+        long peak = __atomic_load_n(&s->peak, __ATOMIC_RELAXED);
+
+        while (current > peak && !__atomic_compare_exchange_n(&s->peak, &peak, current, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            ;
+
+        if(is_alloc)
+            __atomic_add_fetch(&s->N_allocs, 1, __ATOMIC_RELAXED);
+        else
+            __atomic_add_fetch(&s->N_frees, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Allocate memory, and account for it.
+ * @pre \code{.c}
+ * tag < TM_MEM_LAST
+ * \endcode
+ * @param size number of bytes
+ * @param tag subsystem to which the memory belongs
+ * @return a pointer to the memory (which must be free'd with tm_free()), or \p NULL if \p malloc failed
+ */
+void* tm_malloc(size_t size, tm_memory_tag tag) {
+    assert(tag < TM_MEM_LAST);
+
+    memory_header* header = malloc(sizeof(memory_header) + size);
+    if(header == NULL)
+        return NULL;
+
+    header->size = size;
+    header->tag = tag;
+    header->offset = 0;
+    memory_account(tag, (long) size, 1);
+
+    return header + 1;
+}
+
+/**
+ * Allocate zero-initialized memory for an array, and account for it.
+ * @pre \code{.c}
+ * tag < TM_MEM_LAST
+ * \endcode
+ * @param n number of elements
+ * @param size size of an element
+ * @param tag subsystem to which the memory belongs
+ * @return a pointer to the memory (which must be free'd with tm_free()), or \p NULL if \p malloc failed (or if the size overflows)
+ */
+void* tm_calloc(size_t n, size_t size, tm_memory_tag tag) {
+    assert(tag < TM_MEM_LAST);
+
+    if(size != 0 && n > ((size_t) -1 - sizeof(memory_header)) / size)
+        return NULL;
+
+    void* ptr = tm_malloc(n * size, tag);
+    if(ptr != NULL)
+        memset(ptr, 0, n * size);
+
+    return ptr;
+}
+
+/**
+ * Allocate zero-initialized memory for an array, aligned on \p TM_MEMORY_ALIGNMENT bytes, and account for it.
+ * @pre \code{.c}
+ * tag < TM_MEM_LAST
+ * \endcode
+ * @param n number of elements
+ * @param size size of an element
+ * @param tag subsystem to which the memory belongs
+ * @return a pointer to the memory (which must be free'd with tm_free(), and cannot be resized with tm_realloc()), or
+ * \p NULL if \p malloc failed (or if the size overflows)
+ */
+void* tm_calloc_aligned(size_t n, size_t size, tm_memory_tag tag) {
+    assert(tag < TM_MEM_LAST);
+
+    size_t extra = sizeof(memory_header) + TM_MEMORY_ALIGNMENT;
+    if(size != 0 && n > ((size_t) -1 - extra) / size)
+        return NULL;
+
+    char* start = malloc(extra + n * size);
+    if(start == NULL)
+        return NULL;
+
+    // first aligned address after the header
+    uintptr_t block = ((uintptr_t) start + sizeof(memory_header) + TM_MEMORY_ALIGNMENT - 1) & ~((uintptr_t) TM_MEMORY_ALIGNMENT - 1);
+    memory_header* header = ((memory_header*) block) - 1;
+
+    header->size = n * size;
+    header->tag = tag;
+    header->offset = (uint32_t) ((char*) header - start);
+    memory_account(tag, (long) header->size, 1);
+
+    memset((void*) block, 0, n * size);
+
+    return (void*) block;
+}
+
+/**
+ * Change the size of a block, and account for it.
+ * @pre \code{.c}
+ * tag < TM_MEM_LAST && (ptr == NULL || ptr was not allocated by tm_calloc_aligned())
+ * \endcode
+ * @param ptr the block (allocated by tm_malloc() or tm_realloc()), or \p NULL
+ * @param size the new number of bytes
+ * @param tag subsystem to which the memory belongs (for a new block)
+ * @return a pointer to the memory, or \p NULL if \p realloc failed (then, \p ptr is left untouched)
+ */
+void* tm_realloc(void* ptr, size_t size, tm_memory_tag tag) {
+    assert(tag < TM_MEM_LAST);
+
+    if(ptr == NULL)
+        return tm_malloc(size, tag);
+
+    memory_header* header = ((memory_header*) ptr) - 1;
+    assert(header->offset == 0);
+
+    size_t old_size = header->size;
+    tag = (tm_memory_tag) header->tag;
+
+    header = realloc(header, sizeof(memory_header) + size);
+    if(header == NULL)
+        return NULL;
+
+    header->size = size;
+    memory_account(tag, (long) size - (long) old_size, 1);
+
+    return header + 1;
+}
+
+/**
+ * Free a block.
+ * @param ptr the block (allocated by tm_malloc(), tm_realloc() or tm_calloc_aligned()), or \p NULL
+ */
+void tm_free(void* ptr) {
+    if(ptr == NULL)
+        return;
+
+    memory_header* header = ((memory_header*) ptr) - 1;
+    memory_account((tm_memory_tag) header->tag, -((long) header->size), 0);
+
+    free((char*) header - header->offset);
+}
+
+/**
+ * Get the memory statistics of a subsystem.
+ * @pre \code{.c}
+ * tag <= TM_MEM_LAST && s != NULL
+ * \endcode
+ * @param tag the subsystem (\p TM_MEM_LAST for all of them)
+ * @param[out] s the statistics
+ * @return \p TM_ERR_OK
+ */
+int tm_memory_stats_get(tm_memory_tag tag, tm_memory_stats* s) {
+    assert(tag <= TM_MEM_LAST && s != NULL);
+
+    s->current = __atomic_load_n(&stats[tag].current, __ATOMIC_RELAXED);
+    s->peak = __atomic_load_n(&stats[tag].peak, __ATOMIC_RELAXED);
+    s->N_allocs = __atomic_load_n(&stats[tag].N_allocs, __ATOMIC_RELAXED);
+    s->N_frees = __atomic_load_n(&stats[tag].N_frees, __ATOMIC_RELAXED);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Get the name of a subsystem.
+ * @pre \code{.c}
+ * tag <= TM_MEM_LAST
+ * \endcode
+ * @param tag the subsystem
+ * @return its name
+ */
+char* tm_memory_tag_name(tm_memory_tag tag) {
+    assert(tag <= TM_MEM_LAST);
+
+    return tag_names[tag];
+}
+
+/**
+ * Print the memory statistics of each subsystem.
+ * @pre \code{.c}
+ * f != NULL
+ * \endcode
+ * @param f where to print
+ * @return \p TM_ERR_OK
+ */
+int tm_memory_report(FILE* f) {
+    assert(f != NULL);
+
+    tm_memory_stats s;
+
+    fprintf(f, "%-16s %14s %14s %10s %10s\n", "memory", "current (B)", "peak (B)", "allocs", "frees");
+    for(int i=0; i <= TM_MEM_LAST; i++) {
+        tm_memory_stats_get(i, &s);
+        fprintf(f, "%-16s %14ld %14ld %10ld %10ld\n", tag_names[i], s.current, s.peak, s.N_allocs, s.N_frees);
+    }
+
+    return TM_ERR_OK;
+}
@@ -0,0 +1,59 @@
+#ifndef TOYMC_MEMORY_H
+#define TOYMC_MEMORY_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// alignment of the blocks of tm_calloc_aligned() (a cache line)
+#define TM_MEMORY_ALIGNMENT 64
+
+// number of elements of the widest SIMD vectors that arrays are padded for (16 floats or 64 bytes, a cache line)
+#define TM_MEMORY_SIMD_WIDTH 16
+
+// number of elements of an array of n elements, padded so that the next array is aligned as well (if the elements are
+// at least 4 bytes long), and that SIMD loops can process it in full vectors (of up to TM_MEMORY_SIMD_WIDTH elements)
+#define TM_MEMORY_PADDED(n) (((n) + TM_MEMORY_SIMD_WIDTH - 1) / TM_MEMORY_SIMD_WIDTH * TM_MEMORY_SIMD_WIDTH)
+
+// index n, rounded down to the start of its SIMD vector (so that loops from there start on a full, aligned vector)
+#define TM_MEMORY_ROUNDED_DOWN(n) ((n) / TM_MEMORY_SIMD_WIDTH * TM_MEMORY_SIMD_WIDTH)
+
+/**
+ * @brief Subsystem to which an allocation belongs
+ */
+typedef enum tm_memory_tag_ {
+    TM_MEM_GEOMETRY, // geometries
+    TM_MEM_SIMULATION, // positions and scratch space of the simulation
+    TM_MEM_PARAMETERS, // parameter files (trees, arenas) and simulation parameters
+    TM_MEM_IO, // file buffers, readers and writers
+    TM_MEM_INSTRUMENTATION, // profiling, histograms, status, etc
+
+    TM_MEM_LAST // the sum of all the others
+} tm_memory_tag;
+
+/**
+ * @brief Memory statistics
+ * Fields are \code{.c}
+ * long current; // bytes currently allocated
+ * long peak; // maximum number of bytes allocated at the same time
+ * long N_allocs; // number of allocations (including reallocations)
+ * long N_frees; // number of deallocations
+ * \endcode
+ */
+typedef struct tm_memory_stats_ {
+    long current;
+    long peak;
+    long N_allocs;
+    long N_frees;
+} tm_memory_stats;
+
+void* tm_malloc(size_t size, tm_memory_tag tag);
+void* tm_calloc(size_t n, size_t size, tm_memory_tag tag);
+void* tm_realloc(void* ptr, size_t size, tm_memory_tag tag);
+void* tm_calloc_aligned(size_t n, size_t size, tm_memory_tag tag);
+void tm_free(void* ptr);
+
+int tm_memory_stats_get(tm_memory_tag tag, tm_memory_stats* stats);
+char* tm_memory_tag_name(tm_memory_tag tag);
+int tm_memory_report(FILE* f);
+
+#endif //TOYMC_MEMORY_H
@@ -0,0 +1,238 @@
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include "observables.h"
+#include "memory.h"
+#include "errors.h"
+
+#define CSV_HEADER "sweep,N_moves,N_accepted,U,P\n"
+
+/**
+ * Create a sink, and write the header of the file.
+ * @pre \code{.c}
+ * path != NULL
+ * \endcode
+ * @param path path of the file (overwritten if it exists)
+ * @param format format of the file
+ * @return a new sink, \p NULL if the file cannot be opened or \p malloc failed
+ */
+tm_observables_sink* tm_observables_sink_new(char* path, tm_observables_format format) {
+    assert(path != NULL);
+
+    tm_observables_sink* sink = tm_malloc(sizeof(tm_observables_sink), TM_MEM_IO);
+    if(sink == NULL)
+        return NULL;
+
+    sink->format = format;
+    sink->N_buffered = 0;
+    sink->N_records = 0;
+
+    sink->buffer = tm_malloc(TM_OBSERVABLES_BUFFER_SIZE * sizeof(tm_observables_record), TM_MEM_IO);
+    if(sink->buffer == NULL) {
+        tm_free(sink);
+        return NULL;
+    }
+
+    sink->f = fopen(path, "wb");
+    if(sink->f == NULL) {
+        TM_ERROR("cannot open %s", path);
+        tm_free(sink->buffer);
+        tm_free(sink);
+        return NULL;
+    }
+
+    int ok;
+    if(format == TM_OBSERVABLES_BINARY) {
+        uint32_t record_size = sizeof(tm_observables_record);
+        ok = fwrite(TM_OBSERVABLES_MAGIC, 1, 4, sink->f) == 4 && fwrite(&record_size, sizeof(uint32_t), 1, sink->f) == 1;
+    } else {
+        ok = fputs(CSV_HEADER, sink->f) >= 0;
+    }
+
+    if(!ok) {
+        fclose(sink->f);
+        tm_free(sink->buffer);
+        tm_free(sink);
+        return NULL;
+    }
+
+    return sink;
+}
+
+/**
+ * Append a record. It is only written to the file once the buffer is full.
+ * @pre \code{.c}
+ * sink != NULL && record != NULL
+ * \endcode
+ * @param sink the sink
+ * @param record the record (copied)
+ * @return \p TM_ERR_OK if everything went well, \p TM_ERR_WRITE if the buffer could not be written
+ */
+int tm_observables_sink_append(tm_observables_sink* sink, tm_observables_record* record) {
+    assert(sink != NULL && record != NULL);
+
+    sink->buffer[sink->N_buffered] = *record;
+    sink->N_buffered++;
+    sink->N_records++;
+
+    if(sink->N_buffered == TM_OBSERVABLES_BUFFER_SIZE)
+        return tm_observables_sink_flush(sink);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Write the buffered records to the file.
+ * @pre \code{.c}
+ * sink != NULL
+ * \endcode
+ * @param sink the sink
+ * @return \p TM_ERR_OK if everything went well, \p TM_ERR_WRITE otherwise
+ * @post the buffer is empty (records that could not be written are lost).
+ */
+int tm_observables_sink_flush(tm_observables_sink* sink) {
+    assert(sink != NULL);
+
+    int ok = 1;
+    if(sink->format == TM_OBSERVABLES_BINARY) {
+        ok = fwrite(sink->buffer, sizeof(tm_observables_record), sink->N_buffered, sink->f) == (size_t) sink->N_buffered;
+    } else {
+        for(int i=0; i < sink->N_buffered && ok; i++) {
+            tm_observables_record* r = &(sink->buffer[i]);
+            ok = fprintf(
+                    sink->f, "%" PRId64 ",%" PRId64 ",%" PRId64 ",%.17g,%.17g\n",
+                    r->sweep, r->N_moves, r->N_accepted, r->U, r->P) > 0;
+        }
+    }
+
+    sink->N_buffered = 0;
+
+    if(!ok || fflush(sink->f) != 0)
+        return TM_ERR_WRITE;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Flush and close the file, then delete the sink.
+ * @pre \code{.c}
+ * sink != NULL
+ * \endcode
+ * @param sink the sink
+ * @return \p TM_ERR_OK if everything went well, \p TM_ERR_WRITE if the last records could not be written
+ */
+int tm_observables_sink_delete(tm_observables_sink* sink) {
+    assert(sink != NULL);
+
+    int error = tm_observables_sink_flush(sink);
+
+    if(fclose(sink->f) != 0)
+        error = TM_ERR_WRITE;
+
+    tm_free(sink->buffer);
+    tm_free(sink);
+
+    return error;
+}
+
+// make room for one more record
+static int records_grow(tm_observables_record** records, long N, long* capacity) {
+    if(N < *capacity)
+        return TM_ERR_OK;
+
+    long new_capacity = *capacity < 64 ? 128 : 2 * *capacity;
+    tm_observables_record* new_records = tm_realloc(*records, new_capacity * sizeof(tm_observables_record), TM_MEM_IO);
+    if(new_records == NULL)
+        return TM_ERR_MALLOC;
+
+    *records = new_records;
+    *capacity = new_capacity;
+    return TM_ERR_OK;
+}
+
+/**
+ * Read all the records of a file written by a sink, whatever its format.
+ * @pre \code{.c}
+ * f != NULL && records != NULL && N != NULL
+ * \endcode
+ * @param f a file open at its beginning (in binary mode)
+ * @param records (output) the records, allocated with tm_malloc(), caller is responsible to free it (with tm_free())
+ * @param N (output) number of records
+ * @return \p TM_ERR_OK if everything went well, \p TM_ERR_READ if the file is not valid, something else otherwise.
+ * @post \p *records is \p NULL if an error occurred.
+ */
+int tm_observables_read(FILE* f, tm_observables_record** records, long* N) {
+    assert(f != NULL && records != NULL && N != NULL);
+
+    long capacity = 0;
+    int error = TM_ERR_OK;
+    char line[256];
+
+    *records = NULL;
+    *N = 0;
+
+    // binary or CSV?
+    if(fgets(line, 5, f) == NULL)
+        return TM_ERR_READ;
+
+    if(strcmp(line, TM_OBSERVABLES_MAGIC) == 0) {
+        uint32_t record_size;
+        if(fread(&record_size, sizeof(uint32_t), 1, f) != 1 || record_size != sizeof(tm_observables_record)) {
+            TM_ERROR("records are not of the expected size");
+            return TM_ERR_READ;
+        }
+
+        while(error == TM_ERR_OK) {
+            error = records_grow(records, *N, &capacity);
+            if(error != TM_ERR_OK)
+                break;
+
+            size_t n = fread(*records + *N, sizeof(tm_observables_record), capacity - *N, f);
+            *N += (long) n;
+
+            if(*N < capacity) {
+                if(ferror(f) || !feof(f))
+                    error = TM_ERR_READ;
+                break;
+            }
+        }
+    } else {
+        // rest of the header
+        size_t length = strlen(line);
+        if(fgets(line + length, (int) (256 - length), f) == NULL || strcmp(line, CSV_HEADER) != 0) {
+            TM_ERROR("not an observables file");
+            return TM_ERR_READ;
+        }
+
+        while(error == TM_ERR_OK && fgets(line, 256, f) != NULL) {
+            error = records_grow(records, *N, &capacity);
+            if(error != TM_ERR_OK)
+                break;
+
+            tm_observables_record* r = *records + *N;
+            if(sscanf(
+                    line, "%" SCNd64 ",%" SCNd64 ",%" SCNd64 ",%lf,%lf",
+                    &(r->sweep), &(r->N_moves), &(r->N_accepted), &(r->U), &(r->P)) != 5) {
+                TM_ERROR("wrong record on line %ld", *N + 2);
+                error = TM_ERR_READ;
+            }
+
+            (*N)++;
+        }
+
+        if(ferror(f))
+            error = TM_ERR_READ;
+    }
+
+    if(error != TM_ERR_OK) {
+        if(*records != NULL)
+            tm_free(*records);
+
+        *records = NULL;
+        *N = 0;
+    }
+
+    return error;
+}
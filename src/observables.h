@@ -0,0 +1,65 @@
+#ifndef TOYMC_OBSERVABLES_H
+#define TOYMC_OBSERVABLES_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// number of records kept in memory before they are written
+#define TM_OBSERVABLES_BUFFER_SIZE 512
+
+// first bytes of a binary file, followed by the size of a record (as an `uint32_t`)
+#define TM_OBSERVABLES_MAGIC "TMOB"
+
+/**
+ * @brief Observables at a given sweep.
+ * Binary files contain these records as is, so they have a fixed size and no padding.
+ * Fields are \code{.c}
+ * int64_t sweep; // number of sweeps done
+ * int64_t N_moves; // number of trial moves (since the beginning)
+ * int64_t N_accepted; // number of accepted moves (since the beginning)
+ * double U; // energy
+ * double P; // pressure (NaN if it was not sampled at that sweep)
+ * \endcode
+ */
+typedef struct tm_observables_record_ {
+    int64_t sweep;
+    int64_t N_moves;
+    int64_t N_accepted;
+    double U;
+    double P;
+} tm_observables_record;
+
+/**
+ * @brief Format of an observables file
+ */
+typedef enum tm_observables_format_ {
+    TM_OBSERVABLES_BINARY, // header, then records
+    TM_OBSERVABLES_CSV, // header line, then one line per record
+} tm_observables_format;
+
+/**
+ * @brief Append records to a file. Records are buffered, and only written when the buffer is full (or flushed).
+ * Fields are \code{.c}
+ * FILE* f; // the file
+ * tm_observables_format format; // its format
+ * tm_observables_record* buffer; // records that are not written yet
+ * int N_buffered; // number of records in the buffer
+ * long N_records; // total number of records appended
+ * \endcode
+ */
+typedef struct tm_observables_sink_ {
+    FILE* f;
+    tm_observables_format format;
+    tm_observables_record* buffer;
+    int N_buffered;
+    long N_records;
+} tm_observables_sink;
+
+tm_observables_sink* tm_observables_sink_new(char* path, tm_observables_format format);
+int tm_observables_sink_append(tm_observables_sink* sink, tm_observables_record* record);
+int tm_observables_sink_flush(tm_observables_sink* sink);
+int tm_observables_sink_delete(tm_observables_sink* sink);
+
+int tm_observables_read(FILE* f, tm_observables_record** records, long* N);
+
+#endif //TOYMC_OBSERVABLES_H
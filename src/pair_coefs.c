@@ -0,0 +1,130 @@
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "pair_coefs.h"
+#include "memory.h"
+#include "errors.h"
+
+static char* MIXING_RULE_NAMES[] = {
+        "lorentz-berthelot",
+        "geometric"
+};
+
+/**
+ * Create the coefficients of each pair of types, from the parameters of each type.
+ * @pre \code{.c}
+ * N_types > 0 && epsilon != NULL && sigma != NULL && rc > 0 && 0 <= rule < TM_MIXING_LAST
+ * \endcode
+ * @param N_types number of types
+ * @param epsilon depth of the well of each type, as array of size N_types
+ * @param sigma distance at which the potential of each type is zero, as array of size N_types
+ * @param rc cutoff distance, in unit of the sigma of each pair
+ * @param rule mixing rule
+ * @post the potential is LJ
+ * @return the coefficients, \p NULL if \p malloc failed
+ */
+tm_pair_coefs* tm_pair_coefs_new(int N_types, double* epsilon, double* sigma, double rc, tm_mixing_rule rule) {
+    assert(N_types > 0 && epsilon != NULL && sigma != NULL && rc > 0);
+    assert(rule >= 0 && rule < TM_MIXING_LAST);
+
+    tm_pair_coefs* coefs = tm_malloc(sizeof(tm_pair_coefs), TM_MEM_SIMULATION);
+    if(coefs == NULL)
+        return NULL;
+
+    // all tables in one block
+    coefs->N_types = N_types;
+    coefs->rc = rc;
+    coefs->epsilon = tm_malloc((3 + TM_POTENTIAL_MAX_PARAMS) * N_types * N_types * sizeof(double), TM_MEM_SIMULATION);
+    if(coefs->epsilon == NULL) {
+        tm_free(coefs);
+        return NULL;
+    }
+
+    coefs->sigma = coefs->epsilon + N_types * N_types;
+    coefs->rc2 = coefs->sigma + N_types * N_types;
+    coefs->params = coefs->rc2 + N_types * N_types;
+
+    for(int a=0; a < N_types; a++) {
+        for(int b=0; b < N_types; b++) {
+            double eps = sqrt(epsilon[a] * epsilon[b]), sig;
+            if(rule == TM_MIXING_LORENTZ_BERTHELOT)
+                sig = (sigma[a] + sigma[b]) / 2;
+            else
+                sig = sqrt(sigma[a] * sigma[b]);
+
+            coefs->epsilon[a * N_types + b] = eps;
+            coefs->sigma[a * N_types + b] = sig;
+        }
+    }
+
+    tm_potential* LJ;
+    tm_potential_find("lj", &LJ);
+    tm_pair_coefs_use_potential(coefs, LJ, 0);
+
+    return coefs;
+}
+
+/**
+ * Compute the parameters of each pair of types for another potential.
+ * @pre \code{.c}
+ * coefs != NULL && potential != NULL && TM_POTENTIAL_ALPHA_IS_VALID(potential, alpha)
+ * \endcode
+ * @param coefs the coefficients
+ * @param potential the potential
+ * @param alpha shape parameter of the potential (if it uses one), 0 for the default of the potential
+ * @post \p coefs->potential is \p potential, and \p coefs->params and \p coefs->rc2 are set accordingly.
+ */
+void tm_pair_coefs_use_potential(tm_pair_coefs* coefs, tm_potential* potential, double alpha) {
+    assert(coefs != NULL && potential != NULL && TM_POTENTIAL_ALPHA_IS_VALID(potential, alpha));
+
+    if(alpha == 0)
+        alpha = potential->alpha;
+
+    coefs->potential = potential;
+
+    for(int p=0; p < coefs->N_types * coefs->N_types; p++) {
+        coefs->rc2[p] = coefs->rc * coefs->rc * coefs->sigma[p] * coefs->sigma[p];
+        potential->setup(
+                coefs->epsilon[p], coefs->sigma[p], alpha, coefs->params + p * TM_POTENTIAL_MAX_PARAMS, &(coefs->rc2[p]));
+    }
+}
+
+/**
+ * Delete the coefficients.
+ * @pre \code{.c}
+ * coefs != NULL
+ * \endcode
+ * @param coefs the coefficients
+ * @return \p TM_ERR_OK
+ */
+int tm_pair_coefs_delete(tm_pair_coefs* coefs) {
+    assert(coefs != NULL);
+
+    tm_free(coefs->epsilon);
+    tm_free(coefs);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Find a mixing rule by its name (\p "lorentz-berthelot" or \p "geometric").
+ * @pre \code{.c}
+ * name != NULL && rule != NULL
+ * \endcode
+ * @param name the name
+ * @param rule (output) the rule
+ * @return \p TM_ERR_OK if the rule exists, \p TM_ERR_NOT_FOUND otherwise
+ */
+int tm_mixing_rule_find(char* name, tm_mixing_rule* rule) {
+    assert(name != NULL && rule != NULL);
+
+    for(int i=0; i < TM_MIXING_LAST; i++) {
+        if(strcmp(name, MIXING_RULE_NAMES[i]) == 0) {
+            *rule = (tm_mixing_rule) i;
+            return TM_ERR_OK;
+        }
+    }
+
+    return TM_ERR_NOT_FOUND;
+}
@@ -0,0 +1,46 @@
+#ifndef TOYMC_PAIR_COEFS_H
+#define TOYMC_PAIR_COEFS_H
+
+#include "potentials.h"
+
+/**
+ * @brief How the LJ parameters of a pair of different types are obtained
+ */
+typedef enum tm_mixing_rule_ {
+    TM_MIXING_LORENTZ_BERTHELOT, // arithmetic mean of the sigmas, geometric mean of the epsilons
+    TM_MIXING_GEOMETRIC, // geometric mean of both
+
+    TM_MIXING_LAST
+} tm_mixing_rule;
+
+/**
+ * @brief Parameters of the potential of each pair of types, which is zero for \f$r^2 \geq r^2_{c,ab}\f$.
+ * Each table is an array of size N_types*N_types, where pair (a, b) is at a * N_types + b
+ * (and its parameters at (a * N_types + b) * TM_POTENTIAL_MAX_PARAMS in \p params).
+ * Fields are \code{.c}
+ * int N_types; // number of types
+ * double rc; // cutoff distance, in unit of the sigma of each pair
+ * tm_potential* potential; // the potential (LJ by default)
+ * double* epsilon; // mixed epsilon
+ * double* sigma; // mixed sigma
+ * double* rc2; // square of the cutoff distance
+ * double* params; // parameters of the potential
+ * \endcode
+ */
+typedef struct tm_pair_coefs_ {
+    int N_types;
+    double rc;
+    tm_potential* potential;
+    double* epsilon;
+    double* sigma;
+    double* rc2;
+    double* params;
+} tm_pair_coefs;
+
+tm_pair_coefs* tm_pair_coefs_new(int N_types, double* epsilon, double* sigma, double rc, tm_mixing_rule rule);
+void tm_pair_coefs_use_potential(tm_pair_coefs* coefs, tm_potential* potential, double alpha);
+int tm_pair_coefs_delete(tm_pair_coefs* coefs);
+
+int tm_mixing_rule_find(char* name, tm_mixing_rule* rule);
+
+#endif //TOYMC_PAIR_COEFS_H
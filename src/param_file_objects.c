@@ -1,33 +1,75 @@
 #include <assert.h>
 #include "param_file_objects.h"
+#include "memory.h"
 
 /* objects */
 
 /**
- * Create an input file object of type \p t.
+ * Allocate \p size bytes, in the same place as \p obj (the arena or the heap).
+ * @param obj the object
+ * @param size number of bytes
+ * @return the memory, or \p NULL if the allocation failed
+ */
+static void* parf_alloc(tm_parf_t* obj, size_t size) {
+    return obj->arena != NULL ? tm_arena_alloc(obj->arena, size) : tm_malloc(size, TM_MEM_PARAMETERS);
+}
+
+/**
+ * Release memory obtained with \p parf_alloc() (which does nothing if \p obj lives in an arena).
+ * @param obj the object
+ * @param ptr the memory
+ */
+static void parf_free(tm_parf_t* obj, void* ptr) {
+    if(obj->arena == NULL)
+        tm_free(ptr);
+}
+
+/**
+ * Create an input file object of type \p t, in \p arena.
+ * @param arena the arena, or \p NULL to allocate the object on the heap
  * @param t the type
  * @post object is initialized with type \p t.
- * @return the initialized object, or \p NULL if malloc failed
+ * @return the initialized object, or \p NULL if the allocation failed
  */
-tm_parf_t* tm_parf_new(tm_parf_type t) {
+tm_parf_t* tm_parf_new_in(tm_arena* arena, tm_parf_type t) {
     tm_parf_t* j = NULL;
-    j = malloc(sizeof(tm_parf_t));
+    j = arena != NULL ? tm_arena_alloc(arena, sizeof(tm_parf_t)) : tm_malloc(sizeof(tm_parf_t), TM_MEM_PARAMETERS);
     if (j != NULL) {
         j->val_type = t;
 
         j->key = NULL;
+        j->arena = arena;
+        j->owns_arena = 0;
         j->val_obj_or_list = NULL;
         j->last = NULL;
         j->val_str = NULL;
         j->next = NULL;
         j->val_size = 0;
+        j->val_items = NULL;
+        j->val_capacity = 0;
+        j->val_hash = NULL;
+        j->val_hash_size = 0;
+        j->val_packed = TM_T_LAST;
+        j->val_array = NULL;
     }
 
     return j;
 }
 
 /**
- * Delete \p obj.
+ * Create an input file object of type \p t.
+ * @param t the type
+ * @post object is initialized with type \p t.
+ * @return the initialized object, or \p NULL if malloc failed
+ */
+tm_parf_t* tm_parf_new(tm_parf_type t) {
+    return tm_parf_new_in(NULL, t);
+}
+
+/**
+ * Delete \p obj, and the objects that follow (\p next).
+ * Objects that live in an arena are not released one by one, but the tree is still walked to release the objects
+ * that were allocated on the heap and attached to it. If \p obj owns its arena, the whole arena is then released.
  * @pre \code{.c} obj != NULL \endcode
  * @param obj the object to delete
  * @return \p TM_ERR_OK
@@ -35,19 +77,137 @@ tm_parf_t* tm_parf_new(tm_parf_type t) {
 int tm_parf_delete(tm_parf_t* obj) {
     assert(obj != NULL);
 
-    if(obj->next != NULL)
-        tm_parf_delete(obj->next);
+    tm_arena* owned_arena = obj->owns_arena ? obj->arena : NULL;
+
+    tm_parf_t* next;
+    while (obj != NULL) { // iterate rather than recurse over the next ones
+        next = obj->next;
+
+        if ((TM_parf_IS(obj, TM_T_OBJECT) || TM_parf_IS(obj, TM_T_LIST)) && obj->val_obj_or_list != NULL)
+            tm_parf_delete(obj->val_obj_or_list);
+
+        if(obj->arena == NULL) {
+            if(obj->key != NULL)
+                tm_free(obj->key);
+
+            if(TM_parf_IS(obj, TM_T_STRING) && obj->val_str != NULL)
+                tm_free(obj->val_str);
+
+            if(obj->val_items != NULL)
+                tm_free(obj->val_items);
+
+            if(obj->val_hash != NULL)
+                tm_free(obj->val_hash);
+
+            if(obj->val_array != NULL)
+                tm_free(obj->val_array);
+
+            tm_free(obj);
+        }
+
+        obj = next;
+    }
+
+    if(owned_arena != NULL)
+        tm_arena_delete(owned_arena);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Add \p val at the end of the elements of \p obj (\p val_items and the chain).
+ * @param obj the list or object
+ * @param val the value
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+static int parf_items_append(tm_parf_t* obj, tm_parf_t* val) {
+    if(obj->val_size == obj->val_capacity) {
+        unsigned int new_capacity = obj->val_capacity == 0 ? 8 : 2 * obj->val_capacity;
+        tm_parf_t** new_items = parf_alloc(obj, new_capacity * sizeof(tm_parf_t*));
+        if(new_items == NULL)
+            return TM_ERR_MALLOC;
+
+        if(obj->val_items != NULL) {
+            memcpy(new_items, obj->val_items, obj->val_size * sizeof(tm_parf_t*));
+            parf_free(obj, obj->val_items);
+        }
+
+        obj->val_items = new_items;
+        obj->val_capacity = new_capacity;
+    }
+
+    obj->val_items[obj->val_size] = val;
+
+    if(obj->val_obj_or_list == NULL) {
+        obj->val_obj_or_list = val;
+        obj->last = val;
+    } else {
+        obj->last->next = val;
+        obj->last = val;
+    }
+
+    obj->val_size += 1;
+    return TM_ERR_OK;
+}
 
-    if(obj->key != NULL)
-        free(obj->key);
+/**
+ * Hash (FNV-1a) of a key
+ * @param key the key (NUL-terminated)
+ * @return the hash
+ */
+static unsigned int parf_hash(char* key) {
+    unsigned int h = 2166136261u;
+    for(; *key != '\0'; key++) {
+        h ^= (unsigned char) *key;
+        h *= 16777619u;
+    }
 
-    if(TM_parf_IS(obj, TM_T_STRING) && obj->val_str != NULL)
-        free(obj->val_str);
+    return h;
+}
 
-    if ((TM_parf_IS(obj, TM_T_OBJECT) || TM_parf_IS(obj, TM_T_LIST)) && obj->val_obj_or_list != NULL)
-        tm_parf_delete(obj->val_obj_or_list);
+/**
+ * Find the slot of the hash table of \p obj that contains \p key, or the empty slot where it should be inserted.
+ * @pre \code{.c}
+ * obj->val_hash != NULL
+ * \endcode
+ * @param obj the object
+ * @param key the key
+ * @return the slot
+ */
+static unsigned int parf_hash_slot(tm_parf_t* obj, char* key) {
+    unsigned int mask = obj->val_hash_size - 1;
+    unsigned int slot = parf_hash(key) & mask;
 
-    free(obj);
+    while(obj->val_hash[slot] != 0 && strcmp(obj->val_items[obj->val_hash[slot] - 1]->key, key) != 0)
+        slot = (slot + 1) & mask; // linear probing
+
+    return slot;
+}
+
+/**
+ * Make sure that the hash table of \p obj can hold one more key (load factor below 1/2).
+ * @param obj the object
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+static int parf_hash_reserve(tm_parf_t* obj) {
+    if(2 * (obj->val_size + 1) <= obj->val_hash_size)
+        return TM_ERR_OK;
+
+    unsigned int new_size = obj->val_hash_size == 0 ? 16 : 2 * obj->val_hash_size;
+    unsigned int* new_hash = parf_alloc(obj, new_size * sizeof(unsigned int));
+    if(new_hash == NULL)
+        return TM_ERR_MALLOC;
+
+    if(obj->val_hash != NULL)
+        parf_free(obj, obj->val_hash);
+
+    memset(new_hash, 0, new_size * sizeof(unsigned int));
+    obj->val_hash = new_hash;
+    obj->val_hash_size = new_size;
+
+    // re-insert
+    for(unsigned int i = 0; i < obj->val_size; i++)
+        obj->val_hash[parf_hash_slot(obj, obj->val_items[i]->key)] = i + 1;
 
     return TM_ERR_OK;
 }
@@ -78,51 +238,69 @@ tm_parf_t* tm_parf_object_new() {
  * @return \p TM_ERR_OK, except if this was not possible to alocate space for the key (\p TM_ERR_MALLOC)
  */
 int tm_parf_object_set(tm_parf_t* obj, char* key, tm_parf_t* val) {
+    assert(key != NULL);
+
+    return tm_parf_object_set_n(obj, key, strlen(key), val);
+}
+
+/**
+ * Set value at \p key (of length \p len, not necessarily NUL-terminated) to \p val
+ * @pre \code{.c}
+ * obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_OBJECT)
+ * && key != NULL && val != NULL
+ * \endcode
+ * @param obj the object
+ * @param key the key
+ * @param len the length of the key
+ * @param val the new value
+ * @post value at key \p key is set to \p val
+ * @return \p TM_ERR_OK, except if this was not possible to alocate space for the key (\p TM_ERR_MALLOC)
+ */
+int tm_parf_object_set_n(tm_parf_t* obj, char* key, unsigned int len, tm_parf_t* val) {
     assert(!TM_PARF_CHECK_P(obj, TM_T_OBJECT));
     assert(key != NULL && val != NULL);
 
     // key
-    val->key = malloc(sizeof(char) * (strlen(key) + 1));
+    val->key = parf_alloc(val, sizeof(char) * (len + 1));
     if(val->key == NULL)
         return TM_ERR_MALLOC;
 
-    strcpy(val->key, key);
-
+    memcpy(val->key, key, len);
+    val->key[len] = '\0';
+    key = val->key;
 
     // value
-    tm_parf_t* o = obj->val_obj_or_list, *prev = NULL;
-    int set = 0;
-    while (o != NULL) { // look first if it does exist
-        if(strcmp(o->key, key) == 0) {
-            val->next = o->next;
-            o->next = NULL;
-            tm_parf_delete(o);
-            if(prev == NULL)
-                obj->val_obj_or_list = val;
-            else
-                prev->next = val;
-
-            if(val->next == NULL)
-                obj->last = val;
-
-            set = 1;
-            break;
-        }
+    int r = parf_hash_reserve(obj);
+    if(r != TM_ERR_OK)
+        return r;
 
-        prev = o;
-        o = o->next;
-    }
-    if(!set) { // if not, adds it
-        if(obj->val_obj_or_list == NULL) {
+    unsigned int slot = parf_hash_slot(obj, key);
+
+    if(obj->val_hash[slot] != 0) { // it does exist, so replace it
+        unsigned int index = obj->val_hash[slot] - 1;
+        tm_parf_t* o = obj->val_items[index];
+
+        val->next = o->next;
+        o->next = NULL;
+        tm_parf_delete(o);
+
+        if(index == 0)
             obj->val_obj_or_list = val;
+        else
+            obj->val_items[index - 1]->next = val;
+
+        if(val->next == NULL)
             obj->last = val;
-        } else {
-            obj->last->next = val;
-            obj->last = val;
-        }
 
-        obj->val_size += 1;
+        obj->val_items[index] = val;
+    } else { // if not, adds it
+        r = parf_items_append(obj, val);
+        if(r != TM_ERR_OK)
+            return r;
+
+        obj->val_hash[slot] = obj->val_size;
     }
+
     return TM_ERR_OK;
 }
 
@@ -136,22 +314,20 @@ int tm_parf_object_set(tm_parf_t* obj, char* key, tm_parf_t* val) {
  * @param key the key
  * @param val the value
  * @post \p val point on the value
- * @return \p TM_ERR_OK
+ * @return \p TM_ERR_OK if the key exists, \p TM_ERR_NOT_FOUND otherwise
  */
 int tm_parf_object_get(tm_parf_t* obj, char* key, tm_parf_t** val) {
     assert(!TM_PARF_CHECK_P(obj, TM_T_OBJECT));
 
-    tm_parf_t* o = obj->val_obj_or_list;
-    while (o != NULL) {
-        if (strcmp(o->key, key) == 0) {
-            *val = o;
-            return TM_ERR_OK;
-        }
+    if(obj->val_hash == NULL)
+        return TM_ERR_NOT_FOUND;
 
-        o = o->next;
-    }
+    unsigned int slot = parf_hash_slot(obj, key);
+    if(obj->val_hash[slot] == 0)
+        return TM_ERR_NOT_FOUND;
 
-    return TM_ERR_NOT_FOUND;
+    *val = obj->val_items[obj->val_hash[slot] - 1];
+    return TM_ERR_OK;
 }
 
 /* boolean */
@@ -325,21 +501,40 @@ tm_parf_t* tm_parf_string_new(char* val) {
  * @return \p TM_ERR_OK
  */
 int tm_parf_string_set(tm_parf_t* object, char* val) {
+    assert(val != NULL);
+
+    return tm_parf_string_set_n(object, val, strlen(val));
+}
+
+/**
+ * Change the value of the string to the \p len first characters of \p val. Copy the string.
+ * @pre \code{.c}
+ * obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_STRING)
+ * && val != NULL
+ * \endcode
+ * @param object the string object
+ * @param val new value of the string (not necessarily NUL-terminated)
+ * @param len length of the new value
+ * @post object is set to \p val
+ * @return \p TM_ERR_OK
+ */
+int tm_parf_string_set_n(tm_parf_t* object, char* val, unsigned int len) {
     assert(!TM_PARF_CHECK_P(object, TM_T_STRING));
     assert(val != NULL);
 
     if (object->val_str != NULL) {
-        free(object->val_str);
+        parf_free(object, object->val_str);
         object->val_str = NULL;
     }
 
-    object->val_size = strlen(val);
-    object->val_str = malloc((object->val_size + 1) * sizeof(char));
+    object->val_size = len;
+    object->val_str = parf_alloc(object, (object->val_size + 1) * sizeof(char));
 
     if (object->val_str == NULL)
         return TM_ERR_MALLOC;
 
-    strcpy(object->val_str, val);
+    memcpy(object->val_str, val, len);
+    object->val_str[len] = '\0';
 
     return TM_ERR_OK;
 }
@@ -381,6 +576,48 @@ int tm_parf_string_length(tm_parf_t *object, unsigned int *s) {
 
 /* list */
 
+/**
+ * Turn a packed list into a list of objects (does nothing if the list is not packed).
+ * @param obj the list
+ * @post \p obj->val_packed is \p TM_T_LAST
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+static int parf_list_unpack(tm_parf_t* obj) {
+    if(obj->val_packed == TM_T_LAST)
+        return TM_ERR_OK;
+
+    tm_parf_type t = obj->val_packed;
+    void* array = obj->val_array;
+    unsigned int sz = obj->val_size;
+
+    obj->val_packed = TM_T_LAST;
+    obj->val_array = NULL;
+    obj->val_size = 0;
+    obj->val_capacity = 0;
+
+    int r = TM_ERR_OK;
+    tm_parf_t* o;
+    for(unsigned int i = 0; i < sz && r == TM_ERR_OK; i++) {
+        o = tm_parf_new_in(obj->arena, t);
+        if(o == NULL) {
+            r = TM_ERR_MALLOC;
+            break;
+        }
+
+        if(t == TM_T_INTEGER)
+            tm_parf_integer_set(o, ((long*) array)[i]);
+        else
+            tm_parf_real_set(o, ((double*) array)[i]);
+
+        r = parf_items_append(obj, o);
+    }
+
+    if(array != NULL)
+        parf_free(obj, array);
+
+    return r;
+}
+
 /**
  * Create an input file object of type \p TM_T_LIST
  * @return the initialized object, or \p NULL if malloc failed.
@@ -401,20 +638,146 @@ tm_parf_t* tm_parf_list_new() {
  * @param obj the list
  * @param val the value to add
  * @post \p val is added to the list
- * @return \p TM_ERR_OK
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
  */
 int tm_parf_list_append(tm_parf_t* obj, tm_parf_t* val) {
     assert(!TM_PARF_CHECK_P(obj, TM_T_LIST));
 
-    if(obj->val_obj_or_list == NULL) {
-        obj->val_obj_or_list = val;
-        obj->last = val;
-    } else {
-        obj->last->next = val;
-        obj->last = val;
+    int r = parf_list_unpack(obj);
+    if(r != TM_ERR_OK)
+        return r;
+
+    return parf_items_append(obj, val);
+}
+
+/**
+ * Append a packed value (\p long or \p double, depending on \p t) to the list, which is unpacked if needed.
+ * @param obj the list
+ * @param t the type of the value (\p TM_T_INTEGER or \p TM_T_REAL)
+ * @param val pointer to the value
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+static int parf_list_append_packed(tm_parf_t* obj, tm_parf_type t, void* val) {
+    size_t sz = t == TM_T_INTEGER ? sizeof(long) : sizeof(double);
+
+    if(obj->val_size == 0 && obj->val_packed == TM_T_LAST)
+        obj->val_packed = t;
+
+    if(obj->val_packed != t) { // not homogeneous (anymore)
+        int r = parf_list_unpack(obj);
+        if(r != TM_ERR_OK)
+            return r;
+
+        tm_parf_t* o = tm_parf_new_in(obj->arena, t);
+        if(o == NULL)
+            return TM_ERR_MALLOC;
+
+        if(t == TM_T_INTEGER)
+            tm_parf_integer_set(o, *((long*) val));
+        else
+            tm_parf_real_set(o, *((double*) val));
+
+        return parf_items_append(obj, o);
     }
 
+    if(obj->val_size == obj->val_capacity) {
+        unsigned int new_capacity = obj->val_capacity == 0 ? 8 : 2 * obj->val_capacity;
+        void* new_array = parf_alloc(obj, new_capacity * sz);
+        if(new_array == NULL)
+            return TM_ERR_MALLOC;
+
+        if(obj->val_array != NULL) {
+            memcpy(new_array, obj->val_array, obj->val_size * sz);
+            parf_free(obj, obj->val_array);
+        }
+
+        obj->val_array = new_array;
+        obj->val_capacity = new_capacity;
+    }
+
+    memcpy((char*) obj->val_array + obj->val_size * sz, val, sz);
     obj->val_size += 1;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Append an integer at the end of the list.
+ * If the list only contains integers, it is packed (no object is created).
+ * @pre \code{.c}
+ * obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_LIST)
+ * \endcode
+ * @param obj the list
+ * @param val the value to add
+ * @post \p val is added to the list
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+int tm_parf_list_append_integer(tm_parf_t* obj, long val) {
+    assert(!TM_PARF_CHECK_P(obj, TM_T_LIST));
+
+    return parf_list_append_packed(obj, TM_T_INTEGER, &val);
+}
+
+/**
+ * Append a real at the end of the list.
+ * If the list only contains reals, it is packed (no object is created).
+ * @pre \code{.c}
+ * obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_LIST)
+ * \endcode
+ * @param obj the list
+ * @param val the value to add
+ * @post \p val is added to the list
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+int tm_parf_list_append_real(tm_parf_t* obj, double val) {
+    assert(!TM_PARF_CHECK_P(obj, TM_T_LIST));
+
+    return parf_list_append_packed(obj, TM_T_REAL, &val);
+}
+
+/**
+ * Get the values of a packed list of integers, without copy.
+ * @pre \code{.c}
+ * obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_LIST)
+ * && vals != NULL && sz != NULL
+ * \endcode
+ * @param obj the list
+ * @param vals (output) pointer to the values. It belongs to the list, and is only valid until the list is modified.
+ * @param sz (output) number of values
+ * @return \p TM_ERR_OK if the list is empty or packed with integers, \p TM_ERR_PARAMETER_FILE otherwise
+ */
+int tm_parf_list_integers(tm_parf_t* obj, long** vals, unsigned int* sz) {
+    assert(!TM_PARF_CHECK_P(obj, TM_T_LIST));
+    assert(vals != NULL && sz != NULL);
+
+    if(obj->val_size > 0 && obj->val_packed != TM_T_INTEGER)
+        return TM_ERR_PARAMETER_FILE;
+
+    *vals = obj->val_array;
+    *sz = obj->val_size;
+    return TM_ERR_OK;
+}
+
+/**
+ * Get the values of a packed list of reals, without copy.
+ * @pre \code{.c}
+ * obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_LIST)
+ * && vals != NULL && sz != NULL
+ * \endcode
+ * @param obj the list
+ * @param vals (output) pointer to the values. It belongs to the list, and is only valid until the list is modified.
+ * @param sz (output) number of values
+ * @return \p TM_ERR_OK if the list is empty or packed with reals, \p TM_ERR_PARAMETER_FILE otherwise
+ */
+int tm_parf_list_reals(tm_parf_t* obj, double** vals, unsigned int* sz) {
+    assert(!TM_PARF_CHECK_P(obj, TM_T_LIST));
+    assert(vals != NULL && sz != NULL);
+
+    if(obj->val_size > 0 && obj->val_packed != TM_T_REAL)
+        return TM_ERR_PARAMETER_FILE;
+
+    *vals = obj->val_array;
+    *sz = obj->val_size;
     return TM_ERR_OK;
 }
 
@@ -437,6 +800,7 @@ int tm_parf_list_length(tm_parf_t* obj, unsigned int* sz) {
 
 /**
  * Get element \p index. If \p index is negative, start from the last element.
+ * A packed list is unpacked first.
  * @pre \code{.c}
  * obj != NULL & !TM_PARF_CHECK_P(obj, TM_T_LIST)
  * && (0 <= index < tm_parf_list_length(obj) || -tm_parf_list_length(obj) <= index < 0)
@@ -456,21 +820,18 @@ int tm_parf_list_get(tm_parf_t* obj, int index, tm_parf_t** val) {
     if(index < 0 || index >= (int) obj->val_size)
         return TM_ERR_PARAMETER_FILE;
 
-    tm_parf_t* o = obj->val_obj_or_list;
-    for(int i=0; i < index; i++) {
-        if (o == NULL)
-            return TM_ERR_NOT_FOUND;
-        o = o->next;
-    }
+    int r = parf_list_unpack(obj);
+    if(r != TM_ERR_OK)
+        return r;
 
-    *val = o;
+    *val = obj->val_items[index];
     return TM_ERR_OK;
 }
 
 /* iterator */
 
 /**
- * Create an iterator
+ * Create an iterator (a packed list is unpacked first).
  * @pre \code{.c}
  * !(TM_PARF_CHECK_P(obj, TM_T_LIST) && TM_PARF_CHECK_P(obj, TM_T_OBJECT))
  * \endcode
@@ -479,7 +840,10 @@ int tm_parf_list_get(tm_parf_t* obj, int index, tm_parf_t** val) {
 tm_parf_iterator* tm_parf_iterator_new(tm_parf_t* obj) {
     assert(!TM_PARF_CHECK_P(obj, TM_T_LIST) || !TM_PARF_CHECK_P(obj, TM_T_OBJECT));
 
-    tm_parf_iterator* it = malloc(sizeof(tm_parf_iterator));
+    if(parf_list_unpack(obj) != TM_ERR_OK)
+        return NULL;
+
+    tm_parf_iterator* it = tm_malloc(sizeof(tm_parf_iterator), TM_MEM_PARAMETERS);
     if(it != NULL) {
         it->obj = obj;
         it->next = obj->val_obj_or_list;
@@ -497,7 +861,7 @@ tm_parf_iterator* tm_parf_iterator_new(tm_parf_t* obj) {
 int tm_parf_iterator_delete(tm_parf_iterator* it) {
     assert(it != NULL);
 
-    free(it);
+    tm_free(it);
     return TM_ERR_OK;
 }
 
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include "errors.h"
+#include "arena.h"
 
 #define TM_parf_IS(o,t) ((o)->val_type == (t))
 #define TM_PARF_CHECK_P(o,t) ((o) == NULL || (o)->val_type != (t))
@@ -21,10 +22,28 @@ typedef enum tm_parf_type_ {
     TM_T_LAST
 } tm_parf_type;
 
+/**
+ * @brief An object of the parameter file.
+ * Nodes are either allocated on the heap, or in an arena (\p arena is not \p NULL).
+ * In the later case, they are only released when the node that owns the arena (\p owns_arena) is deleted.
+ *
+ * The elements of a list or an object are chained (\p val_obj_or_list, then \p next), but are also stored
+ * in \p val_items, so that they can be accessed by index.
+ * For objects, \p val_hash is an open-addressing hash table of the keys, in which a slot is 0 if empty,
+ * and the index of the element in \p val_items plus 1 otherwise.
+ *
+ * Lists of numbers of the same type (built with \p tm_parf_list_append_integer() or
+ * \p tm_parf_list_append_real()) are packed: \p val_packed is \p TM_T_INTEGER or \p TM_T_REAL, and the values
+ * are stored in \p val_array (of capacity \p val_capacity) rather than in separate objects.
+ * They are unpacked if an object is required (e.g., by \p tm_parf_list_get()).
+ */
 typedef struct tm_parf_t_ {
     tm_parf_type val_type;
     char* key;
 
+    tm_arena* arena;
+    int owns_arena;
+
     struct tm_parf_t_* val_obj_or_list;
     struct tm_parf_t_* last;
     long val_int;
@@ -32,14 +51,24 @@ typedef struct tm_parf_t_ {
     char* val_str;
     unsigned int val_size;
 
+    struct tm_parf_t_** val_items;
+    unsigned int val_capacity;
+    unsigned int* val_hash;
+    unsigned int val_hash_size;
+
+    tm_parf_type val_packed;
+    void* val_array;
+
     struct tm_parf_t_* next;
 } tm_parf_t;
 
+tm_parf_t* tm_parf_new_in(tm_arena* arena, tm_parf_type t);
 int tm_parf_delete(tm_parf_t* obj);
 
 // object
 tm_parf_t* tm_parf_object_new();
 int tm_parf_object_set(tm_parf_t* obj, char* key, tm_parf_t* val);
+int tm_parf_object_set_n(tm_parf_t* obj, char* key, unsigned int len, tm_parf_t* val);
 int tm_parf_object_get(tm_parf_t* obj, char* key, tm_parf_t** val);
 
 // integer
@@ -60,6 +89,7 @@ int tm_parf_real_value(tm_parf_t* obj, double* val);
 // string
 tm_parf_t* tm_parf_string_new(char* val);
 int tm_parf_string_set(tm_parf_t* obj, char* val);
+int tm_parf_string_set_n(tm_parf_t* obj, char* val, unsigned int len);
 int tm_parf_string_value(tm_parf_t* object, char **val);
 int tm_parf_string_length(tm_parf_t* object, unsigned int *s);
 
@@ -68,6 +98,10 @@ tm_parf_t* tm_parf_list_new();
 int tm_parf_list_append(tm_parf_t* obj, tm_parf_t* val);
 int tm_parf_list_get(tm_parf_t* obj, int index, tm_parf_t** val);
 int tm_parf_list_length(tm_parf_t* obj, unsigned int* sz);
+int tm_parf_list_append_integer(tm_parf_t* obj, long val);
+int tm_parf_list_append_real(tm_parf_t* obj, double val);
+int tm_parf_list_integers(tm_parf_t* obj, long** vals, unsigned int* sz);
+int tm_parf_list_reals(tm_parf_t* obj, double** vals, unsigned int* sz);
 
 // iterator
 typedef struct tm_parf_iterator_ {
@@ -3,61 +3,45 @@
 #include <assert.h>
 
 /**
- * Parse a string. Caller \b must free it.
+ * Parse a string. The result is not copied: it points to the content of the string in \p input.
  * @pre \code{.c}
- * tk != NULL && input != NULL
+ * tk != NULL && input != NULL && len != NULL
  * && 0 <= tk->position < strlen(input)
  * && tk->type == TM_TK_QUOTE
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param error error, if any
- * @return \p NULL if it was not able to read the string, a pointer to the string otherwise
+ * @param len (output) length of the string
+ * @return \p NULL if it was not able to read the string, a pointer to the string (not NUL-terminated) otherwise
  */
-char *_parse_string(tm_parf_token *tk, char *input) {
-    assert(tk != NULL && input != NULL);
+char *_parse_string(tm_parf_token *tk, char *input, unsigned int* len) {
+    assert(tk != NULL && input != NULL && len != NULL);
     assert(tk->type == TM_TK_QUOTE);
 
     tm_lexer_eat(tk, input, TM_TK_QUOTE);
 
-    int sz = 0;
-    int mul = 64;
-    int fac = 1;
-    char* tmp = malloc(fac * mul * sizeof(char));
+    int pos_start = tk->position;
     int escape = 0;
 
-    if(tmp == NULL) {
-        return NULL;
-    }
-
     while (tk->type != TM_TK_QUOTE || (escape && tk->type == TM_TK_QUOTE)) {
         if (tk->type == TM_TK_EOS) {
-            free(tmp);
             tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "got EOS while reading string");
             return NULL;
         }
 
-        tmp[sz] = *(tk->value);
-        sz++;
-
         if (escape) {
             escape = 0;
         } else if (tk->type == TM_TK_ESCAPE) {
             escape = 1;
         }
 
-        if (sz == fac*mul) {
-            fac++;
-            tmp = realloc(tmp, fac * mul * sizeof(char));
-        }
-
         tm_lexer_advance(tk, input, 1);
     }
 
+    *len = tk->position - pos_start;
     tm_lexer_eat(tk, input, TM_TK_QUOTE);
 
-    tmp[sz] = '\0';
-    return tmp;
+    return input + pos_start;
 }
 
 /**
@@ -68,18 +52,22 @@ char *_parse_string(tm_parf_token *tk, char *input) {
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param error error, if any
+ * @param arena arena in which the object is created (or \p NULL for the heap)
  * @return \p NULL if there was an error, the object (of type \p TM_T_STRING)  otherwise
  */
-tm_parf_t *tm_parf_parse_string(tm_parf_token *tk, char *input) {
+tm_parf_t *tm_parf_parse_string(tm_parf_token *tk, char *input, tm_arena* arena) {
     assert(tk != NULL && input != NULL);
     tm_parf_t* object = NULL;
 
-    char* tmp = _parse_string(tk, input);
+    unsigned int len;
+    char* tmp = _parse_string(tk, input, &len);
 
     if (tmp != NULL) {
-        object = tm_parf_string_new(tmp);
-        free(tmp);
+        object = tm_parf_new_in(arena, TM_T_STRING);
+        if(object != NULL && tm_parf_string_set_n(object, tmp, len) != TM_ERR_OK) {
+            tm_parf_delete(object);
+            object = NULL;
+        }
     }
 
     return object;
@@ -94,17 +82,19 @@ tm_parf_t *tm_parf_parse_string(tm_parf_token *tk, char *input) {
  * \endcode
  * In the end, \p strtol and \p strtod are used to parse the number.
  * @pre \code{.c}
- * tk != NULL && input != NULL
+ * tk != NULL && input != NULL && type != NULL && val_int != NULL && val_real != NULL
  * && 0 <= tk->position < strlen(input)
  * && (tk->type == TM_TK_DIGIT || tk->type == TM_TK_DASH || tk->type == TM_TK_PLUS || tk->type == TM_TK_DOT)
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param error error, if any
- * @return \p NULL if there was an error, the object (of type \p TM_T_REAL or \p TM_T_INTEGER) otherwise
+ * @param type (output) \p TM_T_INTEGER or \p TM_T_REAL
+ * @param val_int (output) the value, if it is an integer
+ * @param val_real (output) the value, if it is a real
+ * @return \p TM_ERR_OK if the value is set, something else otherwise
  */
-tm_parf_t *tm_parf_parse_number(tm_parf_token *tk, char *input) {
-    assert(tk != NULL && input != NULL);
+int _parse_number(tm_parf_token *tk, char *input, tm_parf_type* type, long* val_int, double* val_real) {
+    assert(tk != NULL && input != NULL && type != NULL && val_int != NULL && val_real != NULL);
     assert(tk->type == TM_TK_DIGIT || tk->type == TM_TK_DASH || tk->type == TM_TK_PLUS || tk->type == TM_TK_DOT);
 
     char* beg = tk->value;
@@ -137,17 +127,50 @@ tm_parf_t *tm_parf_parse_number(tm_parf_token *tk, char *input) {
     }
 
     char* end;
-    tm_parf_t* obj = NULL;
     if (dot_found || exp_found) { // then it is a real
-        obj = tm_parf_real_new(strtod(beg, &end));
+        *type = TM_T_REAL;
+        *val_real = strtod(beg, &end);
     } else { // nope, it is an int
-        obj = tm_parf_integer_new(strtol(beg, &end, 10));
+        *type = TM_T_INTEGER;
+        *val_int = strtol(beg, &end, 10);
     }
 
     if ((int) (end-beg) != tk->position - beg_pos) {
-        tm_parf_delete(obj);
         tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "unknown number");
+        return TM_ERR_PARAMETER_FILE;
+    }
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Parse a number (see \p _parse_number()).
+ * @pre \code{.c}
+ * tk != NULL && input != NULL
+ * && 0 <= tk->position < strlen(input)
+ * && (tk->type == TM_TK_DIGIT || tk->type == TM_TK_DASH || tk->type == TM_TK_PLUS || tk->type == TM_TK_DOT)
+ * \endcode
+ * @param tk valid token
+ * @param input input string
+ * @param arena arena in which the object is created (or \p NULL for the heap)
+ * @return \p NULL if there was an error, the object (of type \p TM_T_REAL or \p TM_T_INTEGER) otherwise
+ */
+tm_parf_t *tm_parf_parse_number(tm_parf_token *tk, char *input, tm_arena* arena) {
+    assert(tk != NULL && input != NULL);
+
+    tm_parf_type type;
+    long val_int;
+    double val_real;
+
+    if(_parse_number(tk, input, &type, &val_int, &val_real) != TM_ERR_OK)
         return NULL;
+
+    tm_parf_t* obj = tm_parf_new_in(arena, type);
+    if(obj != NULL) {
+        if(type == TM_T_REAL)
+            tm_parf_real_set(obj, val_real);
+        else
+            tm_parf_integer_set(obj, val_int);
     }
 
     return obj;
@@ -165,10 +188,10 @@ tm_parf_t *tm_parf_parse_number(tm_parf_token *tk, char *input) {
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param error error, if any
+ * @param arena arena in which the object is created (or \p NULL for the heap)
  * @return \p NULL if there was an error, the object (of type \p TM_T_BOOLEAN)  otherwise
  */
-tm_parf_t *tm_parf_parse_boolean(tm_parf_token *tk, char *input) {
+tm_parf_t *tm_parf_parse_boolean(tm_parf_token *tk, char *input, tm_arena* arena) {
     assert(tk != NULL && input != NULL);
     assert(tk->type == TM_TK_ALPHA);
 
@@ -184,15 +207,22 @@ tm_parf_t *tm_parf_parse_boolean(tm_parf_token *tk, char *input) {
 
     buff[i] = '\0';
 
+    int val = -1;
     if((i == 2 && strcmp(buff, "on") == 0) || (i == 3 && strcmp(buff, "yes") == 0) || (i == 4 && strcmp(buff, "true") == 0))
-        obj = tm_parf_boolean_new(1);
+        val = 1;
     else if((i == 2 && strcmp(buff, "no") == 0) || (i == 3 && strcmp(buff, "off") == 0) || (i == 5 && strcmp(buff, "false") == 0))
-        obj = tm_parf_boolean_new(0);
+        val = 0;
+
+    if(val >= 0) {
+        obj = tm_parf_new_in(arena, TM_T_BOOLEAN);
+        if(obj != NULL)
+            tm_parf_boolean_set(obj, val);
+    }
 
     return obj;
 }
 
-tm_parf_t* tm_parf_parse_value(tm_parf_token* tk, char* input); // forward decl
+tm_parf_t* tm_parf_parse_value(tm_parf_token* tk, char* input, tm_arena* arena); // forward decl
 
 /**
  * Parse a list
@@ -206,28 +236,42 @@ tm_parf_t* tm_parf_parse_value(tm_parf_token* tk, char* input); // forward decl
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param error error, if any
+ * @param arena arena in which the object is created (or \p NULL for the heap)
  * @return \p NULL if there was an error, the object (of type \p TM_T_LIST) otherwise
  */
-tm_parf_t *tm_parf_parse_list(tm_parf_token *tk, char *input) {
+tm_parf_t *tm_parf_parse_list(tm_parf_token *tk, char *input, tm_arena* arena) {
     assert(tk != NULL && input != NULL);
     assert(tk->type == TM_TK_LBRACKET);
 
     tm_lexer_advance(tk, input, 1); // skip LBRACKET
 
-    tm_parf_t* object = tm_parf_list_new();
+    tm_parf_t* object = tm_parf_new_in(arena, TM_T_LIST);
     tm_parf_t* val;
 
+    if(object == NULL)
+        return NULL;
+
     tm_lexer_skip_whitespace_and_nl(tk, input);
 
+    tm_parf_type type;
+    long val_int;
+    double val_real;
+    int r;
+
     while (tk->type != TM_TK_RBRACKET && tk->type != TM_TK_EOS) {
-        val = tm_parf_parse_value(tk, input);
+        if(tk->type == TM_TK_DIGIT || tk->type == TM_TK_DASH || tk->type == TM_TK_PLUS || tk->type == TM_TK_DOT) {
+            // numbers are directly packed, if possible
+            r = _parse_number(tk, input, &type, &val_int, &val_real);
+            if(r == TM_ERR_OK)
+                r = type == TM_T_REAL ? tm_parf_list_append_real(object, val_real) : tm_parf_list_append_integer(object, val_int);
+        } else {
+            val = tm_parf_parse_value(tk, input, arena);
+            r = val == NULL ? TM_ERR_PARAMETER_FILE : tm_parf_list_append(object, val);
+        }
 
-        if (val == NULL) {
+        if (r != TM_ERR_OK) {
             tm_parf_delete(object);
             return NULL;
-        } else {
-            tm_parf_list_append(object, val);
         }
 
         tm_lexer_skip_whitespace_and_nl(tk, input);
@@ -253,10 +297,10 @@ tm_parf_t *tm_parf_parse_list(tm_parf_token *tk, char *input) {
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param error error, if any
+ * @param arena arena in which the object is created (or \p NULL for the heap)
  * @return \p NULL if there was an error, the object (of correct type) otherwise
  */
-tm_parf_t *tm_parf_parse_value(tm_parf_token *tk, char *input) {
+tm_parf_t *tm_parf_parse_value(tm_parf_token *tk, char *input, tm_arena* arena) {
     assert(tk != NULL && input != NULL);
 
     tm_lexer_skip_whitespace_and_nl(tk, input);
@@ -265,19 +309,19 @@ tm_parf_t *tm_parf_parse_value(tm_parf_token *tk, char *input) {
 
     switch (tk->type) {
         case TM_TK_LBRACKET:
-            object = tm_parf_parse_list(tk, input);
+            object = tm_parf_parse_list(tk, input, arena);
             break;
         case TM_TK_QUOTE:
-            object = tm_parf_parse_string(tk, input);
+            object = tm_parf_parse_string(tk, input, arena);
             break;
         case TM_TK_DOT:
         case TM_TK_DASH:
         case TM_TK_PLUS:
         case TM_TK_DIGIT:
-            object = tm_parf_parse_number(tk, input);
+            object = tm_parf_parse_number(tk, input, arena);
             break;
-        case TM_TK_CHAR:
-            object = tm_parf_parse_boolean(tk, input);
+        case TM_TK_ALPHA:
+            object = tm_parf_parse_boolean(tk, input, arena);
             break;
         default:
             tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "unexpected token to start value");
@@ -288,44 +332,33 @@ tm_parf_t *tm_parf_parse_value(tm_parf_token *tk, char *input) {
 }
 
 /**
- * Parse a name literal (i.e., a key). Caller must free the string.
+ * Parse a name literal (i.e., a key). The result is not copied: it points to the name in \p input.
  * \code
  * NAME_LITERAL := (DIGIT | CHAR_LIT)*;
  * CHAR_LIT := [a-zA-Z_-];
  * \endcode
  * @pre \code{.c}
- * tk != NULL && input != NULL
+ * tk != NULL && input != NULL && len != NULL
  * && 0 <= tk->position < strlen(input)
  * && tk->type == TM_TK_ALPHA || tk->type == TM_TK_DIGIT || input[tk->position] == '_' || input[tk->position] == '-'
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param error error, if any
- * @return \p NULL if there was an error, the name otherwise.
+ * @param len (output) length of the name
+ * @return the name (not NUL-terminated).
  */
-char *_parse_name_lit(tm_parf_token *tk, char *input) {
-    assert(tk != NULL && input != NULL);
+char *_parse_name_lit(tm_parf_token *tk, char *input, unsigned int* len) {
+    assert(tk != NULL && input != NULL && len != NULL);
     assert(tk->type == TM_TK_ALPHA || tk->type == TM_TK_DIGIT || input[tk->position] == '_' || input[tk->position] == '-');
 
-    int sz = 0;
-    int mul = 64;
-    int fac = 1;
-    char* tmp = malloc(fac * mul * sizeof(char));
+    int pos_start = tk->position;
 
     while (tk->type == TM_TK_ALPHA || tk->type == TM_TK_DIGIT || input[tk->position] == '_'  || input[tk->position] == '-') {
-        tmp[sz] = *(tk->value);
-        sz++;
-
-        if (sz == fac*mul) {
-            fac++;
-            tmp = realloc(tmp, fac * mul * sizeof(char));
-        }
-
         tm_lexer_advance(tk, input, 1);
     }
 
-    tmp[sz] = '\0';
-    return tmp;
+    *len = tk->position - pos_start;
+    return input + pos_start;
 }
 
 
@@ -357,6 +390,7 @@ void _skip_comment(tm_parf_token *tk, char *input) {
  * \code
  * OBJECT := (COMMENT | NAME_LITERAL VALUE)* EOS;
  * \endcode
+ * The whole tree is built in an arena, owned by the returned object: it is released by \p tm_parf_delete().
  * @pre \code{.c}
  * input != NULL
  * \endcode
@@ -368,7 +402,18 @@ tm_parf_t *tm_parf_loads(char *input) {
     assert(input != NULL);
 
     tm_parf_token tk;
-    tm_parf_t* obj = tm_parf_object_new();
+
+    tm_arena* arena = tm_arena_new(TM_PARF_ARENA_CHUNK_SIZE);
+    if(arena == NULL)
+        return NULL;
+
+    tm_parf_t* obj = tm_parf_new_in(arena, TM_T_OBJECT);
+    if(obj == NULL) {
+        tm_arena_delete(arena);
+        return NULL;
+    }
+
+    obj->owns_arena = 1;
 
     // bootstrap
     tm_lexer_token_init(&tk, input);
@@ -381,22 +426,19 @@ tm_parf_t *tm_parf_loads(char *input) {
             tm_lexer_skip_whitespace_and_nl(&tk, input);
         }
         else {
-            char* key = _parse_name_lit(&tk, input);
+            unsigned int key_len;
+            char* key = _parse_name_lit(&tk, input, &key_len);
             if(tk.type != TM_TK_WHITESPACE) {
                 tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected whitespace after key");
             }
 
             tm_lexer_skip_whitespace_and_nl(&tk, input);
 
-            tm_parf_t* value = tm_parf_parse_value(&tk, input);
-            if (value == NULL) {
-                free(key);
+            tm_parf_t* value = tm_parf_parse_value(&tk, input, arena);
+            if (value == NULL || tm_parf_object_set_n(obj, key, key_len, value) != TM_ERR_OK) {
                 tm_parf_delete(obj);
                 return NULL;
             }
-
-            tm_parf_object_set(obj, key, value);
-            free(key);
         }
 
         tm_lexer_skip_whitespace_and_nl(&tk, input);
@@ -4,6 +4,9 @@
 #include "param_file_objects.h"
 #include "lexer.h"
 
+// size of the first chunk of the arena in which the objects are created
+#define TM_PARF_ARENA_CHUNK_SIZE 4096
+
 tm_parf_t *tm_parf_loads(char *input);
 
 
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+void pcg32_init(uint64_t seed);
 uint32_t pcg32();
 double drand();
 
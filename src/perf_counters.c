@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "perf_counters.h"
+#include "memory.h"
+#include "errors.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static char* counter_names[] = {
+        "cycles",
+        "instructions",
+        "L1d_misses",
+        "LLC_misses",
+        "branch_misses",
+};
+
+#ifdef __linux__
+static int perf_counters_open(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/**
+ * Open (and start) the hardware counters.
+ * Counters that are not available (e.g., in a container, with a restrictive \p perf_event_paranoid, or on another OS)
+ * are just ignored, so that it is not an error if none can be opened.
+ * @return the counters, \p NULL if \p malloc failed
+ */
+tm_perf_counters* tm_perf_counters_new() {
+    tm_perf_counters* counters = tm_malloc(sizeof(tm_perf_counters), TM_MEM_INSTRUMENTATION);
+
+    if(counters != NULL) {
+        counters->N_available = 0;
+
+        for(int i=0; i < TM_PERF_LAST; i++)
+            counters->fds[i] = -1;
+
+#ifdef __linux__
+        uint32_t types[] = {
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HW_CACHE,
+                PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE
+        };
+
+        uint64_t configs[] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for(int i=0; i < TM_PERF_LAST; i++) {
+            counters->fds[i] = perf_counters_open(types[i], configs[i]);
+            if(counters->fds[i] >= 0)
+                counters->N_available++;
+            else
+                counters->fds[i] = -1;
+        }
+#endif
+    }
+
+    return counters;
+}
+
+/**
+ * Read the current value of the counters.
+ * If the kernel had to multiplex them, values are scaled to the whole time they were enabled.
+ * @pre \code{.c}
+ * counters != NULL && values != NULL
+ * \endcode
+ * @param counters the counters
+ * @param[out] values array of size \p TM_PERF_LAST, the value of each counter (\p NAN if not available)
+ * @return \p TM_ERR_OK, or \p TM_ERR_NOT_FOUND if no counter is available
+ * @post \p values is set.
+ */
+int tm_perf_counters_read(tm_perf_counters* counters, double* values) {
+    assert(counters != NULL && values != NULL);
+
+    for(int i=0; i < TM_PERF_LAST; i++) {
+        values[i] = NAN;
+
+#ifdef __linux__
+        uint64_t data[3]; // value, time enabled, time running
+        if(counters->fds[i] >= 0 && read(counters->fds[i], data, sizeof(data)) == sizeof(data) && data[2] > 0)
+            values[i] = (double) data[0] * ((double) data[1] / (double) data[2]);
+#endif
+    }
+
+    return counters->N_available > 0 ? TM_ERR_OK : TM_ERR_NOT_FOUND;
+}
+
+/**
+ * Get the name of a counter.
+ * @pre \code{.c}
+ * counter < TM_PERF_LAST
+ * \endcode
+ * @param counter the counter
+ * @return its name
+ */
+char* tm_perf_counters_name(tm_perf_counter counter) {
+    assert(counter < TM_PERF_LAST);
+
+    return counter_names[counter];
+}
+
+/**
+ * Close the counters.
+ * @pre \code{.c}
+ * counters != NULL
+ * \endcode
+ * @param counters the counters
+ * @return \p TM_ERR_OK
+ */
+int tm_perf_counters_delete(tm_perf_counters* counters) {
+    assert(counters != NULL);
+
+#ifdef __linux__
+    for(int i=0; i < TM_PERF_LAST; i++) {
+        if(counters->fds[i] >= 0)
+            close(counters->fds[i]);
+    }
+#endif
+
+    tm_free(counters);
+    return TM_ERR_OK;
+}
@@ -0,0 +1,34 @@
+#ifndef TOYMC_PERF_COUNTERS_H
+#define TOYMC_PERF_COUNTERS_H
+
+/**
+ * @brief Hardware counters
+ */
+typedef enum tm_perf_counter_ {
+    TM_PERF_CYCLES,
+    TM_PERF_INSTRUCTIONS,
+    TM_PERF_L1D_MISSES, // L1 data cache read misses
+    TM_PERF_LLC_MISSES, // last level cache misses
+    TM_PERF_BRANCH_MISSES,
+
+    TM_PERF_LAST
+} tm_perf_counter;
+
+/**
+ * @brief Hardware counters of the calling thread (through \p perf_event_open, on Linux).
+ * Fields are \code{.c}
+ * int fds[TM_PERF_LAST]; // file descriptor of each counter, -1 if not available
+ * int N_available; // number of available counters
+ * \endcode
+ */
+typedef struct tm_perf_counters_ {
+    int fds[TM_PERF_LAST];
+    int N_available;
+} tm_perf_counters;
+
+tm_perf_counters* tm_perf_counters_new();
+int tm_perf_counters_read(tm_perf_counters* counters, double* values);
+char* tm_perf_counters_name(tm_perf_counter counter);
+int tm_perf_counters_delete(tm_perf_counters* counters);
+
+#endif //TOYMC_PERF_COUNTERS_H
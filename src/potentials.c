@@ -4,6 +4,11 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+#include "potentials.h"
+#include "errors.h"
 
 /**
  * Compute the adimensional Lennard-Jones (i.e., 12-6 potential) potential between two atoms
@@ -57,3 +62,236 @@ void tm_potential_LJ_N(long N, double* rv, double rc2, double* U, double* vir) {
         *vir += rv[N + i];
     }
 }
+
+/**
+ * Lennard-Jones potential, \f$U = c_{12} r^{-12} - c_6 r^{-6}\f$.
+ * @param r2 square of the distance
+ * @param params \p {c12, c6} (see \p tm_pair_coefs)
+ * @param [out] U the energy
+ * @param [out] vir the virial
+ */
+void tm_pair_LJ(double r2, double* params, double* U, double* vir) {
+    assert(params != NULL && U != NULL && vir != NULL);
+
+    double r6i = 1. / (r2 * r2 * r2);
+    *U = r6i * (params[0] * r6i - params[1]);
+    *vir = r6i * (4. * params[0] * r6i - 2. * params[1]);
+}
+
+/**
+ * Morse potential, \f$U = D\,[(1-e^{-a(r-r_0)})^2 - 1]\f$.
+ * @param r2 square of the distance
+ * @param params \p {D, a, r0}
+ * @param [out] U the energy
+ * @param [out] vir the virial
+ */
+void tm_pair_morse(double r2, double* params, double* U, double* vir) {
+    assert(params != NULL && U != NULL && vir != NULL);
+
+    double r = sqrt(r2), e = exp(-params[1] * (r - params[2]));
+    *U = params[0] * e * (e - 2.);
+    *vir = 2. / 3 * params[0] * params[1] * r * e * (e - 1.);
+}
+
+/**
+ * Buckingham potential, \f$U = A e^{-Br} - C r^{-6}\f$.
+ * @param r2 square of the distance
+ * @param params \p {A, B, C}
+ * @param [out] U the energy
+ * @param [out] vir the virial
+ */
+void tm_pair_buckingham(double r2, double* params, double* U, double* vir) {
+    assert(params != NULL && U != NULL && vir != NULL);
+
+    double r = sqrt(r2), e = params[0] * exp(-params[1] * r), r6i = 1. / (r2 * r2 * r2);
+    *U = e - params[2] * r6i;
+    *vir = (params[1] * r * e - 6. * params[2] * r6i) / 3;
+}
+
+/* Registry.
+ * For each potential: how its parameters are derived from epsilon and sigma, the batched kernels, the scalar version
+ * and the tail integral (see tm_potential).
+ *
+ * The kernels of a potential \p name are generated from:
+ * - name##_PARAMS, the declaration of its parameters (from \p params),
+ * - name##_PAIR(s, u, w), which sets the energy \p u and virial \p w of a pair from its square distance \p s,
+ * with one variant for each combination of cutoff (out of range pairs are moved to the cutoff, then masked) and
+ * virial. Both are compile-time constants, so that each loop is branch-free and vectorizes.
+ */
+#define PAIR_KERNEL(name, suffix, cutoff, virial) \
+    static void name##_kernel##suffix(long N, double* r2, double* params, double rc2, double* U, double* vir) { \
+        name##_PARAMS \
+        double sU = 0, svir = 0; \
+        double* restrict r2_ = r2; \
+        (void) rc2; (void) vir; \
+        _Pragma("omp simd reduction(+:sU,svir)") \
+        for(long j=0; j < N; j++) { \
+            int in = !(cutoff) || r2_[j] < rc2; \
+            double s = (cutoff) && !in ? rc2 : r2_[j], u, w; \
+            name##_PAIR(s, u, w) \
+            sU += in ? u : 0; \
+            svir += (virial) && in ? w : 0; \
+        } \
+        *U += sU; \
+        if(virial) \
+            *vir += svir; \
+    }
+
+#define PAIR_KERNELS(name) \
+    PAIR_KERNEL(name, , 1, 1) \
+    PAIR_KERNEL(name, _no_virial, 1, 0) \
+    PAIR_KERNEL(name, _no_cutoff, 0, 1) \
+    PAIR_KERNEL(name, _no_cutoff_no_virial, 0, 0)
+
+#define PAIR_KERNELS_TABLE(name) {{name##_kernel_no_cutoff_no_virial, name##_kernel_no_cutoff}, {name##_kernel_no_virial, name##_kernel}}
+
+// LJ: {c12, c6}
+static void LJ_setup(double epsilon, double sigma, double alpha, double* params, double* rc2) {
+    (void) alpha; (void) rc2;
+
+    double sig6 = sigma * sigma * sigma * sigma * sigma * sigma;
+    params[0] = 4. * epsilon * sig6 * sig6;
+    params[1] = 4. * epsilon * sig6;
+}
+
+#define LJ_PARAMS double c12 = params[0]; double c6 = params[1];
+#define LJ_PAIR(s, u, w) { \
+        double r6i = 1. / (s * s * s); \
+        u = r6i * (c12 * r6i - c6); \
+        w = r6i * (4. * c12 * r6i - 2. * c6); \
+    }
+
+PAIR_KERNELS(LJ)
+
+static double LJ_tail(double* params, double rc2) {
+    double irc3 = 1. / (rc2 * sqrt(rc2));
+    return irc3 * (params[0] * irc3 * irc3 / 9 - params[1] / 3);
+}
+
+// WCA, i.e., the repulsive part of LJ, shifted: {c12, c6, epsilon}
+static void WCA_setup(double epsilon, double sigma, double alpha, double* params, double* rc2) {
+    LJ_setup(epsilon, sigma, alpha, params, rc2);
+    params[2] = epsilon;
+    *rc2 = cbrt(2.) * sigma * sigma;
+}
+
+static void WCA_function(double r2, double* params, double* U, double* vir) {
+    tm_pair_LJ(r2, params, U, vir);
+    *U += params[2];
+}
+
+#define WCA_PARAMS LJ_PARAMS double eps = params[2];
+#define WCA_PAIR(s, u, w) LJ_PAIR(s, u, w) u += eps;
+
+PAIR_KERNELS(WCA)
+
+// shifted-force LJ, so that both the energy and the force go to zero at the cutoff: {c12, c6, U(rc), U'(rc), rc}
+static void SF_LJ_setup(double epsilon, double sigma, double alpha, double* params, double* rc2) {
+    double U, vir, rc = sqrt(*rc2);
+
+    LJ_setup(epsilon, sigma, alpha, params, rc2);
+    tm_pair_LJ(*rc2, params, &U, &vir);
+    params[2] = U;
+    params[3] = -3. * vir / rc;
+    params[4] = rc;
+}
+
+static void SF_LJ_function(double r2, double* params, double* U, double* vir) {
+    double r = sqrt(r2);
+
+    tm_pair_LJ(r2, params, U, vir);
+    *U -= params[2] + (r - params[4]) * params[3];
+    *vir += r * params[3] / 3;
+}
+
+#define SF_LJ_PARAMS LJ_PARAMS double U_rc = params[2]; double dU_rc = params[3]; double rc = params[4];
+#define SF_LJ_PAIR(s, u, w) { \
+        double r = sqrt(s); \
+        LJ_PAIR(s, u, w) \
+        u -= U_rc + (r - rc) * dU_rc; \
+        w += r * dU_rc / 3; \
+    }
+
+PAIR_KERNELS(SF_LJ)
+
+// integral of r^2 exp(-k r) beyond rc
+static double exp_tail(double k, double rc) {
+    return exp(-k * rc) * (rc * rc / k + 2 * rc / (k * k) + 2 / (k * k * k));
+}
+
+// Morse, with the same minimum as LJ (alpha = 6 gives the same curvature): {D, a, r0}
+static void morse_setup(double epsilon, double sigma, double alpha, double* params, double* rc2) {
+    (void) rc2;
+
+    params[0] = epsilon;
+    params[2] = pow(2., 1. / 6) * sigma;
+    params[1] = alpha / params[2];
+}
+
+#define morse_PARAMS double D = params[0]; double a = params[1]; double r0 = params[2];
+#define morse_PAIR(s, u, w) { \
+        double r = sqrt(s), e = exp(-a * (r - r0)); \
+        u = D * e * (e - 2.); \
+        w = 2. / 3 * D * a * r * e * (e - 1.); \
+    }
+
+PAIR_KERNELS(morse)
+
+static double morse_tail(double* params, double rc2) {
+    double D = params[0], a = params[1], r0 = params[2], rc = sqrt(rc2);
+    return D * (exp(2 * a * r0) * exp_tail(2 * a, rc) - 2 * exp(a * r0) * exp_tail(a, rc));
+}
+
+// Buckingham, in its "exp-6" form (same minimum as LJ, alpha sets the steepness of the repulsion): {A, B, C}
+static void buckingham_setup(double epsilon, double sigma, double alpha, double* params, double* rc2) {
+    (void) rc2;
+
+    double rm = pow(2., 1. / 6) * sigma, rm6 = rm * rm * rm * rm * rm * rm;
+    params[0] = 6. * epsilon / (alpha - 6.) * exp(alpha);
+    params[1] = alpha / rm;
+    params[2] = alpha * epsilon * rm6 / (alpha - 6.);
+}
+
+#define buckingham_PARAMS double A = params[0]; double B = params[1]; double C = params[2];
+#define buckingham_PAIR(s, u, w) { \
+        double r = sqrt(s), e = A * exp(-B * r), r6i = 1. / (s * s * s); \
+        u = e - C * r6i; \
+        w = (B * r * e - 6. * C * r6i) / 3; \
+    }
+
+PAIR_KERNELS(buckingham)
+
+static double buckingham_tail(double* params, double rc2) {
+    double rc = sqrt(rc2);
+    return params[0] * exp_tail(params[1], rc) - params[2] / (3. * rc2 * rc);
+}
+
+static tm_potential POTENTIALS[] = {
+        {"lj", 0, 0, LJ_setup, PAIR_KERNELS_TABLE(LJ), tm_pair_LJ, LJ_tail},
+        {"wca", 0, 0, WCA_setup, PAIR_KERNELS_TABLE(WCA), WCA_function, NULL},
+        {"sf-lj", 0, 0, SF_LJ_setup, PAIR_KERNELS_TABLE(SF_LJ), SF_LJ_function, NULL},
+        {"morse", 6., 0., morse_setup, PAIR_KERNELS_TABLE(morse), tm_pair_morse, morse_tail},
+        {"buckingham", 14., 6., buckingham_setup, PAIR_KERNELS_TABLE(buckingham), tm_pair_buckingham, buckingham_tail},
+};
+
+/**
+ * Find a potential of the registry by its name (\p "lj", \p "wca", \p "sf-lj", \p "morse" or \p "buckingham").
+ * @pre \code{.c}
+ * name != NULL && potential != NULL
+ * \endcode
+ * @param name the name
+ * @param potential (output) the potential
+ * @return \p TM_ERR_OK if the potential exists, \p TM_ERR_NOT_FOUND otherwise
+ */
+int tm_potential_find(char* name, tm_potential** potential) {
+    assert(name != NULL && potential != NULL);
+
+    for(size_t i=0; i < sizeof(POTENTIALS) / sizeof(tm_potential); i++) {
+        if(strcmp(name, POTENTIALS[i].name) == 0) {
+            *potential = &(POTENTIALS[i]);
+            return TM_ERR_OK;
+        }
+    }
+
+    return TM_ERR_NOT_FOUND;
+}
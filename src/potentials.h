@@ -1,6 +1,57 @@
 #ifndef TOYMC_POTENTIALS_H
 #define TOYMC_POTENTIALS_H
 
-void tm_pontential_LJ(double r2, double rc2, double* U, double* vir);
+void tm_potential_LJ(double r2, double epsilon, double rc2, double* U, double* vir);
+void tm_potential_LJ_N(long N, double* rv, double rc2, double* U, double* vir);
+
+/**
+ * @brief A pair potential, as a function of the square of the distance.
+ * It sets \p U to the energy of the pair, and \p vir to its virial, \f$-\frac{r}{3}\frac{dU}{dr}\f$ (without any cutoff).
+ */
+typedef void (*tm_pair_function)(double r2, double* params, double* U, double* vir);
+
+void tm_pair_LJ(double r2, double* params, double* U, double* vir);
+void tm_pair_morse(double r2, double* params, double* U, double* vir);
+void tm_pair_buckingham(double r2, double* params, double* U, double* vir);
+
+// largest number of parameters of a potential, for a pair of types
+#define TM_POTENTIAL_MAX_PARAMS 5
+
+/**
+ * @brief A batched pair kernel: adds the energy and virial of \p N pairs of the same types, from the square of their
+ * distances (unchanged), with the parameters of that pair of types. Pairs beyond \p rc2 (including infinite distances)
+ * do not contribute, except for the variants without cutoff, which take all the (finite) distances into account.
+ * Variants without virial leave \p vir unchanged.
+ */
+typedef void (*tm_pair_kernel)(long N, double* r2, double* params, double rc2, double* U, double* vir);
+
+/**
+ * @brief A pair potential of the registry.
+ * Its parameters are derived from the (mixed) LJ-like \f$\epsilon\f$ and \f$\sigma\f$ of a pair, plus a shape
+ * parameter \f$\alpha\f$ for the potentials that need one.
+ * Fields are \code{.c}
+ * char* name; // name of the potential
+ * double alpha; // default shape parameter (0 if not used)
+ * double alpha_min; // the shape parameter must be larger than that (the potential is not defined otherwise)
+ * void (*setup)(double epsilon, double sigma, double alpha, double* params, double* rc2); // parameters of a pair (rc2 may be changed)
+ * tm_pair_kernel kernels[2][2]; // batched kernels, as kernels[with cutoff][with virial]
+ * tm_pair_function function; // scalar version (without cutoff)
+ * double (*tail)(double* params, double rc2); // integral of r^2 U(r) beyond the cutoff, NULL if the potential is zero there
+ * \endcode
+ */
+typedef struct tm_potential_ {
+    char* name;
+    double alpha;
+    double alpha_min;
+    void (*setup)(double epsilon, double sigma, double alpha, double* params, double* rc2);
+    tm_pair_kernel kernels[2][2];
+    tm_pair_function function;
+    double (*tail)(double* params, double rc2);
+} tm_potential;
+
+// whether \p alpha is a valid shape parameter for \p potential (0 stands for the default)
+#define TM_POTENTIAL_ALPHA_IS_VALID(potential, alpha) ((alpha) == 0 || (alpha) > (potential)->alpha_min)
+
+int tm_potential_find(char* name, tm_potential** potential);
 
 #endif //TOYMC_POTENTIALS_H
@@ -0,0 +1,406 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "profile.h"
+#include "memory.h"
+#include "perf_counters.h"
+#include "timer.h"
+#include "errors.h"
+
+static char* region_names[] = {
+        "run",
+        "setup",
+        "sweep",
+        "energy",
+        "move",
+        "accept",
+        "io",
+        "comm",
+};
+
+/* A node of the call tree: a region, given its parents.
+ * Node 0 is the root, which is not a region.
+ */
+struct node {
+    int region;
+    int parent;
+    int children[TM_REGION_LAST]; // -1 if not created yet
+    long count;
+    uint64_t total;
+    double counts[TM_PERF_LAST]; // sum of the hardware counters (if measured)
+};
+
+// a region, as shown in the trace
+struct event {
+    uint64_t start;
+    uint64_t duration;
+    int region;
+    int depth;
+};
+
+static int enabled = 0;
+static uint64_t origin;
+
+static struct node nodes[TM_PROFILE_MAX_NODES];
+static int N_nodes = 0;
+
+// regions which are currently open
+static int stack_nodes[TM_PROFILE_MAX_DEPTH + 1];
+static uint64_t stack_starts[TM_PROFILE_MAX_DEPTH + 1];
+static double stack_counts[TM_PROFILE_MAX_DEPTH + 1][TM_PERF_LAST];
+static int current_depth = 0;
+
+// hardware counters are read for regions up to this depth
+static tm_perf_counters* counters = NULL;
+static int max_counters_depth = 0;
+
+static int max_trace_depth = -1;
+static struct event* events = NULL;
+static long N_events = 0;
+static long events_size = 0;
+static long N_dropped = 0;
+
+static int profile_node_new(int region, int parent) {
+    if(N_nodes == TM_PROFILE_MAX_NODES)
+        return -1;
+
+    struct node* n = &nodes[N_nodes];
+    n->region = region;
+    n->parent = parent;
+    n->count = 0;
+    n->total = 0;
+
+    for(int i=0; i < TM_REGION_LAST; i++)
+        n->children[i] = -1;
+
+    for(int i=0; i < TM_PERF_LAST; i++)
+        n->counts[i] = 0;
+
+    return N_nodes++;
+}
+
+/**
+ * Enable profiling, and reset any previous measurement.
+ * @param trace_depth regions up to this depth (the outermost region being at depth 1) are recorded in the trace (0 disable the trace)
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the trace cannot be allocated
+ * @post profiling is enabled.
+ */
+int tm_profile_init(int trace_depth) {
+    tm_profile_finalize();
+
+    if(trace_depth > 0) {
+        events_size = 1024;
+        events = tm_malloc(events_size * sizeof(struct event), TM_MEM_INSTRUMENTATION);
+        if(events == NULL)
+            return TM_ERR_MALLOC;
+    }
+
+    max_trace_depth = trace_depth;
+    N_nodes = 0;
+    current_depth = 0;
+    stack_nodes[0] = profile_node_new(TM_REGION_LAST, -1);
+
+    origin = timer_ns();
+    enabled = 1;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Also read the hardware counters (see tm_perf_counters_new()) when entering and leaving the outermost regions.
+ * Each read is a system call, so it should only be used for regions that are long enough.
+ * Must be called after tm_profile_init().
+ * @pre \code{.c}
+ * depth > 0
+ * \endcode
+ * @param depth regions up to this depth (the outermost region being at depth 1) are measured
+ * @return \p TM_ERR_OK, \p TM_ERR_NOT_FOUND if no counter is available (then, regions are only timed), or \p TM_ERR_MALLOC
+ */
+int tm_profile_use_counters(int depth) {
+    assert(depth > 0);
+
+    if(counters == NULL) {
+        counters = tm_perf_counters_new();
+        if(counters == NULL)
+            return TM_ERR_MALLOC;
+    }
+
+    if(counters->N_available == 0) {
+        tm_perf_counters_delete(counters);
+        counters = NULL;
+        return TM_ERR_NOT_FOUND;
+    }
+
+    max_counters_depth = depth;
+    return TM_ERR_OK;
+}
+
+/**
+ * Open a region, as a child of the region which is currently open (if any).
+ * Does nothing if profiling is not enabled.
+ * @pre \code{.c}
+ * region < TM_REGION_LAST
+ * \endcode
+ * @param region the region
+ */
+void tm_profile_begin(tm_profile_region region) {
+    assert(region < TM_REGION_LAST);
+
+    if(!enabled)
+        return;
+
+    assert(current_depth < TM_PROFILE_MAX_DEPTH);
+
+    int parent = stack_nodes[current_depth];
+    int n = parent < 0 ? -1 : nodes[parent].children[region];
+
+    if(n < 0 && parent >= 0) {
+        n = profile_node_new(region, parent);
+        nodes[parent].children[region] = n;
+    }
+
+    current_depth++;
+    stack_nodes[current_depth] = n; // if there is no more node, the region (and its children) is only traced
+
+    if(current_depth <= max_counters_depth)
+        tm_perf_counters_read(counters, stack_counts[current_depth]);
+
+    stack_starts[current_depth] = timer_ns();
+}
+
+/**
+ * Close a region, which must be the one that was opened last.
+ * Does nothing if profiling is not enabled.
+ * @pre \code{.c}
+ * region < TM_REGION_LAST
+ * \endcode
+ * @param region the region
+ * @post time spent in the region is accounted for.
+ */
+void tm_profile_end(tm_profile_region region) {
+    assert(region < TM_REGION_LAST);
+
+    if(!enabled)
+        return;
+
+    uint64_t stop = timer_ns();
+    double counts[TM_PERF_LAST];
+
+    assert(current_depth > 0);
+
+    if(current_depth <= max_counters_depth)
+        tm_perf_counters_read(counters, counts);
+
+    int n = stack_nodes[current_depth];
+    uint64_t start = stack_starts[current_depth];
+
+    if(n >= 0) {
+        assert(nodes[n].region == (int) region);
+        nodes[n].count++;
+        nodes[n].total += stop - start;
+
+        if(current_depth <= max_counters_depth) {
+            for(int i=0; i < TM_PERF_LAST; i++)
+                nodes[n].counts[i] += counts[i] - stack_counts[current_depth][i];
+        }
+    }
+
+    if(current_depth <= max_trace_depth) {
+        if(N_events == events_size && events_size < TM_PROFILE_MAX_EVENTS) {
+            struct event* e = tm_realloc(events, 2 * events_size * sizeof(struct event), TM_MEM_INSTRUMENTATION);
+            if(e != NULL) {
+                events = e;
+                events_size *= 2;
+            }
+        }
+
+        if(N_events < events_size) {
+            events[N_events].start = start - origin;
+            events[N_events].duration = stop - start;
+            events[N_events].region = region;
+            events[N_events].depth = current_depth;
+            N_events++;
+        } else
+            N_dropped++;
+    }
+
+    current_depth--;
+}
+
+/**
+ * Get the measurements for a region, given its parents.
+ * @pre \code{.c}
+ * path != NULL && depth > 0 && count != NULL && total != NULL
+ * \endcode
+ * @param path the regions, from the outermost to the one of interest
+ * @param depth number of regions in \p path
+ * @param[out] count number of times the region was closed
+ * @param[out] total time spent in the region (in second)
+ * @return \p TM_ERR_OK, or \p TM_ERR_NOT_FOUND if the region was never opened with these parents
+ */
+int tm_profile_get(tm_profile_region* path, int depth, long* count, double* total) {
+    assert(path != NULL && depth > 0 && count != NULL && total != NULL);
+
+    int n = 0;
+    for(int i=0; i < depth && n >= 0 && N_nodes > 0; i++)
+        n = nodes[n].children[path[i]];
+
+    if(n <= 0)
+        return TM_ERR_NOT_FOUND;
+
+    *count = nodes[n].count;
+    *total = (double) nodes[n].total * 1e-9;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Get the hardware counters for a region, given its parents (see tm_profile_use_counters()).
+ * @pre \code{.c}
+ * path != NULL && depth > 0 && values != NULL
+ * \endcode
+ * @param path the regions, from the outermost to the one of interest
+ * @param depth number of regions in \p path
+ * @param[out] values array of size \p TM_PERF_LAST, sum of each counter over all the times the region was closed (\p NAN if not available)
+ * @return \p TM_ERR_OK, or \p TM_ERR_NOT_FOUND if the region was never opened with these parents or was not measured
+ */
+int tm_profile_get_counters(tm_profile_region* path, int depth, double* values) {
+    assert(path != NULL && depth > 0 && values != NULL);
+
+    long count;
+    double total;
+
+    if(depth > max_counters_depth || tm_profile_get(path, depth, &count, &total) != TM_ERR_OK)
+        return TM_ERR_NOT_FOUND;
+
+    int n = 0;
+    for(int i=0; i < depth; i++)
+        n = nodes[n].children[path[i]];
+
+    for(int i=0; i < TM_PERF_LAST; i++)
+        values[i] = nodes[n].counts[i];
+
+    return TM_ERR_OK;
+}
+
+static void profile_report_node(FILE* f, int n, int level) {
+    struct node* node = &nodes[n];
+    uint64_t children = 0;
+
+    for(int i=0; i < TM_REGION_LAST; i++) {
+        if(node->children[i] >= 0)
+            children += nodes[node->children[i]].total;
+    }
+
+    if(n > 0) {
+        uint64_t parent = nodes[node->parent].total;
+        fprintf(f, "%*s%-*s %10ld %12.6f %12.6f %12.3f %6.1f%%",
+                2 * (level - 1), "", 20 - 2 * (level - 1), region_names[node->region],
+                node->count,
+                node->total * 1e-9,
+                (node->total - children) * 1e-9,
+                node->count > 0 ? node->total * 1e-3 / node->count : 0,
+                parent > 0 ? 100. * node->total / parent : 100.);
+
+        // hardware counters, per call
+        if(level <= max_counters_depth && node->count > 0) {
+            fprintf(f, " %6.2f", node->counts[TM_PERF_INSTRUCTIONS] / node->counts[TM_PERF_CYCLES]);
+            for(int i=TM_PERF_L1D_MISSES; i < TM_PERF_LAST; i++)
+                fprintf(f, " %14.1f", node->counts[i] / node->count);
+        }
+
+        fprintf(f, "\n");
+    }
+
+    for(int i=0; i < TM_REGION_LAST; i++) {
+        if(node->children[i] >= 0)
+            profile_report_node(f, node->children[i], level + 1);
+    }
+}
+
+/**
+ * Write a summary of the measurements, as a tree of regions.
+ * @pre \code{.c}
+ * f != NULL
+ * \endcode
+ * @param f where to write
+ * @return \p TM_ERR_OK
+ */
+int tm_profile_report(FILE* f) {
+    assert(f != NULL);
+
+    if(N_nodes == 0)
+        return TM_ERR_OK;
+
+    fprintf(f, "%-20s %10s %12s %12s %12s %7s", "region", "count", "total (s)", "self (s)", "avg (us)", "parent");
+    if(max_counters_depth > 0) {
+        fprintf(f, " %6s", "IPC");
+        for(int i=TM_PERF_L1D_MISSES; i < TM_PERF_LAST; i++)
+            fprintf(f, " %14s", tm_perf_counters_name(i));
+    }
+
+    fprintf(f, "\n");
+
+    // the root takes the time of its children
+    nodes[0].total = 0;
+    for(int i=0; i < TM_REGION_LAST; i++) {
+        if(nodes[0].children[i] >= 0)
+            nodes[0].total += nodes[nodes[0].children[i]].total;
+    }
+
+    profile_report_node(f, 0, 0);
+
+    if(N_dropped > 0)
+        fprintf(f, "(%ld events were not traced)\n", N_dropped);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Write the trace, in the Chrome trace event format (which can be opened in \p chrome://tracing or Perfetto).
+ * @pre \code{.c}
+ * f != NULL
+ * \endcode
+ * @param f where to write
+ * @return \p TM_ERR_OK
+ */
+int tm_profile_write_trace(FILE* f) {
+    assert(f != NULL);
+
+    fprintf(f, "{\"traceEvents\": [");
+    for(long i=0; i < N_events; i++) {
+        fprintf(f, "%s\n{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1, \"args\": {\"depth\": %d}}",
+                i > 0 ? "," : "",
+                region_names[events[i].region],
+                events[i].start * 1e-3,
+                events[i].duration * 1e-3,
+                events[i].depth);
+    }
+
+    fprintf(f, "\n], \"displayTimeUnit\": \"ms\"}\n");
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Disable profiling, and free the trace.
+ * @return \p TM_ERR_OK
+ */
+int tm_profile_finalize() {
+    enabled = 0;
+
+    if(counters != NULL) {
+        tm_perf_counters_delete(counters);
+        counters = NULL;
+    }
+
+    max_counters_depth = 0;
+
+    tm_free(events);
+    events = NULL;
+    N_events = events_size = N_dropped = 0;
+    max_trace_depth = -1;
+
+    return TM_ERR_OK;
+}
@@ -0,0 +1,48 @@
+#ifndef TOYMC_PROFILE_H
+#define TOYMC_PROFILE_H
+
+#include <stdio.h>
+
+#define TM_PROFILE_MAX_DEPTH 16
+#define TM_PROFILE_MAX_NODES 128
+#define TM_PROFILE_MAX_EVENTS (1l << 20)
+
+/**
+ * @brief Timed regions. They can be nested, and the same region is timed separately for each of its parents.
+ */
+typedef enum tm_profile_region_ {
+    TM_REGION_RUN, // whole run
+    TM_REGION_SETUP, // preparation of the box
+    TM_REGION_SWEEP, // one sweep over all atoms
+    TM_REGION_ENERGY, // energy evaluation
+    TM_REGION_MOVE, // generation of a trial move
+    TM_REGION_ACCEPT, // acceptance or rejection of a move
+    TM_REGION_IO, // input and output
+    TM_REGION_COMM, // communication
+
+    TM_REGION_LAST
+} tm_profile_region;
+
+/* When compiled without `TM_USE_PROFILE`, the macros do not generate any code.
+ * Otherwise, they cost a test when profiling is not enabled at runtime (see tm_profile_init()),
+ * and a couple of reads of the clock when it is.
+ */
+#ifdef TM_USE_PROFILE
+#define TM_PROFILE_BEGIN(region) tm_profile_begin(region)
+#define TM_PROFILE_END(region) tm_profile_end(region)
+#else
+#define TM_PROFILE_BEGIN(region) ((void) 0)
+#define TM_PROFILE_END(region) ((void) 0)
+#endif
+
+int tm_profile_init(int trace_depth);
+int tm_profile_use_counters(int depth);
+void tm_profile_begin(tm_profile_region region);
+void tm_profile_end(tm_profile_region region);
+int tm_profile_get(tm_profile_region* path, int depth, long* count, double* total);
+int tm_profile_get_counters(tm_profile_region* path, int depth, double* values);
+int tm_profile_report(FILE* f);
+int tm_profile_write_trace(FILE* f);
+int tm_profile_finalize();
+
+#endif //TOYMC_PROFILE_H
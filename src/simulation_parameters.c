@@ -1,13 +1,15 @@
 #include <assert.h>
 #include "simulation_parameters.h"
+#include "memory.h"
 #include "files.h"
+#include "geometry.h"
 
 /**
  * Create a \p tm_simulation_parameters structure and sets default parameters
  * @return a valid  \p tm_simulation_parameters structure, of \p NULL if \p malloc did not succeed.
  */
 tm_simulation_parameters* tm_simulation_parameters_new() {
-    tm_simulation_parameters* p = malloc(sizeof(tm_simulation_parameters));
+    tm_simulation_parameters* p = tm_malloc(sizeof(tm_simulation_parameters), TM_MEM_PARAMETERS);
 
     if(p != NULL) {
         p->n_steps = 1;
@@ -23,10 +25,24 @@ tm_simulation_parameters* tm_simulation_parameters_new() {
         p->temperature = 1.;
         p->delta_displacement = .1;
 
+        p->N_species = 0;
+        p->species = NULL;
+        p->composition = NULL;
+        p->epsilon = NULL;
+        p->sigma = NULL;
+        p->mixing_rule = TM_MIXING_LORENTZ_BERTHELOT;
+        p->sort_species = 1;
+
+        tm_potential_find("lj", &(p->potential));
+        p->potential_alpha = 0;
+
         p->use_NpT = 0;
         p->target_pressure = 1.;
         p->delta_volume = .1;
         p->pressure_freq = 1;
+        p->reorder_freq = 0;
+        p->single_precision = 0;
+        p->fixed_point = 0;
     }
 
     return p;
@@ -56,35 +72,35 @@ int simulation_parameter_fill_single_value_key(tm_parf_t* elmt, char type, void
     int error = TM_ERR_OK;
     if(type == 'i') {
         if(elmt->val_type != TM_T_INTEGER) {
-            tm_print_error_msg(__FILE__, __LINE__, "key %s: expected type %d, got %d", elmt->key, TM_T_INTEGER, elmt->val_type);
+            TM_ERROR("key %s: expected type %d, got %d", elmt->key, TM_T_INTEGER, elmt->val_type);
             error = TM_ERR_PARAMETER_FILE;
         } else {
             tm_parf_integer_value(elmt, (long *) ptr);
         }
     } else if(type == 'b') {
         if(elmt->val_type != TM_T_BOOLEAN) {
-            tm_print_error_msg(__FILE__, __LINE__, "key %s: expected type %d, got %d\n", elmt->key, TM_T_BOOLEAN, elmt->val_type);
+            TM_ERROR("key %s: expected type %d, got %d\n", elmt->key, TM_T_BOOLEAN, elmt->val_type);
             error = TM_ERR_PARAMETER_FILE;
         } else {
             tm_parf_boolean_value(elmt, (int*) ptr);
         }
     } else if(type == 'r') {
         if(elmt->val_type != TM_T_REAL) {
-            tm_print_error_msg(__FILE__, __LINE__, "key %s: expected type %d, got %d\n", elmt->key, TM_T_REAL, elmt->val_type);
+            TM_ERROR("key %s: expected type %d, got %d\n", elmt->key, TM_T_REAL, elmt->val_type);
             error = TM_ERR_PARAMETER_FILE;
         } else {
             tm_parf_real_value(elmt, (double *) ptr);
         }
     } else if(type == 's') {
         if(elmt->val_type != TM_T_STRING) {
-            tm_print_error_msg(__FILE__, __LINE__, "key %s: expected type %d, got %d\n", elmt->key, TM_T_STRING, elmt->val_type);
+            TM_ERROR("key %s: expected type %d, got %d\n", elmt->key, TM_T_STRING, elmt->val_type);
             error = TM_ERR_PARAMETER_FILE;
         } else {
             char* val, *dest;
             unsigned int sz;
             tm_parf_string_value(elmt, &val);
             tm_parf_string_length(elmt, &sz);
-            dest = malloc(sizeof(char) * (sz + 1));
+            dest = tm_malloc(sizeof(char) * (sz + 1), TM_MEM_PARAMETERS);
             if (dest == NULL) {
                 error = TM_ERR_MALLOC;
             } else {
@@ -117,7 +133,7 @@ int simulation_parameter_fill_multiple_values_key(tm_parf_t* elmt, char* types,
     tm_parf_list_length(elmt, &szi);
 
     if (sz != szi) {
-        tm_print_error_msg(__FILE__, __LINE__, "key %s: expected size %d, got %d", elmt->key, sz, szi);
+        TM_ERROR("key %s: expected size %d, got %d", elmt->key, sz, szi);
         return TM_ERR_PARAMETER_FILE;
     }
 
@@ -136,8 +152,23 @@ int simulation_parameter_fill_multiple_values_key(tm_parf_t* elmt, char* types,
             break;
     }
 
+    // packed list: copy all at once
+    long* vals_int;
+    double* vals_real;
+    if(types[0] == 'i' && tm_parf_list_integers(elmt, &vals_int, &szi) == TM_ERR_OK) {
+        memcpy(ptr, vals_int, sz * szp);
+        return TM_ERR_OK;
+    } else if(types[0] == 'r' && tm_parf_list_reals(elmt, &vals_real, &szi) == TM_ERR_OK) {
+        memcpy(ptr, vals_real, sz * szp);
+        return TM_ERR_OK;
+    }
+
+    // otherwise, element by element
     int error = 0;
     tm_parf_iterator* it = tm_parf_iterator_new(elmt);
+    if(it == NULL)
+        return TM_ERR_MALLOC;
+
     tm_parf_t* elmt_list;
     char* ptr2 = (char*) ptr;
     for(unsigned int i = 0; i < szi && error == TM_ERR_OK; i++) {
@@ -150,6 +181,170 @@ int simulation_parameter_fill_multiple_values_key(tm_parf_t* elmt, char* types,
 }
 
 
+/**
+ * Fill the species from the object:
+ * \code
+ * species ["A" "B"] # names, mandatory if one of the following keys is set
+ * composition [100 50] # number of atoms of each species, mandatory
+ * epsilon [1. 1.2] # LJ parameters of each species, 1. if not set
+ * sigma [1. .9]
+ * mixing_rule "lorentz-berthelot" # or "geometric"
+ * \endcode
+ * @pre \code{.c}
+ * p != NULL && obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_OBJECT)
+ * \endcode
+ * @param p the parameters
+ * @param obj the object
+ * @return \p TM_ERR_OK if everything went well, something else otherwise.
+ * @post \p p is set accordingly.
+ */
+int simulation_parameters_fill_species(tm_simulation_parameters* p, tm_parf_t* obj) {
+    assert(p != NULL && obj != NULL);
+    assert(!TM_PARF_CHECK_P(obj, TM_T_OBJECT));
+
+    tm_parf_t* elmt;
+    char* keys[] = {"composition", "epsilon", "sigma", "mixing_rule"};
+
+    if(tm_parf_object_get(obj, "species", &elmt) != TM_ERR_OK) {
+        for(int i=0; i < 4; i++) {
+            if(tm_parf_object_get(obj, keys[i], &elmt) == TM_ERR_OK) {
+                TM_ERROR("key %s requires species", keys[i]);
+                return TM_ERR_SIMULATION_PARAMETERS;
+            }
+        }
+
+        return TM_ERR_OK;
+    }
+
+    // names
+    unsigned int N;
+    if(TM_PARF_CHECK_P(elmt, TM_T_LIST) || tm_parf_list_length(elmt, &N) != TM_ERR_OK || N == 0 || N > TM_GEOMETRY_MAX_TYPES) {
+        TM_ERROR("key species: expected a list of 1 to %d names", TM_GEOMETRY_MAX_TYPES);
+        return TM_ERR_SIMULATION_PARAMETERS;
+    }
+
+    p->species = tm_calloc(N, sizeof(char*), TM_MEM_PARAMETERS);
+    p->composition = tm_malloc(N * sizeof(long), TM_MEM_PARAMETERS);
+    p->epsilon = tm_malloc(N * sizeof(double), TM_MEM_PARAMETERS);
+    p->sigma = tm_malloc(N * sizeof(double), TM_MEM_PARAMETERS);
+    if(p->species == NULL || p->composition == NULL || p->epsilon == NULL || p->sigma == NULL)
+        return TM_ERR_MALLOC;
+
+    p->N_species = (int) N;
+
+    int error = TM_ERR_OK;
+    tm_parf_t* elmt_list;
+    for(unsigned int i=0; i < N && error == TM_ERR_OK; i++) {
+        tm_parf_list_get(elmt, (int) i, &elmt_list);
+        error = simulation_parameter_fill_single_value_key(elmt_list, 's', &(p->species[i]));
+
+        for(unsigned int j=0; j < i && error == TM_ERR_OK; j++) {
+            if(strcmp(p->species[i], p->species[j]) == 0) {
+                TM_ERROR("species %s is defined twice", p->species[i]);
+                error = TM_ERR_SIMULATION_PARAMETERS;
+            }
+        }
+    }
+
+    if(error != TM_ERR_OK)
+        return error;
+
+    // lists of values
+    char types[16];
+    void* ptrs[] = {p->composition, p->epsilon, p->sigma};
+
+    for(unsigned int i=0; i < N; i++)
+        p->epsilon[i] = p->sigma[i] = 1.;
+
+    for(int i=0; i < 3 && error == TM_ERR_OK; i++) {
+        if(tm_parf_object_get(obj, keys[i], &elmt) != TM_ERR_OK) {
+            if(i == 0) {
+                TM_ERROR("key composition is mandatory with species");
+                error = TM_ERR_SIMULATION_PARAMETERS;
+            }
+
+            continue;
+        }
+
+        if(TM_PARF_CHECK_P(elmt, TM_T_LIST)) {
+            TM_ERROR("key %s: expected a list", keys[i]);
+            error = TM_ERR_SIMULATION_PARAMETERS;
+        } else {
+            snprintf(types, 16, "%c%u", i == 0 ? 'i' : 'r', N);
+            error = simulation_parameter_fill_multiple_values_key(elmt, types, ptrs[i]);
+        }
+    }
+
+    for(unsigned int i=0; i < N && error == TM_ERR_OK; i++) {
+        if(p->composition[i] < 0 || p->epsilon[i] <= 0 || p->sigma[i] <= 0) {
+            TM_ERROR("species %s: composition, epsilon and sigma must be positive", p->species[i]);
+            error = TM_ERR_SIMULATION_PARAMETERS;
+        }
+    }
+
+    if(error != TM_ERR_OK)
+        return error;
+
+    // mixing rule
+    if(tm_parf_object_get(obj, "mixing_rule", &elmt) == TM_ERR_OK) {
+        char* name;
+        if(TM_PARF_CHECK_P(elmt, TM_T_STRING)) {
+            TM_ERROR("key mixing_rule: expected a string");
+            return TM_ERR_PARAMETER_FILE;
+        }
+
+        tm_parf_string_value(elmt, &name);
+        if(tm_mixing_rule_find(name, &(p->mixing_rule)) != TM_ERR_OK) {
+            TM_ERROR("unknown mixing rule %s", name);
+            return TM_ERR_SIMULATION_PARAMETERS;
+        }
+    }
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Fill the potential from the object:
+ * \code
+ * potential "lj" # or "wca", "sf-lj", "morse" or "buckingham"
+ * potential_alpha 14. # shape parameter of morse (> 0) and buckingham (> 6), 0 for the default
+ * \endcode
+ * @pre \code{.c}
+ * p != NULL && obj != NULL && !TM_PARF_CHECK_P(obj, TM_T_OBJECT)
+ * \endcode
+ * @param p the parameters
+ * @param obj the object
+ * @return \p TM_ERR_OK if everything went well, something else otherwise.
+ * @post \p p is set accordingly.
+ */
+int simulation_parameters_fill_potential(tm_simulation_parameters* p, tm_parf_t* obj) {
+    assert(p != NULL && obj != NULL);
+    assert(!TM_PARF_CHECK_P(obj, TM_T_OBJECT));
+
+    tm_parf_t* elmt;
+
+    if(tm_parf_object_get(obj, "potential", &elmt) == TM_ERR_OK) {
+        char* name;
+        if(TM_PARF_CHECK_P(elmt, TM_T_STRING)) {
+            TM_ERROR("key potential: expected a string");
+            return TM_ERR_PARAMETER_FILE;
+        }
+
+        tm_parf_string_value(elmt, &name);
+        if(tm_potential_find(name, &(p->potential)) != TM_ERR_OK) {
+            TM_ERROR("unknown potential %s", name);
+            return TM_ERR_SIMULATION_PARAMETERS;
+        }
+    }
+
+    if(!TM_POTENTIAL_ALPHA_IS_VALID(p->potential, p->potential_alpha)) {
+        TM_ERROR("key potential_alpha: expected a value larger than %g for %s", p->potential->alpha_min, p->potential->name);
+        return TM_ERR_SIMULATION_PARAMETERS;
+    }
+
+    return TM_ERR_OK;
+}
+
 /**
  * Fill the parameters from the object
  * @pre \code{.c}
@@ -172,9 +367,13 @@ int tm_simulation_parameter_fill(tm_simulation_parameters* p, tm_parf_t* obj) {
             {"output_freq", "i", &(p->output_freq)},
             {"print_freq", "i", &(p->print_freq)},
             {"pressure_freq", "i", &(p->pressure_freq)},
+            {"reorder_freq", "i", &(p->reorder_freq)},
 
             // boolean
             {"use_NpT", "b", &(p->use_NpT)},
+            {"sort_species", "b", &(p->sort_species)},
+            {"single_precision", "b", &(p->single_precision)},
+            {"fixed_point", "b", &(p->fixed_point)},
 
             // double
             {"VdW_cutoff", "r", &(p->VdW_cutoff)},
@@ -182,52 +381,78 @@ int tm_simulation_parameter_fill(tm_simulation_parameters* p, tm_parf_t* obj) {
             {"delta_displacement", "r", &(p->delta_displacement)},
             {"target_pressure", "r", &(p->target_pressure)},
             {"delta_volume", "r", &(p->delta_volume)},
+            {"potential_alpha", "r", &(p->potential_alpha)},
 
             // string
             {"output", "s", &(p->path_output)},
             {"coordinates", "s", &(p->path_coordinates)},
 
             // list
-            {"box_length", "r3", &(p->box_length)}
+            {"box_length", "r3", &(p->box_length)},
+
+            // species (see simulation_parameters_fill_species())
+            {"species", "*", NULL},
+            {"composition", "*", NULL},
+            {"epsilon", "*", NULL},
+            {"sigma", "*", NULL},
+            {"mixing_rule", "*", NULL},
+
+            // potential (see simulation_parameters_fill_potential())
+            {"potential", "*", NULL}
     };
 
     int num_keys = sizeof(keys) / sizeof(*keys);
 
-    // crawl in
-    tm_parf_iterator * it = tm_parf_iterator_new(obj);
+    // bind keys
     tm_parf_t* elmt;
-    int found, error;
-
-    while(tm_parf_iterator_has_next(it)) {
-        tm_parf_iterator_next(it, &elmt);
-        found = 0;
-        error = 0;
-
-        for(int i=0; i < num_keys && !found; i++) {
-            if(strcmp(keys[i].key, elmt->key) == 0) {
-                found = 1;
-                tm_print_debug_msg(__FILE__, __LINE__, "treating key %s (kind %s)", keys[i].key, keys[i].types);
-                if(strlen(keys[i].types) == 1) {
-                    error = simulation_parameter_fill_single_value_key(elmt, keys[i].types[0], keys[i].ptr);
-                } else {
-                    error = simulation_parameter_fill_multiple_values_key(elmt, keys[i].types, keys[i].ptr);
-                }
-            }
-        }
+    unsigned int num_found = 0;
+    int error = TM_ERR_OK;
 
-        if(error != TM_ERR_OK) {
-            tm_parf_iterator_delete(it);
-            return error;
-        }
+    for(int i=0; i < num_keys && error == TM_ERR_OK; i++) {
+        if(tm_parf_object_get(obj, keys[i].key, &elmt) != TM_ERR_OK)
+            continue;
 
-        if(!found) {
-            tm_print_warning_msg(__FILE__, __LINE__, "key %s is unknown, maybe there is a mistake?", elmt->key);
+        num_found++;
+        TM_DEBUG("treating key %s (kind %s)", keys[i].key, keys[i].types);
+        if(keys[i].types[0] == '*') {
+            continue;
+        } else if(strlen(keys[i].types) == 1) {
+            error = simulation_parameter_fill_single_value_key(elmt, keys[i].types[0], keys[i].ptr);
+        } else {
+            error = simulation_parameter_fill_multiple_values_key(elmt, keys[i].types, keys[i].ptr);
         }
     }
 
-    tm_parf_iterator_delete(it);
+    if(error == TM_ERR_OK)
+        error = simulation_parameters_fill_species(p, obj);
+
+    if(error == TM_ERR_OK)
+        error = simulation_parameters_fill_potential(p, obj);
+
+    if(error != TM_ERR_OK)
+        return error;
+
+    // look for unknown keys, if any
+    if(num_found < obj->val_size) {
+        tm_parf_iterator * it = tm_parf_iterator_new(obj);
+        int found;
+
+        while(tm_parf_iterator_has_next(it)) {
+            tm_parf_iterator_next(it, &elmt);
+            found = 0;
+
+            for(int i=0; i < num_keys && !found; i++)
+                found = strcmp(keys[i].key, elmt->key) == 0;
 
-    return 0;
+            if(!found) {
+                TM_WARNING("key %s is unknown, maybe there is a mistake?", elmt->key);
+            }
+        }
+
+        tm_parf_iterator_delete(it);
+    }
+
+    return TM_ERR_OK;
 }
 
 /**
@@ -250,7 +475,7 @@ int tm_simulation_parameters_read(tm_simulation_parameters* p, FILE* f) {
 
     // getting object
     tm_parf_t* obj = tm_parf_loads(buffer);
-    free(buffer);
+    tm_free(buffer);
 
     if (obj == NULL) {
         return TM_ERR_PARAMETER_FILE;
@@ -274,11 +499,29 @@ int tm_simulation_parameters_delete(tm_simulation_parameters* p) {
     assert(p != NULL);
 
     if(p->path_output != NULL)
-        free(p->path_output);
+        tm_free(p->path_output);
 
     if(p->path_coordinates != NULL)
-        free(p->path_coordinates);
+        tm_free(p->path_coordinates);
+
+    if(p->species != NULL) {
+        for(int i=0; i < p->N_species; i++) {
+            if(p->species[i] != NULL)
+                tm_free(p->species[i]);
+        }
+
+        tm_free(p->species);
+    }
+
+    if(p->composition != NULL)
+        tm_free(p->composition);
+
+    if(p->epsilon != NULL)
+        tm_free(p->epsilon);
+
+    if(p->sigma != NULL)
+        tm_free(p->sigma);
 
-    free(p);
+    tm_free(p);
     return TM_ERR_OK;
 }
@@ -5,6 +5,7 @@
 
 #include "param_file_objects.h"
 #include "param_file_parser.h"
+#include "pair_coefs.h"
 #include <time.h>
 
 typedef struct tm_simulation_parameters_ {
@@ -19,16 +20,36 @@ typedef struct tm_simulation_parameters_ {
     // calculation (NVT)
     long seed;
     char* path_coordinates;
-    double box_length[3];
+    double box_length[3]; // shape of the box (scaled to the density)
     double VdW_cutoff;
     double temperature;
     double delta_displacement;
 
+    // species (if N_species is 0, there is a single species, in reduced units)
+    int N_species;
+    char** species; // name of each species
+    long* composition; // number of atoms of each species
+    double* epsilon; // LJ epsilon of each species
+    double* sigma; // LJ sigma of each species
+    tm_mixing_rule mixing_rule;
+    int sort_species; // keep the atoms sorted by species
+
+    // potential (parameters derived from the epsilon and sigma of each pair)
+    tm_potential* potential;
+    double potential_alpha; // shape parameter, 0 for the default of the potential
+
     // calculation (NpT)
     int use_NpT;
     double target_pressure;
     double delta_volume;
     long pressure_freq;
+
+    // distances in single precision (see tm_mc_use_single_precision()), positions in fixed point (see tm_mc_use_fixed_point())
+    int single_precision;
+    int fixed_point;
+
+    // atoms are reordered every reorder_freq sweeps (0 for never, see tm_mc_reorder())
+    long reorder_freq;
 } tm_simulation_parameters;
 
 tm_simulation_parameters* tm_simulation_parameters_new();
@@ -0,0 +1,200 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "status.h"
+#include "memory.h"
+#include "errors.h"
+
+// platforms without MSG_NOSIGNAL set SO_NOSIGPIPE on the client socket instead
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define TM_STATUS_POLL_MS 100
+
+/* Resident memory of the process, in bytes (-1 if not available)
+ */
+static long status_memory() {
+    long size, resident = -1;
+    FILE* f = fopen("/proc/self/statm", "r");
+
+    if(f != NULL) {
+        if(fscanf(f, "%ld %ld", &size, &resident) != 2)
+            resident = -1;
+        else
+            resident *= sysconf(_SC_PAGESIZE);
+
+        fclose(f);
+    }
+
+    return resident;
+}
+
+static int status_write_json(tm_status_server* server, int fd) {
+    tm_status s;
+    char buffer[1024];
+
+    tm_status_server_read(server, &s);
+
+    double moves_per_s = s.elapsed > 0 ? (double) s.N_moves / s.elapsed : 0;
+    double acceptance = s.N_moves > 0 ? (double) s.N_accepted / (double) s.N_moves : 0;
+    double eta = s.sweep > 0 ? s.elapsed / (double) s.sweep * (double) (s.n_sweeps - s.sweep) : -1;
+    long memory = status_memory();
+    tm_memory_stats tracked;
+    tm_memory_stats_get(TM_MEM_LAST, &tracked);
+
+    int sz = snprintf(buffer, 1024,
+                      "{\"sweep\": %ld, \"n_sweeps\": %ld, \"elapsed\": %.3f, \"eta\": %.3f, \"moves_per_s\": %.1f, "
+                      "\"acceptance\": %.4f, \"U\": %.6f, \"P\": %.6f, \"memory\": %ld, \"memory_tracked\": %ld, \"memory_tracked_peak\": %ld}\n",
+                      s.sweep, s.n_sweeps, s.elapsed, eta, moves_per_s, acceptance, s.U, s.P, memory, tracked.current, tracked.peak);
+
+    // a client that disconnects early must not kill the simulation with SIGPIPE
+    return send(fd, buffer, sz, MSG_NOSIGNAL) == sz ? TM_ERR_OK : TM_ERR_WRITE;
+}
+
+static void* status_serve(void* arg) {
+    tm_status_server* server = arg;
+    struct pollfd pfd = {server->fd, POLLIN, 0};
+
+    while (!__atomic_load_n(&server->stop, __ATOMIC_ACQUIRE)) {
+        if(poll(&pfd, 1, TM_STATUS_POLL_MS) > 0 && (pfd.revents & POLLIN)) {
+            int client = accept(server->fd, NULL, NULL);
+            if(client >= 0) {
+#ifdef SO_NOSIGPIPE
+                int one = 1;
+                setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+                status_write_json(server, client);
+                close(client);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Create a socket at \p path and start serving the status (which is initially empty).
+ * An existing socket at \p path is replaced.
+ * @pre \code{.c}
+ * path != NULL
+ * \endcode
+ * @param path path of the socket
+ * @return the server, \p NULL if it could not be created (invalid path, \p malloc failed, etc)
+ */
+tm_status_server* tm_status_server_new(char* path) {
+    assert(path != NULL);
+
+    struct sockaddr_un addr;
+    if(strlen(path) >= sizeof(addr.sun_path))
+        return NULL;
+
+    tm_status_server* server = tm_malloc(sizeof(tm_status_server), TM_MEM_INSTRUMENTATION);
+    if(server == NULL)
+        return NULL;
+
+    server->path = tm_malloc(strlen(path) + 1, TM_MEM_INSTRUMENTATION);
+    server->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(server->path == NULL || server->fd < 0) {
+        if(server->fd >= 0)
+            close(server->fd);
+        tm_free(server->path);
+        tm_free(server);
+        return NULL;
+    }
+
+    strcpy(server->path, path);
+    server->stop = 0;
+    server->seq = 0;
+    memset(&server->status, 0, sizeof(tm_status));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if(bind(server->fd, (struct sockaddr*) &addr, sizeof(addr)) != 0
+        || listen(server->fd, 8) != 0
+        || pthread_create(&server->thread, NULL, status_serve, server) != 0) {
+        close(server->fd);
+        unlink(path);
+        tm_free(server->path);
+        tm_free(server);
+        return NULL;
+    }
+
+    return server;
+}
+
+/**
+ * Publish the status. Never waits for the thread that serves it.
+ * @pre \code{.c}
+ * server != NULL && status != NULL
+ * \endcode
+ * @param server the server
+ * @param status the status (copied)
+ */
+void tm_status_server_publish(tm_status_server* server, tm_status* status) {
+    assert(server != NULL && status != NULL);
+
+    unsigned int seq = __atomic_load_n(&server->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&server->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(&server->status, status, sizeof(tm_status));
+
+    __atomic_store_n(&server->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * Get a consistent copy of the last published status.
+ * @pre \code{.c}
+ * server != NULL && status != NULL
+ * \endcode
+ * @param server the server
+ * @param[out] status the status
+ * @return \p TM_ERR_OK
+ */
+int tm_status_server_read(tm_status_server* server, tm_status* status) {
+    assert(server != NULL && status != NULL);
+
+    unsigned int seq_before, seq_after;
+    do {
+        seq_before = __atomic_load_n(&server->seq, __ATOMIC_ACQUIRE);
+        memcpy(status, &server->status, sizeof(tm_status));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_after = __atomic_load_n(&server->seq, __ATOMIC_RELAXED);
+    } while ((seq_before & 1) || seq_before != seq_after);
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Stop serving, and remove the socket.
+ * @pre \code{.c}
+ * server != NULL
+ * \endcode
+ * @param server the server
+ * @return \p TM_ERR_OK
+ */
+int tm_status_server_delete(tm_status_server* server) {
+    assert(server != NULL);
+
+    __atomic_store_n(&server->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(server->thread, NULL);
+
+    close(server->fd);
+    unlink(server->path);
+
+    tm_free(server->path);
+    tm_free(server);
+
+    return TM_ERR_OK;
+}
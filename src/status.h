@@ -0,0 +1,56 @@
+#ifndef TOYMC_STATUS_H
+#define TOYMC_STATUS_H
+
+#include <pthread.h>
+
+/**
+ * @brief Status of a run, as published by the simulation.
+ * Fields are \code{.c}
+ * long sweep; // number of sweeps done
+ * long n_sweeps; // total number of sweeps
+ * double elapsed; // time since the beginning of the run (in second)
+ * long N_moves; // number of trial moves
+ * long N_accepted; // number of accepted moves
+ * double U; // energy
+ * double P; // pressure
+ * \endcode
+ */
+typedef struct tm_status_ {
+    long sweep;
+    long n_sweeps;
+    double elapsed;
+    long N_moves;
+    long N_accepted;
+    double U;
+    double P;
+} tm_status;
+
+/**
+ * @brief Serve the status of the run as JSON, to any client that connects to a Unix domain socket.
+ * Connections are handled by a separate thread, while the simulation publishes its status without ever waiting
+ * (the status is protected by a sequence lock: the reader retries if it was modified while being copied).
+ * Fields are \code{.c}
+ * char* path; // path of the socket
+ * int fd; // listening socket
+ * pthread_t thread; // thread that handles connections
+ * int stop; // set to stop the thread
+ * unsigned int seq; // sequence number (odd while the status is written)
+ * tm_status status; // last published status
+ * \endcode
+ */
+typedef struct tm_status_server_ {
+    char* path;
+    int fd;
+    pthread_t thread;
+    int stop;
+
+    unsigned int seq;
+    tm_status status;
+} tm_status_server;
+
+tm_status_server* tm_status_server_new(char* path);
+void tm_status_server_publish(tm_status_server* server, tm_status* status);
+int tm_status_server_read(tm_status_server* server, tm_status* status);
+int tm_status_server_delete(tm_status_server* server);
+
+#endif //TOYMC_STATUS_H
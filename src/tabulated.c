@@ -0,0 +1,220 @@
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "tabulated.h"
+#include "memory.h"
+#include "errors.h"
+
+/**
+ * Add the (interpolated) energy and virial of \p N pairs.
+ * @pre \code{.c}
+ * table != NULL && r2 != NULL && U != NULL && vir != NULL
+ * \endcode
+ * @param table the table
+ * @param N number of pairs
+ * @param r2 square of the distances, as array of size N (unchanged)
+ * @param [out] U the energy
+ * @param [out] vir the virial
+ * @post results are added to \p U and \p vir.
+ */
+void tm_table_sum_N(tm_table* table, long N, double* r2, double* U, double* vir) {
+    assert(table != NULL && r2 != NULL && U != NULL && vir != NULL);
+
+    double s_min = table->s_min, s_max = table->s_max, inv_ds = table->inv_ds, sU = 0, svir = 0;
+    long last = table->N_intervals - 1;
+    double* restrict coefs = table->coefs;
+    double* restrict r2_ = r2;
+
+    #pragma omp simd reduction(+:sU,svir)
+    for(long j=0; j < N; j++) {
+        int in = r2_[j] < s_max;
+        double s = in && r2_[j] > s_min ? r2_[j] : s_min;
+        double x = (s - s_min) * inv_ds;
+        long k = (long) x;
+        k = k < last ? k : last;
+
+        double t = x - (double) k, *c = coefs + TM_TABLE_STRIDE * k;
+        double u = ((c[3] * t + c[2]) * t + c[1]) * t + c[0], w = ((c[7] * t + c[6]) * t + c[5]) * t + c[4];
+
+        sU += in ? u : 0;
+        svir += in ? w : 0;
+    }
+
+    *U += sU;
+    *vir += svir;
+}
+
+/* Clamped cubic spline through y[0:n+1] (one unit between points), with the given derivatives at both ends.
+ * The polynomial of each interval is stored at coefs[k * TM_TABLE_STRIDE + offset], scratch must be of size 2*(n+1).
+ */
+static void table_spline(long n, double* y, double dy_start, double dy_end, double* scratch, double* coefs, int offset) {
+    double* M = scratch; // second derivatives
+    double* c = scratch + n + 1; // modified coefficients of the tridiagonal system
+
+    // forward sweep (Thomas algorithm)
+    c[0] = .5;
+    M[0] = 3. * ((y[1] - y[0]) - dy_start);
+    for(long i=1; i <= n; i++) {
+        double rhs, diag;
+        if(i < n) {
+            rhs = 6. * (y[i + 1] - 2. * y[i] + y[i - 1]);
+            diag = 4.;
+        } else {
+            rhs = 6. * (dy_end - (y[n] - y[n - 1]));
+            diag = 2.;
+        }
+
+        double m = diag - c[i - 1];
+        c[i] = 1. / m;
+        M[i] = (rhs - M[i - 1]) / m;
+    }
+
+    // back substitution
+    for(long i=n - 1; i >= 0; i--)
+        M[i] -= c[i] * M[i + 1];
+
+    for(long k=0; k < n; k++) {
+        double* p = coefs + k * TM_TABLE_STRIDE + offset;
+        p[0] = y[k];
+        p[1] = (y[k + 1] - y[k]) - (2. * M[k] + M[k + 1]) / 6;
+        p[2] = M[k] / 2;
+        p[3] = (M[k + 1] - M[k]) / 6;
+    }
+}
+
+// tabulate one pair
+static int table_fill(tm_table* table, tm_pair_function f, double* params, double s_min, double s_max, long n) {
+    double ds = (s_max - s_min) / (double) n, h = 1e-3 * ds, U1, U2, vir1, vir2;
+
+    table->s_min = s_min;
+    table->s_max = s_max;
+    table->inv_ds = 1. / ds;
+    table->N_intervals = n;
+
+    // 64 more bytes, to align the coefficients
+    table->block = tm_malloc((TM_TABLE_STRIDE * n + 8) * sizeof(double), TM_MEM_SIMULATION);
+    double* samples = tm_malloc(4 * (n + 1) * sizeof(double), TM_MEM_SIMULATION);
+
+    if(table->block == NULL || samples == NULL) {
+        tm_free(table->block);
+        tm_free(samples);
+        table->block = NULL;
+        return TM_ERR_MALLOC;
+    }
+
+    table->coefs = (double*) (((uintptr_t) table->block + 63) & ~((uintptr_t) 63));
+
+    double* y_U = samples, *y_vir = samples + n + 1, *scratch = samples + 2 * (n + 1);
+    for(long i=0; i <= n; i++)
+        f(s_min + (double) i * ds, params, &(y_U[i]), &(y_vir[i]));
+
+    // derivatives at both ends (per interval), by central differences
+    double dU[2], dvir[2], ends[2] = {s_min, s_max};
+    for(int e=0; e < 2; e++) {
+        f(ends[e] - h, params, &U1, &vir1);
+        f(ends[e] + h, params, &U2, &vir2);
+        dU[e] = (U2 - U1) / (2 * h) * ds;
+        dvir[e] = (vir2 - vir1) / (2 * h) * ds;
+    }
+
+    table_spline(n, y_U, dU[0], dU[1], scratch, table->coefs, 0);
+    table_spline(n, y_vir, dvir[0], dvir[1], scratch, table->coefs, 4);
+
+    tm_free(samples);
+    return TM_ERR_OK;
+}
+
+/**
+ * Tabulate a pair potential for each pair of types.
+ * @pre \code{.c}
+ * N_types > 0 && f != NULL && params != NULL && N_params > 0 && r2_min != NULL && rc2 != NULL && N_intervals > 0
+ * && (forall i < N_types*N_types, 0 < r2_min[i] < rc2[i])
+ * \endcode
+ * @param N_types number of types
+ * @param f the pair potential
+ * @param params parameters of \p f for each pair of types, as array of size N_types*N_types*N_params
+ * @param N_params number of parameters of \p f
+ * @param r2_min first point of the grid of each pair, as array of size N_types*N_types.
+ * The potential is constant below that, so it should be large enough for shorter distances to never happen.
+ * @param rc2 cutoff of each pair, as array of size N_types*N_types
+ * @param N_intervals number of intervals of each table
+ * @return the tables, \p NULL if \p malloc failed
+ */
+tm_pair_tables* tm_pair_tables_new(
+        int N_types, tm_pair_function f, double* params, int N_params, double* r2_min, double* rc2, long N_intervals) {
+    assert(N_types > 0 && f != NULL && params != NULL && N_params > 0 && r2_min != NULL && rc2 != NULL && N_intervals > 0);
+
+    tm_pair_tables* tables = tm_malloc(sizeof(tm_pair_tables), TM_MEM_SIMULATION);
+    if(tables == NULL)
+        return NULL;
+
+    tables->N_types = N_types;
+    tables->tables = tm_calloc(N_types * N_types, sizeof(tm_table), TM_MEM_SIMULATION);
+    if(tables->tables == NULL) {
+        tm_free(tables);
+        return NULL;
+    }
+
+    for(int p=0; p < N_types * N_types; p++) {
+        assert(r2_min[p] > 0 && r2_min[p] < rc2[p]);
+
+        if(table_fill(&(tables->tables[p]), f, params + p * N_params, r2_min[p], rc2[p], N_intervals) != TM_ERR_OK) {
+            tm_pair_tables_delete(tables);
+            return NULL;
+        }
+    }
+
+    return tables;
+}
+
+/**
+ * Tabulate the potential of \p coefs for each pair of types, from \f$0.7\sigma\f$ (where the LJ energy is about
+ * \f$290\epsilon\f$) to the cutoff.
+ * @pre \code{.c}
+ * coefs != NULL && N_intervals > 0
+ * \endcode
+ * @param coefs parameters of the potential of each pair of types
+ * @param N_intervals number of intervals of each table
+ * @return the tables, \p NULL if \p malloc failed
+ */
+tm_pair_tables* tm_pair_tables_new_from_coefs(tm_pair_coefs* coefs, long N_intervals) {
+    assert(coefs != NULL && N_intervals > 0);
+
+    int N_pairs = coefs->N_types * coefs->N_types;
+    double* r2_min = tm_malloc(N_pairs * sizeof(double), TM_MEM_SIMULATION);
+    if(r2_min == NULL)
+        return NULL;
+
+    for(int p=0; p < N_pairs; p++)
+        r2_min[p] = .49 * coefs->sigma[p] * coefs->sigma[p];
+
+    tm_pair_tables* tables = tm_pair_tables_new(
+            coefs->N_types, coefs->potential->function, coefs->params, TM_POTENTIAL_MAX_PARAMS, r2_min, coefs->rc2,
+            N_intervals);
+    tm_free(r2_min);
+
+    return tables;
+}
+
+/**
+ * Delete the tables.
+ * @pre \code{.c}
+ * tables != NULL
+ * \endcode
+ * @param tables the tables
+ * @return \p TM_ERR_OK
+ */
+int tm_pair_tables_delete(tm_pair_tables* tables) {
+    assert(tables != NULL);
+
+    for(int p=0; p < tables->N_types * tables->N_types; p++) {
+        if(tables->tables[p].block != NULL)
+            tm_free(tables->tables[p].block);
+    }
+
+    tm_free(tables->tables);
+    tm_free(tables);
+
+    return TM_ERR_OK;
+}
@@ -0,0 +1,78 @@
+#ifndef TOYMC_TABULATED_H
+#define TOYMC_TABULATED_H
+
+#include "potentials.h"
+#include "pair_coefs.h"
+
+// coefficients of each interval: 4 for the energy, then 4 for the virial (i.e., one cache line)
+#define TM_TABLE_STRIDE 8
+
+/**
+ * @brief A pair potential, tabulated on an uniform grid in \f$s = r^2\f$ and interpolated by cubic splines,
+ * so that neither square roots nor transcendental functions are needed to evaluate it.
+ * On interval \f$k\f$, with \f$t = (s - s_{min}) / \Delta s - k\f$, the energy is
+ * \f$\sum_n c_{8k+n}\,t^n\f$ and the virial is \f$\sum_n c_{8k+4+n}\,t^n\f$.
+ * Below \f$s_{min}\f$, the value at \f$s_{min}\f$ is used, while the potential is zero beyond \f$s_{max}\f$ (the cutoff).
+ * Fields are \code{.c}
+ * double s_min; // first point of the grid
+ * double s_max; // last point of the grid
+ * double inv_ds; // 1 / spacing of the grid
+ * long N_intervals; // number of intervals
+ * double* coefs; // coefficients, as array of size TM_TABLE_STRIDE*N_intervals (aligned on 64 bytes)
+ * void* block; // allocated block that contains the coefficients
+ * \endcode
+ */
+typedef struct tm_table_ {
+    double s_min;
+    double s_max;
+    double inv_ds;
+    long N_intervals;
+    double* coefs;
+    void* block;
+} tm_table;
+
+/**
+ * @brief A table for each pair of types. Pair (a, b) is at a * N_types + b.
+ * Fields are \code{.c}
+ * int N_types; // number of types
+ * tm_table* tables; // tables, as array of size N_types*N_types
+ * \endcode
+ */
+typedef struct tm_pair_tables_ {
+    int N_types;
+    tm_table* tables;
+} tm_pair_tables;
+
+/**
+ * Add the (interpolated) energy and virial of a pair.
+ * @pre \code{.c}
+ * table != NULL && U != NULL && vir != NULL
+ * \endcode
+ * @param table the table
+ * @param r2 square of the distance
+ * @param [out] U the energy
+ * @param [out] vir the virial
+ * @post results are added to \p U and \p vir.
+ */
+static inline void tm_table_eval(tm_table* table, double r2, double* U, double* vir) {
+    int in = r2 < table->s_max;
+    double s = in && r2 > table->s_min ? r2 : table->s_min;
+    double x = (s - table->s_min) * table->inv_ds;
+    long k = (long) x;
+    k = k < table->N_intervals ? k : table->N_intervals - 1;
+
+    double t = x - (double) k, *c = table->coefs + TM_TABLE_STRIDE * k;
+    double u = ((c[3] * t + c[2]) * t + c[1]) * t + c[0], w = ((c[7] * t + c[6]) * t + c[5]) * t + c[4];
+
+    *U += in ? u : 0;
+    *vir += in ? w : 0;
+}
+
+void tm_table_sum_N(tm_table* table, long N, double* r2, double* U, double* vir);
+
+tm_pair_tables* tm_pair_tables_new(
+        int N_types, tm_pair_function f, double* params, int N_params, double* r2_min, double* rc2, long N_intervals);
+tm_pair_tables* tm_pair_tables_new_from_coefs(tm_pair_coefs* coefs, long N_intervals);
+int tm_pair_tables_delete(tm_pair_tables* tables);
+
+#endif //TOYMC_TABULATED_H
@@ -1,21 +1,55 @@
 #ifndef TOYMC_TIMER_H
 #define TOYMC_TIMER_H
 
+#include <stdint.h>
 #include <time.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 /* Create a timer
  */
-void timer_start(struct timespec* t) {
+static inline void timer_start(struct timespec* t) {
     clock_gettime(CLOCK_MONOTONIC, t);
 }
 
 /* Get the elapsed time (in second)
  */
-double timer_stop(struct timespec* start) {
+static inline double timer_stop(struct timespec* start) {
     struct timespec stop;
     clock_gettime(CLOCK_MONOTONIC, &stop);
     return (double) (stop.tv_sec - start->tv_sec) + (double) (stop.tv_nsec - start->tv_nsec) * 1e-9;
 }
 
+/* Get a monotonic time (in nanosecond)
+ */
+static inline uint64_t timer_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000u + (uint64_t) t.tv_nsec;
+}
+
+/* Get a cheap timestamp, in ticks (TSC on x86, nanosecond otherwise)
+ */
+static inline uint64_t timer_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return timer_ns();
+#endif
+}
+
+/* Estimate the number of ticks per microsecond, by spinning for (about) `duration` second
+ */
+static inline double timer_ticks_per_us(double duration) {
+    uint64_t start_ns = timer_ns(), start = timer_ticks(), now_ns;
+
+    do {
+        now_ns = timer_ns();
+    } while ((double) (now_ns - start_ns) < duration * 1e9);
+
+    return (double) (timer_ticks() - start) / ((double) (now_ns - start_ns) * 1e-3);
+}
 
 #endif // TOYMC_TIMER_H
@@ -5,6 +5,8 @@
 #include <assert.h>
 
 #include "xyz_parser.h"
+#include "memory.h"
+#include "files.h"
 
 /**
  * Parse a (simple) real (without scientific notation):
@@ -90,20 +92,21 @@ int tm_xyz_parse_positive_int(tm_parf_token* tk, char* input, long *out) {
  * Parse an atom type \code
  * ATOM_TYPE := ALPHA (ALPHA | DIGIT)*
  * \endcode
- * Caller is responsible to free the result
+ * The result is not copied: \p out points to the beginning of the type in \p input.
  * @pre \code{.c}
- * tk != NULL && input != NULL && out != NULL
+ * tk != NULL && input != NULL && out != NULL && len != NULL
  * && 0 <= tk->position < strlen(input)
  * && tk->type == TM_TK_ALPHA
  * \endcode
  * @param tk valid token
  * @param input input string
- * @param out output
- * @post \p out is set
+ * @param out output (not NUL-terminated)
+ * @param len length of the output
+ * @post \p out and \p len are set
  * @return \p TM_ERR_OK if the value is set, something else otherwise
  */
-int tm_xyz_parse_atom_type(tm_parf_token* tk, char* input, char **out) {
-    assert(tk != NULL && input != NULL && out != NULL);
+int tm_xyz_parse_atom_type(tm_parf_token* tk, char* input, char **out, int* len) {
+    assert(tk != NULL && input != NULL && out != NULL && len != NULL);
     assert(tk->type == TM_TK_ALPHA);
 
     int pos_start = tk->position;
@@ -111,194 +114,230 @@ int tm_xyz_parse_atom_type(tm_parf_token* tk, char* input, char **out) {
     while((tk->type == TM_TK_ALPHA || tk->type == TM_TK_DIGIT) && tk->type != TM_TK_EOS)
         tm_lexer_advance(tk, input, 1);
 
-    *out = malloc((tk->position - pos_start + 1) * sizeof(char));
-    if(*out == NULL)
-        return TM_ERR_MALLOC;
-
-    memcpy(*out, input + pos_start, tk->position - pos_start);
-    (*out)[tk->position - pos_start] = '\0';
+    *out = input + pos_start;
+    *len = tk->position - pos_start;
 
     return TM_ERR_OK;
 }
 
 /**
- * Parse a string which represent a valid XYZ file
+ * Parse the title and coordinates of a frame, once the number of atoms is known.
  * @pre \code{.c}
- * input != NULL
+ * tk != NULL && input != NULL && g != NULL
  * \endcode
- * @param input the input
- * @return \p NULL if there was an error, the geometry otherwise
+ * @param tk valid token, just after the number of atoms
+ * @param input input string
+ * @param g the geometry, of the correct size
+ * @return \p TM_ERR_OK if everything went well, something else otherwise
  */
-tm_geometry *tm_xyz_loads(char *input) {
-    tm_parf_token tk;
-
-    // bootstrap
-    tm_lexer_token_init(&tk, input);
-    tm_lexer_skip(&tk, input, TM_TK_WHITESPACE);
+static int xyz_parse_frame_content(tm_parf_token* tk, char* input, tm_geometry* g) {
+    assert(tk != NULL && input != NULL && g != NULL);
 
-    // read number of atoms
-    long N = 0;
-    if(tk.type != TM_TK_DIGIT) {
-        tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected digit to start XYZ file");
-        return NULL;
-    }
-
-    if(tm_xyz_parse_positive_int(&tk, input, &N) != TM_ERR_OK) {
-        return NULL;
-    }
-
-    tm_print_debug_msg(__FILE__, __LINE__, "XYZ should contain %d atoms", N);
-
-    // create geometry
-    tm_geometry * g = tm_geometry_new(N);
-    if(g == NULL) {
-        tm_print_error_code(__FILE__, __LINE__, TM_ERR_MALLOC);
-        return NULL;
-    }
-
-    tm_lexer_skip(&tk, input, TM_TK_WHITESPACE);
-    if(tm_lexer_eat(&tk, input, TM_TK_NL) != TM_ERR_OK) {
-        tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected a single integer on first line");
-        tm_geometry_delete(g);
-        return NULL;
+    tm_lexer_skip(tk, input, TM_TK_WHITESPACE);
+    if(tm_lexer_eat(tk, input, TM_TK_NL) != TM_ERR_OK) {
+        tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected a single integer on first line");
+        return TM_ERR_XYZ;
     }
 
     // read title
-    int pos_start =  tk.position;
-    while (tk.type != TM_TK_NL && tk.type != TM_TK_EOS)
-        tm_lexer_advance(&tk, input, 1);
-
-    char* title = malloc((tk.position - pos_start + 1) * sizeof (char));
-    if(title == NULL) {
-        tm_print_error_code(__FILE__, __LINE__, TM_ERR_MALLOC);
-        tm_geometry_delete(g);
-        return NULL;
-    }
-
-    memcpy(title, input + pos_start, tk.position - pos_start);
-    title[tk.position - pos_start] = '\0';
+    int pos_start =  tk->position;
+    while (tk->type != TM_TK_NL && tk->type != TM_TK_EOS)
+        tm_lexer_advance(tk, input, 1);
 
-    tm_print_debug_msg(__FILE__, __LINE__, "Title of XYZ is `%s`", title);
-    free(title);
+    TM_DEBUG("Title of XYZ is `%.*s`", tk->position - pos_start, input + pos_start);
 
-    if(tm_lexer_eat(&tk, input, TM_TK_NL) != TM_ERR_OK) {
-        tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected coordinates");
-        tm_geometry_delete(g);
-        return NULL;
+    if(tm_lexer_eat(tk, input, TM_TK_NL) != TM_ERR_OK) {
+        tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected coordinates");
+        return TM_ERR_XYZ;
     }
 
     // read coordinates
     int atom_i = 0;
-    int type_i;
+    int atom_type_len;
     char* atom_type;
     double x, y, z;
-    int r;
+    int r = TM_ERR_OK;
 
-    while(atom_i < N && tk.type != TM_TK_EOS) {
+    while(atom_i < g->N && tk->type != TM_TK_EOS) {
         // read atom type
-        tm_lexer_skip(&tk, input, TM_TK_WHITESPACE);
-        if(tk.type != TM_TK_ALPHA) {
-            tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected atom type to start with ALPHA");
+        tm_lexer_skip(tk, input, TM_TK_WHITESPACE);
+        if(tk->type != TM_TK_ALPHA) {
+            tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected atom type to start with ALPHA");
             r = TM_ERR_XYZ;
             break;
         }
 
-        r = tm_xyz_parse_atom_type(&tk, input, &atom_type);
+        r = tm_xyz_parse_atom_type(tk, input, &atom_type, &atom_type_len);
         if(r != TM_ERR_OK)
             break;
 
-        tm_print_debug_msg(__FILE__, __LINE__, "Read atom %s on line %d", atom_type, tk.line);
+        TM_DEBUG("Read atom %.*s on line %d", atom_type_len, atom_type, tk->line);
 
         // find integer representation
-        type_i = 0;
-        while(type_i < N) {
-            if(g->type_vals[type_i] == NULL) {
-                g->type_vals[type_i] = atom_type;
-                g->types[atom_i] = type_i;
-                break;
-            }
-            else if(strcmp(atom_type, g->type_vals[type_i]) == 0) {
-                g->types[atom_i] = type_i;
-                free(atom_type); // no need for that anymore
-                break;
-            }
-            type_i++;
+        r = tm_geometry_type_intern(g, atom_type, atom_type_len, &(g->types[atom_i]));
+        if(r != TM_ERR_OK) {
+            tm_print_error_code(__FILE__, __LINE__, r);
+            break;
         }
 
         // coordinate X
-        if(tk.type != TM_TK_WHITESPACE) {
-            tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected at least one WHITESPACE between atom type and coordinate");
+        if(tk->type != TM_TK_WHITESPACE) {
+            tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected at least one WHITESPACE between atom type and coordinate");
             r = TM_ERR_XYZ;
             break;
         }
 
-        tm_lexer_skip(&tk, input, TM_TK_WHITESPACE);
-        if(tk.type != TM_TK_DIGIT && tk.type != TM_TK_DASH && tk.type != TM_TK_PLUS && tk.type != TM_TK_DOT) {
-            tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected coordinate");
+        tm_lexer_skip(tk, input, TM_TK_WHITESPACE);
+        if(tk->type != TM_TK_DIGIT && tk->type != TM_TK_DASH && tk->type != TM_TK_PLUS && tk->type != TM_TK_DOT) {
+            tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected coordinate");
             r = TM_ERR_XYZ;
             break;
         }
 
-        r = tm_xyz_parse_real(&tk, input, &x);
+        r = tm_xyz_parse_real(tk, input, &x);
         if(r != TM_ERR_OK)
             break;
 
         // coordinate Y
-        if(tk.type != TM_TK_WHITESPACE) {
-            tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected at least one WHITESPACE between two coordinates");
+        if(tk->type != TM_TK_WHITESPACE) {
+            tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected at least one WHITESPACE between two coordinates");
             r = TM_ERR_XYZ;
             break;
         }
 
-        tm_lexer_skip(&tk, input, TM_TK_WHITESPACE);
-        if(tk.type != TM_TK_DIGIT && tk.type != TM_TK_DASH && tk.type != TM_TK_PLUS && tk.type != TM_TK_DOT) {
-            tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected coordinate");
+        tm_lexer_skip(tk, input, TM_TK_WHITESPACE);
+        if(tk->type != TM_TK_DIGIT && tk->type != TM_TK_DASH && tk->type != TM_TK_PLUS && tk->type != TM_TK_DOT) {
+            tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected coordinate");
             r = TM_ERR_XYZ;
             break;
         }
-        r = tm_xyz_parse_real(&tk, input, &y);
+        r = tm_xyz_parse_real(tk, input, &y);
         if(r != TM_ERR_OK)
             break;
 
         // coordinate Z
-        if(tk.type != TM_TK_WHITESPACE) {
-            tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected at least one WHITESPACE between two coordinates");
+        if(tk->type != TM_TK_WHITESPACE) {
+            tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected at least one WHITESPACE between two coordinates");
             r = TM_ERR_XYZ;
             break;
         }
 
-        tm_lexer_skip(&tk, input, TM_TK_WHITESPACE);
-        if(tk.type != TM_TK_DIGIT && tk.type != TM_TK_DASH && tk.type != TM_TK_PLUS && tk.type != TM_TK_DOT) {
-            tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "expected coordinate");
+        tm_lexer_skip(tk, input, TM_TK_WHITESPACE);
+        if(tk->type != TM_TK_DIGIT && tk->type != TM_TK_DASH && tk->type != TM_TK_PLUS && tk->type != TM_TK_DOT) {
+            tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected coordinate");
             r = TM_ERR_XYZ;
             break;
         }
 
-        r = tm_xyz_parse_real(&tk, input, &z);
+        r = tm_xyz_parse_real(tk, input, &z);
         if(r != TM_ERR_OK)
             break;
 
-        g->positions[0 * g->N + atom_i] = x;
-        g->positions[1 * g->N + atom_i] = y;
-        g->positions[2 * g->N + atom_i] = z;
+        g->positions[0 * g->stride + atom_i] = x;
+        g->positions[1 * g->stride + atom_i] = y;
+        g->positions[2 * g->stride + atom_i] = z;
 
         atom_i++;
-        tm_lexer_skip(&tk, input, TM_TK_WHITESPACE);
+        tm_lexer_skip(tk, input, TM_TK_WHITESPACE);
 
-        if(atom_i < N) {
-            if(tm_lexer_eat(&tk, input, TM_TK_NL) != TM_ERR_OK) {
-                tm_print_error_msg_with_token(__FILE__, __LINE__, &tk, "XYZ is shorter than expected");
+        if(atom_i < g->N) {
+            if(tm_lexer_eat(tk, input, TM_TK_NL) != TM_ERR_OK) {
+                tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "XYZ is shorter than expected");
                 r = TM_ERR_XYZ;
                 break;
             }
         }
     }
 
-    if (r != TM_ERR_OK) {
-        tm_geometry_delete(g);
-        return NULL;
+    if(r == TM_ERR_OK && atom_i < g->N) {
+        tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "XYZ is shorter than expected");
+        r = TM_ERR_XYZ;
+    }
+
+    return r;
+}
+
+/**
+ * Parse one frame of a XYZ file (without checking what comes after):
+ * \code
+ * FRAME := WHITESPACE* INT WHITESPACE* NL TITLE NL (ATOM_TYPE REAL REAL REAL NL)*
+ * \endcode
+ * If \p *g is not \p NULL, the geometry is reused (and resized if needed), so that the types which were
+ * already interned keep their id. Otherwise, a new geometry is created.
+ * @pre \code{.c}
+ * tk != NULL && input != NULL && g != NULL
+ * \endcode
+ * @param tk valid token
+ * @param input input string
+ * @param g (input/output) the geometry
+ * @post \p *g contains the frame, and \p tk is at the end of the last coordinate line.
+ * @return \p TM_ERR_OK if the frame was read, something else otherwise.
+ * In the later case, a geometry which was created by this function is deleted.
+ */
+int tm_xyz_parse_frame(tm_parf_token* tk, char* input, tm_geometry** g) {
+    assert(tk != NULL && input != NULL && g != NULL);
+
+    tm_lexer_skip(tk, input, TM_TK_WHITESPACE);
+
+    // read number of atoms
+    long N = 0;
+    if(tk->type != TM_TK_DIGIT) {
+        tm_print_error_msg_with_token(__FILE__, __LINE__, tk, "expected digit to start XYZ file");
+        return TM_ERR_XYZ;
     }
 
+    int r = tm_xyz_parse_positive_int(tk, input, &N);
+    if(r != TM_ERR_OK)
+        return r;
+
+    TM_DEBUG("XYZ should contain %d atoms", N);
+
+    // create (or reuse) geometry
+    tm_geometry* created = NULL;
+    if(*g == NULL) {
+        created = tm_geometry_new(N);
+        if(created == NULL) {
+            tm_print_error_code(__FILE__, __LINE__, TM_ERR_MALLOC);
+            return TM_ERR_MALLOC;
+        }
+
+        *g = created;
+    } else if((*g)->N != N) {
+        r = tm_geometry_resize(*g, N);
+        if(r != TM_ERR_OK) {
+            tm_print_error_code(__FILE__, __LINE__, r);
+            return r;
+        }
+    }
+
+    r = xyz_parse_frame_content(tk, input, *g);
+
+    if(r != TM_ERR_OK && created != NULL) {
+        tm_geometry_delete(created);
+        *g = NULL;
+    }
+
+    return r;
+}
+
+/**
+ * Parse a string which represent a valid XYZ file
+ * @pre \code{.c}
+ * input != NULL
+ * \endcode
+ * @param input the input
+ * @return \p NULL if there was an error, the geometry otherwise
+ */
+tm_geometry *tm_xyz_loads(char *input) {
+    tm_parf_token tk;
+    tm_geometry* g = NULL;
+
+    // bootstrap
+    tm_lexer_token_init(&tk, input);
+
+    if(tm_xyz_parse_frame(&tk, input, &g) != TM_ERR_OK)
+        return NULL;
+
     // too long?
     tm_lexer_skip_whitespace_and_nl(&tk, input);
 
@@ -310,3 +349,206 @@ tm_geometry *tm_xyz_loads(char *input) {
 
     return g;
 }
+
+/* reader */
+
+/**
+ * Create a reader for the (multi-frame) XYZ file \p f.
+ * @pre \code{.c}
+ * f != NULL
+ * \endcode
+ * @param f a file open in read mode, positioned at the beginning of a frame. It is not closed by the reader.
+ * @param use_index if 1, the offset of each frame is recorded while reading, so that \p tm_xyz_reader_seek() can
+ * go back to any frame that was already read.
+ * @return the reader, or \p NULL if malloc failed
+ */
+tm_xyz_reader* tm_xyz_reader_new(FILE* f, int use_index) {
+    assert(f != NULL);
+
+    tm_xyz_reader* reader = tm_malloc(sizeof(tm_xyz_reader), TM_MEM_IO);
+    if(reader == NULL)
+        return NULL;
+
+    reader->f = f;
+    reader->geometry = NULL;
+    reader->buffer = NULL;
+    reader->buffer_size = 0;
+    reader->frame = 0;
+    reader->use_index = use_index;
+    reader->offsets = NULL;
+    reader->N_offsets = 0;
+    reader->offsets_size = 0;
+
+    return reader;
+}
+
+/**
+ * Record the position of the frame that is about to be read, if it was not yet.
+ * @param reader the reader
+ * @return \p TM_ERR_OK, or \p TM_ERR_MALLOC if the memory could not be allocated
+ */
+static int xyz_reader_record_offset(tm_xyz_reader* reader) {
+    if(!reader->use_index || reader->frame != reader->N_offsets)
+        return TM_ERR_OK;
+
+    if(reader->N_offsets == reader->offsets_size) {
+        long new_size = reader->offsets_size == 0 ? 64 : 2 * reader->offsets_size;
+        long* new_offsets = tm_realloc(reader->offsets, new_size * sizeof(long), TM_MEM_IO);
+        if(new_offsets == NULL)
+            return TM_ERR_MALLOC;
+
+        reader->offsets = new_offsets;
+        reader->offsets_size = new_size;
+    }
+
+    reader->offsets[reader->N_offsets] = ftell(reader->f);
+    reader->N_offsets++;
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Read the text of the next frame in \p reader->buffer (without parsing the coordinates).
+ * Empty lines before the frame are skipped.
+ * @param reader the reader
+ * @post \p reader->buffer contains the frame, \p reader->frame is incremented.
+ * @return \p TM_ERR_OK if a frame was read, \p TM_ERR_NOT_FOUND if the end of file was reached,
+ * something else otherwise.
+ */
+static int xyz_reader_read_frame(tm_xyz_reader* reader) {
+    size_t length;
+    long N;
+    char* end;
+    int r;
+
+    // first line (number of atoms)
+    do {
+        r = xyz_reader_record_offset(reader);
+        if(r != TM_ERR_OK)
+            return r;
+
+        length = 0;
+        r = tm_read_line(reader->f, &(reader->buffer), &(reader->buffer_size), &length);
+        if(r != TM_ERR_OK) {
+            if(reader->use_index && reader->N_offsets > reader->frame) // there is no such frame
+                reader->N_offsets = reader->frame;
+
+            return r;
+        }
+
+        N = strtol(reader->buffer, &end, 10);
+    } while(end == reader->buffer && strspn(reader->buffer, " \t\r\n") == length);
+
+    if(end == reader->buffer || N < 0) {
+        TM_ERROR("expected the number of atoms to start frame %ld", reader->frame);
+        return TM_ERR_XYZ;
+    }
+
+    // title and coordinates
+    for(long i = 0; i < N + 1; i++) {
+        r = tm_read_line(reader->f, &(reader->buffer), &(reader->buffer_size), &length);
+        if(r == TM_ERR_NOT_FOUND) {
+            TM_ERROR("frame %ld is shorter than expected", reader->frame);
+            return TM_ERR_XYZ;
+        } else if(r != TM_ERR_OK)
+            return r;
+    }
+
+    reader->frame++;
+    return TM_ERR_OK;
+}
+
+/**
+ * Read the next frame.
+ * @pre \code{.c}
+ * reader != NULL && g != NULL
+ * \endcode
+ * @param reader the reader
+ * @param g (output) the geometry of the frame. It belongs to the reader, and is overwritten by the next frame.
+ * @post \p g is set
+ * @return \p TM_ERR_OK if a frame was read, \p TM_ERR_NOT_FOUND if there is no more frame,
+ * something else otherwise.
+ */
+int tm_xyz_reader_next(tm_xyz_reader* reader, tm_geometry** g) {
+    assert(reader != NULL && g != NULL);
+
+    int r = xyz_reader_read_frame(reader);
+    if(r != TM_ERR_OK)
+        return r;
+
+    tm_parf_token tk;
+    tm_lexer_token_init(&tk, reader->buffer);
+
+    r = tm_xyz_parse_frame(&tk, reader->buffer, &(reader->geometry));
+    if(r != TM_ERR_OK)
+        return r;
+
+    *g = reader->geometry;
+    return TM_ERR_OK;
+}
+
+/**
+ * Go to frame \p frame, so that it is the one returned by the next call to \p tm_xyz_reader_next().
+ * Frames that were already indexed are reached directly, others are skipped (without being parsed).
+ * @pre \code{.c}
+ * reader != NULL && frame >= 0
+ * && (reader->use_index || frame >= reader->frame)
+ * \endcode
+ * @param reader the reader
+ * @param frame the index of the frame (zero-based)
+ * @return \p TM_ERR_OK, \p TM_ERR_NOT_FOUND if there is less than \p frame frames in the file,
+ * something else otherwise. Note that seeking just after the last frame is valid (then, the next call to
+ * \p tm_xyz_reader_next() returns \p TM_ERR_NOT_FOUND).
+ */
+int tm_xyz_reader_seek(tm_xyz_reader* reader, long frame) {
+    assert(reader != NULL && frame >= 0);
+    assert(reader->use_index || frame >= reader->frame);
+
+    int r;
+
+    if(frame < reader->N_offsets) {
+        if(fseek(reader->f, reader->offsets[frame], SEEK_SET) != 0)
+            return TM_ERR_READ;
+
+        reader->frame = frame;
+        return TM_ERR_OK;
+    }
+
+    // go as far as possible, then skip
+    if(reader->N_offsets > reader->frame) {
+        if(fseek(reader->f, reader->offsets[reader->N_offsets - 1], SEEK_SET) != 0)
+            return TM_ERR_READ;
+
+        reader->frame = reader->N_offsets - 1;
+    }
+
+    while(reader->frame < frame) {
+        r = xyz_reader_read_frame(reader);
+        if(r != TM_ERR_OK)
+            return r;
+    }
+
+    return TM_ERR_OK;
+}
+
+/**
+ * Delete \p reader (but do not close the file).
+ * @pre \code{.c} reader != NULL \endcode
+ * @param reader the reader
+ * @return \p TM_ERR_OK
+ */
+int tm_xyz_reader_delete(tm_xyz_reader* reader) {
+    assert(reader != NULL);
+
+    if(reader->geometry != NULL)
+        tm_geometry_delete(reader->geometry);
+
+    if(reader->buffer != NULL)
+        tm_free(reader->buffer);
+
+    if(reader->offsets != NULL)
+        tm_free(reader->offsets);
+
+    tm_free(reader);
+    return TM_ERR_OK;
+}
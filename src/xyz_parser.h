@@ -5,6 +5,42 @@
 #include "errors.h"
 #include "geometry.h"
 
+#include <stdio.h>
+
 tm_geometry* tm_xyz_loads(char* input);
 
+/**
+ * @brief Read the frames of a (multi-frame) XYZ file one at a time.
+ * Fields are \code{.c}
+ * FILE* f; // the file (not owned by the reader)
+ * tm_geometry* geometry; // geometry of the current frame, reused between frames
+ * char* buffer; // text of the current frame
+ * size_t buffer_size; // allocated size of the buffer
+ * long frame; // index of the next frame to be read
+ * int use_index; // if 1, record the offset of each frame on the first pass
+ * long* offsets; // offset of each frame in the file, as array of size N_offsets
+ * long N_offsets; // number of frames indexed so far
+ * long offsets_size; // allocated size of offsets
+ * \endcode
+ */
+typedef struct tm_xyz_reader_ {
+    FILE* f;
+    tm_geometry* geometry;
+
+    char* buffer;
+    size_t buffer_size;
+
+    long frame;
+
+    int use_index;
+    long* offsets;
+    long N_offsets;
+    long offsets_size;
+} tm_xyz_reader;
+
+tm_xyz_reader* tm_xyz_reader_new(FILE* f, int use_index);
+int tm_xyz_reader_next(tm_xyz_reader* reader, tm_geometry** g);
+int tm_xyz_reader_seek(tm_xyz_reader* reader, long frame);
+int tm_xyz_reader_delete(tm_xyz_reader* reader);
+
 #endif //TOYMC_XYZ_PARSER_H
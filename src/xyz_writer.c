@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "xyz_writer.h"
+#include "memory.h"
+
+// above that, `value * 1e5` does not fit in the mantissa anymore, so `printf()` is used instead
+#define FAST_LIMIT 4e10
+
+/**
+ * Format a real exactly as \p printf("%9.5f") does (with the default rounding mode), but without parsing a format.
+ * The value is rounded to 5 decimals with integer arithmetic: the rounding error of \p value*1e5 is recovered
+ * with \p fma(), so that halfway cases are detected exactly (and rounded to even).
+ * @pre \code{.c}
+ * out != NULL
+ * \endcode
+ * @param value the value
+ * @param out (output) buffer, with room for at least \p TM_XYZ_REAL_MAX_LENGTH characters
+ * @post \p out contains the NUL-terminated representation of \p value.
+ * @return the length of the representation
+ */
+int tm_xyz_format_real(double value, char* out) {
+    assert(out != NULL);
+
+    double a = fabs(value);
+    if(!(a < FAST_LIMIT)) // also catches NaN
+        return snprintf(out, TM_XYZ_REAL_MAX_LENGTH, "%9.5f", value);
+
+    // round a * 1e5 to nearest, ties to even
+    double p = a * 1e5, err = fma(a, 1e5, -p);
+    uint64_t n = (uint64_t) p;
+    double d = (p - (double) n) - .5; // exact (or clearly negative), and larger than err if not 0
+
+    if(d > 0 || (d == 0 && (err > 0 || (err == 0 && (n & 1)))))
+        n++;
+
+    // digits of the integer part, reversed
+    char digits[16];
+    int N_digits = 0;
+    uint64_t integer = n / 100000;
+    uint32_t decimals = (uint32_t) (n % 100000);
+
+    do {
+        digits[N_digits++] = (char) ('0' + integer % 10);
+        integer /= 10;
+    } while(integer > 0);
+
+    int negative = signbit(value) != 0;
+    int length = negative + N_digits + 6, pos = 0;
+
+    for(; pos < 9 - length; pos++)
+        out[pos] = ' ';
+
+    if(negative)
+        out[pos++] = '-';
+
+    while(N_digits > 0)
+        out[pos++] = digits[--N_digits];
+
+    out[pos++] = '.';
+    for(int i=4; i >= 0; i--) {
+        out[pos + i] = (char) ('0' + decimals % 10);
+        decimals /= 10;
+    }
+
+    pos += 5;
+    out[pos] = '\0';
+
+    return pos;
+}
+
+/* A range of atoms, formatted in its own buffer (possibly by another thread).
+ */
+typedef struct xyz_chunk_ {
+    tm_geometry* geometry;
+    size_t* type_lengths;
+    size_t max_line_length;
+
+    long start, end;
+
+    char* buffer;
+    size_t size, length;
+    int error;
+} xyz_chunk;
+
+static void* xyz_format_chunk(void* data) {
+    xyz_chunk* chunk = data;
+    tm_geometry* g = chunk->geometry;
+
+    chunk->length = 0;
+    chunk->error = TM_ERR_OK;
+
+    for(long i=chunk->start; i < chunk->end; i++) {
+        // make room for the worst case
+        if(chunk->size - chunk->length < chunk->max_line_length) {
+            size_t new_size = 2 * chunk->size + chunk->max_line_length;
+            char* new_buffer = tm_realloc(chunk->buffer, new_size, TM_MEM_IO);
+            if(new_buffer == NULL) {
+                chunk->error = TM_ERR_MALLOC;
+                return NULL;
+            }
+
+            chunk->buffer = new_buffer;
+            chunk->size = new_size;
+        }
+
+        char* out = chunk->buffer + chunk->length;
+        size_t pos = chunk->type_lengths[g->types[i]];
+
+        memcpy(out, g->type_vals[g->types[i]], pos);
+        for(int k=0; k < 3; k++) {
+            out[pos++] = ' ';
+            pos += tm_xyz_format_real(g->positions[k * g->stride + i], out + pos);
+        }
+
+        out[pos++] = '\n';
+        chunk->length += pos;
+    }
+
+    return NULL;
+}
+
+/**
+ * Write \p geometry as a XYZ frame, with positions formatted as \p "%9.5f".
+ * Lines are formatted in memory, possibly by several threads (each of them taking a contiguous range of atoms),
+ * then written in order.
+ * @pre \code{.c}
+ * f != NULL && geometry != NULL && title != NULL
+ * && strchr(title, '\n') == NULL
+ * \endcode
+ * @param f an open file
+ * @param geometry the geometry (the type of each atom is written as its value in \p geometry->type_vals)
+ * @param title title of the frame
+ * @param n_threads maximum number of threads (there is at least \p TM_XYZ_MIN_ATOMS_PER_THREAD atoms per thread)
+ * @return \p TM_ERR_OK if everything went well, \p TM_ERR_WRITE if the file could not be written,
+ * something else otherwise.
+ */
+int tm_xyz_write(FILE* f, tm_geometry* geometry, char* title, int n_threads) {
+    assert(f != NULL && geometry != NULL && title != NULL);
+    assert(strchr(title, '\n') == NULL);
+
+    long N = geometry->N;
+
+    if(n_threads > N / TM_XYZ_MIN_ATOMS_PER_THREAD)
+        n_threads = (int) (N / TM_XYZ_MIN_ATOMS_PER_THREAD);
+    if(n_threads < 1)
+        n_threads = 1;
+
+    size_t type_lengths[TM_GEOMETRY_MAX_TYPES], max_type_length = 0;
+    for(int t=0; t < geometry->N_types; t++) {
+        type_lengths[t] = strlen(geometry->type_vals[t]);
+        if(type_lengths[t] > max_type_length)
+            max_type_length = type_lengths[t];
+    }
+
+    xyz_chunk* chunks = tm_malloc(n_threads * sizeof(xyz_chunk), TM_MEM_IO);
+    pthread_t* threads = tm_malloc(n_threads * sizeof(pthread_t), TM_MEM_IO);
+    int* started = tm_calloc(n_threads, sizeof(int), TM_MEM_IO);
+    if(chunks == NULL || threads == NULL || started == NULL) {
+        tm_free(chunks);
+        tm_free(threads);
+        tm_free(started);
+        return TM_ERR_MALLOC;
+    }
+
+    for(int t=0; t < n_threads; t++) {
+        chunks[t].geometry = geometry;
+        chunks[t].type_lengths = type_lengths;
+        chunks[t].max_line_length = max_type_length + 3 * TM_XYZ_REAL_MAX_LENGTH + 1;
+        chunks[t].start = N * t / n_threads;
+        chunks[t].end = N * (t + 1) / n_threads;
+
+        // usual lines are much shorter than the worst case
+        chunks[t].size = (size_t) (chunks[t].end - chunks[t].start) * (max_type_length + 32) + chunks[t].max_line_length;
+        chunks[t].buffer = tm_malloc(chunks[t].size, TM_MEM_IO);
+        chunks[t].length = 0;
+        chunks[t].error = chunks[t].buffer == NULL ? TM_ERR_MALLOC : TM_ERR_OK;
+    }
+
+    // format (the first chunk, and any chunk for which a thread could not be created, are done here)
+    for(int t=1; t < n_threads; t++) {
+        if(chunks[t].error == TM_ERR_OK)
+            started[t] = pthread_create(&threads[t], NULL, xyz_format_chunk, &chunks[t]) == 0;
+    }
+
+    for(int t=0; t < n_threads; t++) {
+        if(started[t])
+            pthread_join(threads[t], NULL);
+        else if(chunks[t].error == TM_ERR_OK)
+            xyz_format_chunk(&chunks[t]);
+    }
+
+    // write
+    int error = TM_ERR_OK;
+    for(int t=0; t < n_threads && error == TM_ERR_OK; t++)
+        error = chunks[t].error;
+
+    if(error == TM_ERR_OK && fprintf(f, "%ld\n%s\n", N, title) < 0)
+        error = TM_ERR_WRITE;
+
+    for(int t=0; t < n_threads && error == TM_ERR_OK; t++) {
+        if(fwrite(chunks[t].buffer, 1, chunks[t].length, f) != chunks[t].length)
+            error = TM_ERR_WRITE;
+    }
+
+    for(int t=0; t < n_threads; t++) {
+        if(chunks[t].buffer != NULL)
+            tm_free(chunks[t].buffer);
+    }
+
+    tm_free(chunks);
+    tm_free(threads);
+    tm_free(started);
+
+    return error;
+}
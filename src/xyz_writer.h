@@ -0,0 +1,18 @@
+#ifndef TOYMC_XYZ_WRITER_H
+#define TOYMC_XYZ_WRITER_H
+
+#include "errors.h"
+#include "geometry.h"
+
+#include <stdio.h>
+
+// room needed to format any real (e.g., `DBL_MAX` has 309 digits), including the final NUL
+#define TM_XYZ_REAL_MAX_LENGTH 320
+
+// frames with fewer atoms per thread are not worth splitting
+#define TM_XYZ_MIN_ATOMS_PER_THREAD 4096
+
+int tm_xyz_format_real(double value, char* out);
+int tm_xyz_write(FILE* f, tm_geometry* geometry, char* title, int n_threads);
+
+#endif //TOYMC_XYZ_WRITER_H
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "../tests.h"
+
+tm_arena* arena;
+
+void setup_arena() {
+    arena = tm_arena_new(64);
+}
+
+void teardown_arena() {
+    _OK(tm_arena_delete(arena));
+}
+
+START_TEST(test_arena_alloc) {
+    char* prev = NULL, *ptr;
+
+    for(int i=0; i < 1000; i++) {
+        ptr = tm_arena_alloc(arena, 1 + i % 7);
+        ck_assert_ptr_nonnull(ptr);
+        ck_assert_uint_eq(((uintptr_t) ptr) % TM_ARENA_ALIGN, 0);
+        ck_assert_ptr_ne(ptr, prev);
+
+        *ptr = 'x'; // writable
+        prev = ptr;
+    }
+
+    // chunks grow
+    ck_assert_uint_gt(arena->chunk_size, 64);
+}
+END_TEST
+
+START_TEST(test_arena_large) {
+    char* small = tm_arena_alloc(arena, 8);
+    ck_assert_ptr_nonnull(small);
+    tm_arena_chunk* current = arena->current;
+
+    // large allocation gets its own chunk, but current chunk is kept
+    char* large = tm_arena_alloc(arena, 4 * TM_ARENA_MAX_CHUNK_SIZE);
+    ck_assert_ptr_nonnull(large);
+    large[4 * TM_ARENA_MAX_CHUNK_SIZE - 1] = 'x';
+    ck_assert_ptr_eq(arena->current, current);
+
+    char* small2 = tm_arena_alloc(arena, 8);
+    ck_assert_ptr_eq(small2, small + TM_ARENA_ALIGN);
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: arena");
+
+    // alloc
+    TCase* tc_alloc = tcase_create("alloc");
+    tcase_add_checked_fixture(tc_alloc, setup_arena, teardown_arena);
+    tcase_add_test(tc_alloc, test_arena_alloc);
+    tcase_add_test(tc_alloc, test_arena_large);
+
+    suite_add_tcase(s, tc_alloc);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "geometry.h"
+#include "memory.h"
+#include "../tests.h"
+
+tm_geometry* geometry;
+
+void setup_geometry() {
+    geometry = tm_geometry_new(4);
+}
+
+void teardown_geometry() {
+    _OK(tm_geometry_delete(geometry));
+}
+
+START_TEST(test_geometry_type_intern) {
+    tm_type_id id, id2;
+
+    ck_assert_int_eq(geometry->N_types, 0);
+    _NOK(tm_geometry_type_find(geometry, "He", 2, &id));
+
+    // new type
+    _OK(tm_geometry_type_intern(geometry, "He", 2, &id));
+    ck_assert_int_eq(id, 0);
+    ck_assert_int_eq(geometry->N_types, 1);
+    ck_assert_str_eq(geometry->type_vals[0], "He");
+
+    // non NUL-terminated
+    _OK(tm_geometry_type_intern(geometry, "Ar 1. 2. 3.", 2, &id));
+    ck_assert_int_eq(id, 1);
+    ck_assert_str_eq(geometry->type_vals[1], "Ar");
+
+    // existing types
+    _OK(tm_geometry_type_intern(geometry, "He", 2, &id2));
+    ck_assert_int_eq(id2, 0);
+    _OK(tm_geometry_type_find(geometry, "Ar", 2, &id2));
+    ck_assert_int_eq(id2, 1);
+
+    // prefix is not the same type
+    _NOK(tm_geometry_type_find(geometry, "H", 1, &id2));
+    ck_assert_int_eq(geometry->N_types, 2);
+}
+END_TEST
+
+START_TEST(test_geometry_type_many) {
+    char name[8];
+    tm_type_id id;
+
+    // fill (which requires to grow the hash table several times)
+    for(int i=0; i < TM_GEOMETRY_MAX_TYPES; i++) {
+        sprintf(name, "X%d", i);
+        _OK(tm_geometry_type_intern(geometry, name, strlen(name), &id));
+        ck_assert_int_eq(id, i);
+    }
+
+    ck_assert_int_eq(geometry->N_types, TM_GEOMETRY_MAX_TYPES);
+
+    // ids are kept
+    for(int i=0; i < TM_GEOMETRY_MAX_TYPES; i++) {
+        sprintf(name, "X%d", i);
+        _OK(tm_geometry_type_find(geometry, name, strlen(name), &id));
+        ck_assert_int_eq(id, i);
+        ck_assert_str_eq(geometry->type_vals[id], name);
+    }
+
+    // no more room
+    _NOK(tm_geometry_type_intern(geometry, "Y", 1, &id));
+}
+END_TEST
+
+START_TEST(test_geometry_get_atom) {
+    double p[3], *pp = p;
+    int type;
+
+    // rows are aligned and padded
+    ck_assert_int_eq(geometry->stride, TM_MEMORY_PADDED(4));
+    ck_assert_int_eq((uintptr_t) geometry->positions % TM_MEMORY_ALIGNMENT, 0);
+    ck_assert_int_eq((uintptr_t) (geometry->positions + geometry->stride) % TM_MEMORY_ALIGNMENT, 0);
+
+    for(int k=0; k < 3; k++) {
+        for(int i=0; i < 4; i++)
+            geometry->positions[k * geometry->stride + i] = 10 * k + i;
+    }
+
+    for(int i=0; i < 4; i++)
+        geometry->types[i] = (tm_type_id) i;
+
+    _OK(tm_geometry_get_atom(geometry, 2, &type, &pp));
+    ck_assert_int_eq(type, 2);
+    ck_assert_double_eq(p[0], 2.);
+    ck_assert_double_eq(p[1], 12.);
+    ck_assert_double_eq(p[2], 22.);
+
+    // larger
+    _OK(tm_geometry_resize(geometry, 40));
+    ck_assert_int_eq(geometry->stride, TM_MEMORY_PADDED(40));
+    ck_assert_int_eq((uintptr_t) geometry->positions % TM_MEMORY_ALIGNMENT, 0);
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: geometry");
+
+    // types
+    TCase* tc_types = tcase_create("types");
+    tcase_add_checked_fixture(tc_types, setup_geometry, teardown_geometry);
+    tcase_add_test(tc_types, test_geometry_type_intern);
+    tcase_add_test(tc_types, test_geometry_type_many);
+
+    suite_add_tcase(s, tc_types);
+
+    // positions
+    TCase* tc_positions = tcase_create("positions");
+    tcase_add_checked_fixture(tc_positions, setup_geometry, teardown_geometry);
+    tcase_add_test(tc_positions, test_geometry_get_atom);
+
+    suite_add_tcase(s, tc_positions);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
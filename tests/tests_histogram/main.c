@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "../tests.h"
+#include "histogram.h"
+
+START_TEST(test_histogram_small_values) {
+    tm_histogram* h = tm_histogram_new();
+    ck_assert_ptr_nonnull(h);
+
+    ck_assert_uint_eq(tm_histogram_percentile(h, 50), 0);
+
+    // small values are exact
+    for(uint64_t i=1; i <= 10; i++)
+        tm_histogram_record(h, i);
+
+    ck_assert_uint_eq(h->N, 10);
+    ck_assert_uint_eq(h->min, 1);
+    ck_assert_uint_eq(h->max, 10);
+    ck_assert_uint_eq(tm_histogram_percentile(h, 0), 1);
+    ck_assert_uint_eq(tm_histogram_percentile(h, 50), 5);
+    ck_assert_uint_eq(tm_histogram_percentile(h, 90), 9);
+    ck_assert_uint_eq(tm_histogram_percentile(h, 100), 10);
+
+    _OK(tm_histogram_delete(h));
+}
+END_TEST
+
+START_TEST(test_histogram_relative_error) {
+    tm_histogram* h = tm_histogram_new();
+    ck_assert_ptr_nonnull(h);
+
+    uint64_t n = 100000;
+    for(uint64_t i=1; i <= n; i++)
+        tm_histogram_record(h, i * 1000);
+
+    double percentiles[] = {50, 99, 99.9};
+    for(int i=0; i < 3; i++) {
+        double expected = percentiles[i] / 100 * n * 1000, found = (double) tm_histogram_percentile(h, percentiles[i]);
+        ck_assert_double_ge(found, expected);
+        ck_assert_double_le(found, expected * (1 + 1. / TM_HISTOGRAM_SUB));
+    }
+
+    // very large values do not overflow
+    tm_histogram_record(h, UINT64_MAX);
+    ck_assert_uint_eq(tm_histogram_percentile(h, 100), UINT64_MAX);
+
+    _OK(tm_histogram_delete(h));
+}
+END_TEST
+
+START_TEST(test_histogram_merge_reset) {
+    tm_histogram* h1 = tm_histogram_new();
+    ck_assert_ptr_nonnull(h1);
+
+    tm_histogram* h2 = tm_histogram_new();
+    ck_assert_ptr_nonnull(h2);
+
+    tm_histogram_record(h1, 5);
+    tm_histogram_record(h2, 1000);
+    tm_histogram_record(h2, 3);
+
+    _OK(tm_histogram_merge(h1, h2));
+    ck_assert_uint_eq(h1->N, 3);
+    ck_assert_uint_eq(h1->min, 3);
+    ck_assert_uint_eq(h1->max, 1000);
+    ck_assert_uint_eq(tm_histogram_percentile(h1, 50), 5);
+
+    _OK(tm_histogram_reset(h2));
+    ck_assert_uint_eq(h2->N, 0);
+    ck_assert_uint_eq(tm_histogram_percentile(h2, 99), 0);
+
+    _OK(tm_histogram_delete(h1));
+    _OK(tm_histogram_delete(h2));
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: histogram");
+
+    TCase* tc_histogram = tcase_create("histogram");
+    tcase_add_test(tc_histogram, test_histogram_small_values);
+    tcase_add_test(tc_histogram, test_histogram_relative_error);
+    tcase_add_test(tc_histogram, test_histogram_merge_reset);
+
+    suite_add_tcase(s, tc_histogram);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "../tests.h"
+
+#define N_THREADS 4
+#define N_MESSAGES 500
+
+static int evaluated = 0;
+
+static int side_effect() {
+    return ++evaluated;
+}
+
+START_TEST(test_log_arguments_not_evaluated) {
+    evaluated = 0;
+
+    tm_set_debug_level(0);
+    TM_DEBUG("value is %d", side_effect());
+    ck_assert_int_eq(evaluated, 0);
+
+#if TM_LOG_LEVEL >= TM_LOG_LEVEL_DEBUG
+    tm_set_debug_level(1);
+    TM_DEBUG("value is %d", side_effect());
+    ck_assert_int_eq(evaluated, 1);
+
+    tm_set_debug_level(0);
+#endif
+
+    tm_log_flush();
+}
+END_TEST
+
+static FILE* shared;
+
+static void write_message(char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    tm_log_vwrite(shared, 0, "DEBUG", "test", 1, NULL, format, args);
+    va_end(args);
+}
+
+static void* write_messages(void* arg) {
+    long id = (long) arg;
+
+    for(int i=0; i < N_MESSAGES; i++)
+        write_message("thread %ld says %d (and some more text to fill the buffer)", id, i);
+
+    tm_log_flush();
+    return NULL;
+}
+
+START_TEST(test_log_threads_do_not_interleave) {
+    pthread_t threads[N_THREADS];
+    char line[256];
+    int counts[N_THREADS] = {0};
+
+    shared = tmpfile();
+    ck_assert_ptr_nonnull(shared);
+
+    for(long i=0; i < N_THREADS; i++)
+        ck_assert_int_eq(pthread_create(&threads[i], NULL, write_messages, (void*) i), 0);
+
+    for(int i=0; i < N_THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    // each line is a complete message, and messages of a given thread are in order
+    rewind(shared);
+    while (fgets(line, 256, shared) != NULL) {
+        long id;
+        int n;
+        ck_assert_int_eq(sscanf(line, "DEBUG (test:1) :: thread %ld says %d (and some more text to fill the buffer)\n", &id, &n), 2);
+        ck_assert_int_lt(id, N_THREADS);
+        ck_assert_int_eq(n, counts[id]);
+        counts[id]++;
+    }
+
+    for(int i=0; i < N_THREADS; i++)
+        ck_assert_int_eq(counts[i], N_MESSAGES);
+
+    fclose(shared);
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: log");
+
+    TCase* tc_log = tcase_create("log");
+    tcase_add_test(tc_log, test_log_arguments_not_evaluated);
+    tcase_add_test(tc_log, test_log_threads_do_not_interleave);
+
+    suite_add_tcase(s, tc_log);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,619 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "../tests.h"
+#include "mc.h"
+#include "pcg32.h"
+
+START_TEST(test_mc_lattice) {
+    long N = 27;
+    double L = 3.;
+    double* positions = malloc(3 * N * sizeof(double));
+    ck_assert_ptr_nonnull(positions);
+
+    tm_mc_init_positions(positions, N, N, L);
+
+    // atom 13 is at the center
+    ck_assert_double_eq_tol(positions[0 * N + 13], 1., 1e-12);
+    ck_assert_double_eq_tol(positions[1 * N + 13], 1., 1e-12);
+    ck_assert_double_eq_tol(positions[2 * N + 13], 1., 1e-12);
+
+    // last one is in the corner
+    ck_assert_double_eq_tol(positions[0 * N + 26], 2., 1e-12);
+    ck_assert_double_eq_tol(positions[1 * N + 26], 2., 1e-12);
+    ck_assert_double_eq_tol(positions[2 * N + 26], 2., 1e-12);
+
+    free(positions);
+}
+END_TEST
+
+START_TEST(test_mc_energy_is_sum_of_Ui) {
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+
+    // the energy of the box counts each pair once
+    double Ui = 0, viri = 0;
+    for(long i=0; i < mc->N; i++)
+        tm_mc_compute_Ui(mc, i, &Ui, &viri);
+
+    ck_assert_double_eq_tol(Ui / 2, mc->U, 1e-8);
+    ck_assert_double_eq_tol(viri / 2, mc->vir, 1e-8);
+
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+START_TEST(test_mc_sweep_keeps_track_of_energy) {
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+
+    for(int i=0; i < 10; i++)
+        _OK(tm_mc_sweep(mc));
+
+    ck_assert_int_eq(mc->N_moves, 10 * mc->N);
+    ck_assert_int_gt(mc->N_accepted, 0);
+
+    // atoms are still in the box
+    for(int k=0; k < 3; k++) {
+        for(long i=0; i < mc->N; i++) {
+            ck_assert_double_ge(mc->positions[k * mc->stride + i], 0);
+            ck_assert_double_le(mc->positions[k * mc->stride + i], mc->L);
+        }
+    }
+
+    // the energy that was updated move after move is the one of the box
+    double U, vir;
+    tm_mc_compute_U(mc, &U, &vir);
+    ck_assert_double_eq_tol(U, mc->U, 1e-8);
+    ck_assert_double_eq_tol(vir, mc->vir, 1e-8);
+
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+START_TEST(test_mc_reproducible) {
+    double U1, U2;
+
+    pcg32_init(1024);
+    tm_mc* mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+    _OK(tm_mc_sweep(mc));
+    U1 = tm_mc_energy(mc);
+    _OK(tm_mc_delete(mc));
+
+    pcg32_init(1024);
+    mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+    _OK(tm_mc_sweep(mc));
+    U2 = tm_mc_energy(mc);
+    _OK(tm_mc_delete(mc));
+
+    ck_assert_double_eq(U1, U2);
+}
+END_TEST
+
+START_TEST(test_mc_pair_coefs) {
+    double epsilon[] = {1., 4.}, sigma[] = {1., 2.};
+
+    tm_pair_coefs* coefs = tm_pair_coefs_new(2, epsilon, sigma, 2.5, TM_MIXING_LORENTZ_BERTHELOT);
+    ck_assert_ptr_nonnull(coefs);
+
+    // LJ: {c12, c6}
+    double* params = coefs->params;
+    ck_assert_str_eq(coefs->potential->name, "lj");
+    ck_assert_double_eq_tol(params[0], 4., 1e-12);
+    ck_assert_double_eq_tol(params[1], 4., 1e-12);
+    ck_assert_double_eq_tol(coefs->rc2[0], 6.25, 1e-12);
+
+    // sigma = 1.5, epsilon = 2
+    params = coefs->params + TM_POTENTIAL_MAX_PARAMS;
+    ck_assert_double_eq_tol(coefs->sigma[1], 1.5, 1e-12);
+    ck_assert_double_eq_tol(coefs->epsilon[1], 2., 1e-12);
+    ck_assert_double_eq_tol(params[0], 8. * pow(1.5, 12), 1e-8);
+    ck_assert_double_eq_tol(params[1], 8. * pow(1.5, 6), 1e-8);
+    ck_assert_double_eq_tol(coefs->rc2[1], 6.25 * 2.25, 1e-12);
+    ck_assert_double_eq(params[0], coefs->params[2 * TM_POTENTIAL_MAX_PARAMS]);
+
+    ck_assert_double_eq_tol(coefs->params[3 * TM_POTENTIAL_MAX_PARAMS], 16. * pow(2., 12), 1e-8);
+
+    // WCA: cutoff at the minimum
+    tm_potential* potential;
+    _OK(tm_potential_find("wca", &potential));
+    tm_pair_coefs_use_potential(coefs, potential, 0);
+    ck_assert_double_eq_tol(coefs->rc2[1], cbrt(2.) * 2.25, 1e-12);
+    ck_assert_double_eq_tol(coefs->params[TM_POTENTIAL_MAX_PARAMS + 2], 2., 1e-12);
+    _OK(tm_pair_coefs_delete(coefs));
+
+    // sigma = sqrt(2)
+    coefs = tm_pair_coefs_new(2, epsilon, sigma, 2.5, TM_MIXING_GEOMETRIC);
+    ck_assert_ptr_nonnull(coefs);
+    ck_assert_double_eq_tol(coefs->params[TM_POTENTIAL_MAX_PARAMS + 1], 8. * 8., 1e-8);
+    _OK(tm_pair_coefs_delete(coefs));
+
+    tm_mixing_rule rule;
+    _OK(tm_mixing_rule_find("geometric", &rule));
+    ck_assert_int_eq(rule, TM_MIXING_GEOMETRIC);
+    ck_assert_int_eq(tm_mixing_rule_find("arithmetic", &rule), TM_ERR_NOT_FOUND);
+}
+END_TEST
+
+START_TEST(test_mc_mixture_of_identical_types) {
+    long composition[] = {20, 30, 14};
+    double epsilon[] = {1., 1., 1.}, sigma[] = {1., 1., 1.};
+
+    pcg32_init(42);
+    tm_mc* mc1 = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc1);
+
+    // same lattice, shuffled
+    for(int sort=0; sort < 2; sort++) {
+        tm_mc* mc2 = tm_mc_new_mixture(3, composition, epsilon, sigma, TM_MIXING_LORENTZ_BERTHELOT, .8, .9, 2., .3, sort);
+        ck_assert_ptr_nonnull(mc2);
+
+        ck_assert_int_eq(mc2->N, 64);
+        ck_assert_double_eq_tol(mc2->U, mc1->U, 1e-8);
+        ck_assert_double_eq_tol(mc2->vir, mc1->vir, 1e-8);
+        ck_assert_double_eq_tol(mc2->U_tail, mc1->U_tail, 1e-8);
+        ck_assert_double_eq_tol(mc2->P_tail, mc1->P_tail, 1e-8);
+
+        _OK(tm_mc_delete(mc2));
+    }
+
+    _OK(tm_mc_delete(mc1));
+}
+END_TEST
+
+START_TEST(test_mc_potentials) {
+    long composition[] = {40, 24};
+    double epsilon[] = {1., .5}, sigma[] = {1., 1.3};
+    char* names[] = {"lj", "wca", "sf-lj", "morse", "buckingham"};
+
+    for(int p=0; p < 5; p++) {
+        tm_potential* potential;
+        _OK(tm_potential_find(names[p], &potential));
+
+        for(int sort=0; sort < 2; sort++) {
+            pcg32_init(42);
+            tm_mc* mc = tm_mc_new_mixture(2, composition, epsilon, sigma, TM_MIXING_LORENTZ_BERTHELOT, .6, 1.5, 2.5, .3, sort);
+            ck_assert_ptr_nonnull(mc);
+
+            _OK(tm_mc_use_potential(mc, potential, 0));
+            ck_assert_ptr_eq(mc->coefs->potential, potential);
+            if(potential->tail == NULL) {
+                ck_assert_double_eq(mc->U_tail, 0);
+                ck_assert_double_eq(mc->P_tail, 0);
+            }
+
+            for(int i=0; i < 5; i++)
+                _OK(tm_mc_sweep(mc));
+
+            // the energy is the one that was updated move after move
+            double U, vir;
+            tm_mc_compute_U(mc, &U, &vir);
+            ck_assert_double_eq_tol(U, mc->U, 1e-8);
+            ck_assert_double_eq_tol(vir, mc->vir, 1e-8);
+
+            _OK(tm_mc_delete(mc));
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_mc_mixture_sorted) {
+    long composition[] = {40, 24};
+    double epsilon[] = {1., .5}, sigma[] = {1., 1.3};
+
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new_mixture(2, composition, epsilon, sigma, TM_MIXING_LORENTZ_BERTHELOT, .6, 1.5, 2.5, .3, 1);
+    ck_assert_ptr_nonnull(mc);
+
+    ck_assert_int_eq(mc->type_start[0], 0);
+    ck_assert_int_eq(mc->type_start[1], 40);
+    ck_assert_int_eq(mc->type_start[2], 64);
+    for(long i=0; i < mc->N; i++)
+        ck_assert_int_eq(mc->types[i], i < 40 ? 0 : 1);
+
+    for(int i=0; i < 10; i++)
+        _OK(tm_mc_sweep(mc));
+
+    // by blocks or not, the energy is the same, and is the one that was updated move after move
+    double U1, vir1, U2, vir2;
+    tm_mc_compute_U(mc, &U1, &vir1);
+
+    long* type_start = mc->type_start;
+    mc->type_start = NULL;
+    tm_mc_compute_U(mc, &U2, &vir2);
+    mc->type_start = type_start;
+
+    ck_assert_double_eq_tol(U1, U2, 1e-8);
+    ck_assert_double_eq_tol(vir1, vir2, 1e-8);
+    ck_assert_double_eq_tol(U1, mc->U, 1e-8);
+    ck_assert_double_eq_tol(vir1, mc->vir, 1e-8);
+
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+// sum of the distances between atoms that are next to each other in memory
+static double mc_path_length(tm_mc* mc) {
+    double length = 0;
+    for(long i=1; i < mc->N; i++) {
+        double r2 = 0;
+        for(int k=0; k < 3; k++) {
+            double dq = mc->positions[k * mc->stride + i] - mc->positions[k * mc->stride + i - 1];
+            r2 += dq * dq;
+        }
+
+        length += sqrt(r2);
+    }
+
+    return length;
+}
+
+START_TEST(test_mc_reorder) {
+    long composition[] = {80, 48};
+    double epsilon[] = {1., .5}, sigma[] = {1., 1.3};
+
+    for(int sort=0; sort < 2; sort++) {
+        pcg32_init(42);
+        tm_mc* mc = tm_mc_new_mixture(2, composition, epsilon, sigma, TM_MIXING_LORENTZ_BERTHELOT, .6, 1.5, 2.5, .3, sort);
+        ck_assert_ptr_nonnull(mc);
+        _OK(tm_mc_use_fixed_point(mc, 1));
+
+        for(int i=0; i < 5; i++)
+            _OK(tm_mc_sweep(mc));
+
+        long N = mc->N, S = mc->stride;
+        double* positions = malloc(3 * N * sizeof(double));
+        tm_type_id* types = malloc(N * sizeof(tm_type_id));
+        ck_assert_ptr_nonnull(positions);
+        ck_assert_ptr_nonnull(types);
+
+        for(long i=0; i < N; i++) {
+            for(int k=0; k < 3; k++)
+                positions[k * N + mc->order[i]] = mc->positions[k * S + i];
+
+            types[mc->order[i]] = mc->types[i];
+        }
+
+        tm_mc_check_energy(mc);
+        double U = mc->U, length = mc_path_length(mc);
+        _OK(tm_mc_reorder(mc));
+
+        // the energy is not changed ...
+        ck_assert_double_lt(fabs(mc->U - U), 1e-8);
+
+        // ... atoms that follow each other in memory are neighbors (at most twice the spacing of the lattice, on
+        // average: in a random order, it would be more than three times), and closer than before if they were
+        // shuffled over the lattice (when sorted by type) ...
+        ck_assert_double_lt(mc_path_length(mc) / (double) (N - 1), 2 * cbrt(mc->V / (double) N));
+        if(sort)
+            ck_assert_double_lt(mc_path_length(mc), length * 2 / 3);
+
+        // ... but are the same, and are found through the permutation
+        for(long i=0; i < N; i++) {
+            ck_assert_int_eq(types[mc->order[i]], mc->types[i]);
+            for(int k=0; k < 3; k++) {
+                ck_assert_double_eq(positions[k * N + mc->order[i]], mc->positions[k * S + i]);
+                ck_assert_double_eq(mc->positions[k * S + i], mc->positions_u[k * S + i] / 4294967296. * mc->box[k]);
+            }
+
+            if(sort)
+                ck_assert_int_eq(mc->types[i], i < 80 ? 0 : 1);
+        }
+
+        ck_assert_double_lt(tm_mc_check_energy(mc), 1e-8);
+
+        // and the simulation goes on
+        for(int i=0; i < 5; i++)
+            _OK(tm_mc_sweep(mc));
+
+        ck_assert_double_lt(tm_mc_check_energy(mc), 1e-2);
+
+        free(positions);
+        free(types);
+        _OK(tm_mc_delete(mc));
+    }
+}
+END_TEST
+
+START_TEST(test_mc_kernels_no_cutoff) {
+    tm_potential* LJ;
+    _OK(tm_potential_find("lj", &LJ));
+
+    // the cutoff is larger than the box
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(64, .8, .9, 10., .3);
+    ck_assert_ptr_nonnull(mc);
+    ck_assert_ptr_eq(mc->pair_kernel, LJ->kernels[0][1]);
+
+    for(int i=0; i < 5; i++)
+        _OK(tm_mc_sweep(mc));
+
+    double U1, vir1, U2, vir2;
+    tm_mc_compute_U(mc, &U1, &vir1);
+
+    mc->pair_kernel_virial = LJ->kernels[1][1];
+    tm_mc_compute_U(mc, &U2, &vir2);
+
+    ck_assert_double_eq_tol(U1, U2, 1e-8);
+    ck_assert_double_eq_tol(vir1, vir2, 1e-8);
+    ck_assert_double_eq_tol(U1, mc->U, 1e-8);
+
+    _OK(tm_mc_delete(mc));
+
+    // but not with the usual one
+    mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+    ck_assert_ptr_eq(mc->pair_kernel, LJ->kernels[1][1]);
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+START_TEST(test_mc_kernels_orthorhombic) {
+    double shape[] = {1., 1., 2.}, U = 0, vir = 0, U_ij, vir_ij, params[] = {4., 4.};
+
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+
+    _OK(tm_mc_set_box(mc, shape));
+    ck_assert_double_eq_tol(mc->box[0] * mc->box[1] * mc->box[2], mc->V, 1e-10);
+    ck_assert_double_eq_tol(mc->box[2], 2 * mc->box[0], 1e-10);
+
+    for(int i=0; i < 10; i++)
+        _OK(tm_mc_sweep(mc));
+
+    for(long i=0; i < mc->N; i++) {
+        for(int k=0; k < 3; k++) {
+            ck_assert_double_ge(mc->positions[k * mc->stride + i], 0);
+            ck_assert_double_le(mc->positions[k * mc->stride + i], mc->box[k]);
+        }
+    }
+
+    // the energy is the one of each pair, with the minimum image convention along each direction
+    for(long i=0; i < mc->N; i++) {
+        for(long j=i + 1; j < mc->N; j++) {
+            double r2 = 0;
+            for(int k=0; k < 3; k++) {
+                double dq = mc->positions[k * mc->stride + j] - mc->positions[k * mc->stride + i];
+                dq -= mc->box[k] * round(dq / mc->box[k]);
+                r2 += dq * dq;
+            }
+
+            if(r2 < mc->rc2) {
+                tm_pair_LJ(r2, params, &U_ij, &vir_ij);
+                U += U_ij;
+                vir += vir_ij;
+            }
+        }
+    }
+
+    ck_assert_double_eq_tol(U, mc->U, 1e-8);
+    ck_assert_double_eq_tol(vir, mc->vir, 1e-8);
+
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+START_TEST(test_mc_kernels_without_virial) {
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+
+    double U1 = 0, vir1 = 0, U2 = 0, vir2 = 0, vir = mc->vir;
+    tm_mc_compute_Ui(mc, 3, &U1, &vir1);
+
+    _OK(tm_mc_select_kernels(mc, 0));
+    tm_mc_compute_Ui(mc, 3, &U2, &vir2);
+    ck_assert_double_eq_tol(U1, U2, 1e-10);
+    ck_assert_double_ne(vir1, 0);
+    ck_assert_double_eq(vir2, 0);
+
+    // the energy is still updated, but not the virial
+    for(int i=0; i < 5; i++)
+        _OK(tm_mc_sweep(mc));
+
+    tm_mc_compute_U(mc, &U1, &vir1);
+    ck_assert_double_eq_tol(U1, mc->U, 1e-8);
+    ck_assert_double_eq(vir, mc->vir);
+    ck_assert_int_eq(mc->vir_is_valid, 0);
+
+    // ... until the pressure is needed
+    ck_assert_double_eq_tol(tm_mc_pressure(mc), vir1 / mc->V + mc->rho * mc->T + mc->P_tail, 1e-10);
+    ck_assert_int_eq(mc->vir_is_valid, 1);
+    ck_assert_double_eq(vir1, mc->vir);
+
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+START_TEST(test_mc_lazy_virial) {
+    // same moves, with the virial tracked or not
+    pcg32_init(42);
+    tm_mc* mc1 = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc1);
+
+    pcg32_init(42);
+    tm_mc* mc2 = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc2);
+
+    _OK(tm_mc_select_kernels(mc2, 0));
+
+    for(int i=0; i < 10; i++) {
+        pcg32_init(i);
+        _OK(tm_mc_sweep(mc1));
+
+        pcg32_init(i);
+        _OK(tm_mc_sweep(mc2));
+
+        if(i % 3 == 0)
+            ck_assert_double_eq_tol(tm_mc_pressure(mc1), tm_mc_pressure(mc2), 1e-8);
+    }
+
+    ck_assert_int_eq(mc1->N_accepted, mc2->N_accepted);
+    ck_assert_double_eq_tol(tm_mc_energy(mc1), tm_mc_energy(mc2), 1e-8);
+
+    // tracking again
+    _OK(tm_mc_select_kernels(mc2, 1));
+    ck_assert_int_eq(mc2->vir_is_valid, 1);
+    ck_assert_double_eq_tol(mc1->vir, mc2->vir, 1e-8);
+
+    _OK(tm_mc_delete(mc1));
+    _OK(tm_mc_delete(mc2));
+}
+END_TEST
+
+START_TEST(test_mc_single_precision) {
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(108, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+
+    double Ui_double[108] = {0}, vir = 0;
+    for(long i=0; i < mc->N; i++)
+        tm_mc_compute_Ui(mc, i, &Ui_double[i], &vir);
+
+    _OK(tm_mc_use_single_precision(mc, 1));
+    ck_assert_ptr_nonnull(mc->positions_f);
+
+    // per-atom energies are close to the double precision ones
+    for(long i=0; i < mc->N; i++) {
+        double Ui = 0;
+        tm_mc_compute_Ui(mc, i, &Ui, &vir);
+        ck_assert_double_eq_tol(Ui, Ui_double[i], 1e-4);
+    }
+
+    // per-atom virials as well
+    for(long i=0; i < mc->N; i++) {
+        double Ui = 0, viri = 0, viri_double = 0;
+        mc->energy_kernel_double(mc, mc->pair_kernel, i, 0, mc->N, &Ui, &viri_double);
+        Ui = 0;
+        tm_mc_compute_Ui(mc, i, &Ui, &viri);
+        ck_assert_double_eq_tol(viri, viri_double, 1e-3);
+    }
+
+    // the copy follows the moves, and the drift of the energy and pressure (with the virial tracked) stays small
+    for(int i=0; i < 10; i++)
+        _OK(tm_mc_sweep(mc));
+
+    for(long j=0; j < 3 * mc->stride; j++)
+        ck_assert_float_eq_tol(mc->positions_f[j], (float) mc->positions[j], 1e-5);
+
+    double P = tm_mc_pressure(mc);
+    ck_assert_double_lt(tm_mc_check_energy(mc), 1e-2);
+    ck_assert_double_eq_tol(tm_mc_pressure(mc), P, 1e-5);
+
+    // if the virial is not tracked, the pressure is computed in double precision
+    _OK(tm_mc_select_kernels(mc, 0));
+    for(int i=0; i < 10; i++)
+        _OK(tm_mc_sweep(mc));
+
+    // ... without touching the energy
+    double U = mc->U, U_drift = mc->U_drift;
+    P = tm_mc_pressure(mc);
+    ck_assert_double_eq(mc->U, U);
+    ck_assert_double_eq(mc->U_drift, U_drift);
+
+    tm_mc_recompute(mc);
+    ck_assert_double_eq_tol(tm_mc_pressure(mc), P, 1e-12);
+
+    // back to double precision
+    _OK(tm_mc_use_single_precision(mc, 0));
+    ck_assert_ptr_null(mc->positions_f);
+
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+START_TEST(test_mc_fixed_point) {
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(108, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+
+    double Ui_double[108] = {0}, vir = 0;
+    for(long i=0; i < mc->N; i++)
+        tm_mc_compute_Ui(mc, i, &Ui_double[i], &vir);
+
+    _OK(tm_mc_use_fixed_point(mc, 1));
+    ck_assert_ptr_nonnull(mc->positions_u);
+
+    // per-atom energies are close to the double precision ones
+    for(long i=0; i < mc->N; i++) {
+        double Ui = 0;
+        tm_mc_compute_Ui(mc, i, &Ui, &vir);
+        ck_assert_double_eq_tol(Ui, Ui_double[i], 1e-4);
+    }
+
+    // positions follow the ones in fixed point, and stay in the box
+    for(int i=0; i < 10; i++)
+        _OK(tm_mc_sweep(mc));
+
+    for(int k=0; k < 3; k++) {
+        for(long j=0; j < mc->N; j++) {
+            ck_assert_double_eq(mc->positions[k * mc->stride + j], mc->positions_u[k * mc->stride + j] / 4294967296. * mc->box[k]);
+            ck_assert(mc->positions[k * mc->stride + j] >= 0 && mc->positions[k * mc->stride + j] < mc->box[k]);
+        }
+    }
+
+    ck_assert_double_lt(tm_mc_check_energy(mc), 1e-2);
+
+    // reshaping the box does not change the fractions
+    uint32_t u0 = mc->positions_u[5];
+    double shape[] = {1., 1.2, 1.5};
+    _OK(tm_mc_set_box(mc, shape));
+    ck_assert_uint_eq(mc->positions_u[5], u0);
+
+    for(int i=0; i < 5; i++)
+        _OK(tm_mc_sweep(mc));
+
+    ck_assert_double_lt(tm_mc_check_energy(mc), 1e-2);
+
+    _OK(tm_mc_use_fixed_point(mc, 0));
+    ck_assert_ptr_null(mc->positions_u);
+
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: mc");
+
+    TCase* tc_mc = tcase_create("MC");
+    tcase_add_test(tc_mc, test_mc_lattice);
+    tcase_add_test(tc_mc, test_mc_energy_is_sum_of_Ui);
+    tcase_add_test(tc_mc, test_mc_sweep_keeps_track_of_energy);
+    tcase_add_test(tc_mc, test_mc_reproducible);
+
+    suite_add_tcase(s, tc_mc);
+
+    TCase* tc_mixture = tcase_create("mixture");
+    tcase_add_test(tc_mixture, test_mc_pair_coefs);
+    tcase_add_test(tc_mixture, test_mc_mixture_of_identical_types);
+    tcase_add_test(tc_mixture, test_mc_mixture_sorted);
+    tcase_add_test(tc_mixture, test_mc_potentials);
+    tcase_add_test(tc_mixture, test_mc_reorder);
+
+    suite_add_tcase(s, tc_mixture);
+
+    TCase* tc_kernels = tcase_create("kernels");
+    tcase_add_test(tc_kernels, test_mc_kernels_no_cutoff);
+    tcase_add_test(tc_kernels, test_mc_kernels_orthorhombic);
+    tcase_add_test(tc_kernels, test_mc_kernels_without_virial);
+    tcase_add_test(tc_kernels, test_mc_lazy_virial);
+    tcase_add_test(tc_kernels, test_mc_single_precision);
+    tcase_add_test(tc_kernels, test_mc_fixed_point);
+
+    suite_add_tcase(s, tc_kernels);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
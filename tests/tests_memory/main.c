@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../tests.h"
+#include "memory.h"
+#include "mc.h"
+#include "pcg32.h"
+#include "param_file_parser.h"
+
+START_TEST(test_memory_accounting) {
+    tm_memory_stats before, after, total;
+    tm_memory_stats_get(TM_MEM_IO, &before);
+
+    char* ptr = tm_malloc(100, TM_MEM_IO);
+    ck_assert_ptr_nonnull(ptr);
+    memset(ptr, 'a', 100);
+
+    tm_memory_stats_get(TM_MEM_IO, &after);
+    ck_assert_int_eq(after.current, before.current + 100);
+    ck_assert_int_ge(after.peak, before.current + 100);
+    ck_assert_int_eq(after.N_allocs, before.N_allocs + 1);
+
+    // the tag is kept on realloc, and content is preserved
+    ptr = tm_realloc(ptr, 1000, TM_MEM_GEOMETRY);
+    ck_assert_ptr_nonnull(ptr);
+    ck_assert_int_eq(ptr[99], 'a');
+
+    tm_memory_stats_get(TM_MEM_IO, &after);
+    ck_assert_int_eq(after.current, before.current + 1000);
+    ck_assert_int_ge(after.peak, before.current + 1000);
+    ck_assert_int_eq(after.N_allocs, before.N_allocs + 2);
+
+    tm_free(ptr);
+    tm_free(NULL);
+
+    tm_memory_stats_get(TM_MEM_IO, &after);
+    ck_assert_int_eq(after.current, before.current);
+    ck_assert_int_eq(after.N_frees, before.N_frees + 1);
+
+    // total is the sum of all tags
+    long sum = 0;
+    for(int i=0; i < TM_MEM_LAST; i++) {
+        tm_memory_stats_get(i, &after);
+        sum += after.current;
+    }
+
+    tm_memory_stats_get(TM_MEM_LAST, &total);
+    ck_assert_int_eq(total.current, sum);
+}
+END_TEST
+
+START_TEST(test_memory_aligned) {
+    tm_memory_stats before, after;
+    tm_memory_stats_get(TM_MEM_IO, &before);
+
+    for(size_t n=1; n < 100; n += 7) {
+        double* ptr = tm_calloc_aligned(n, sizeof(double), TM_MEM_IO);
+        ck_assert_ptr_nonnull(ptr);
+        ck_assert_int_eq((uintptr_t) ptr % TM_MEMORY_ALIGNMENT, 0);
+
+        for(size_t i=0; i < n; i++)
+            ck_assert_double_eq(ptr[i], 0);
+
+        tm_memory_stats_get(TM_MEM_IO, &after);
+        ck_assert_int_eq(after.current, before.current + (long) (n * sizeof(double)));
+
+        tm_free(ptr);
+    }
+
+    tm_memory_stats_get(TM_MEM_IO, &after);
+    ck_assert_int_eq(after.current, before.current);
+
+    // padding
+    ck_assert_int_eq(TM_MEMORY_PADDED(1), 16);
+    ck_assert_int_eq(TM_MEMORY_PADDED(16), 16);
+    ck_assert_int_eq(TM_MEMORY_PADDED(17), 32);
+}
+END_TEST
+
+START_TEST(test_memory_parameters) {
+    tm_memory_stats before, after;
+    tm_memory_stats_get(TM_MEM_PARAMETERS, &before);
+
+    tm_parf_t* obj = tm_parf_loads("key \"value\"\nlist [1 2 3]");
+    ck_assert_ptr_nonnull(obj);
+
+    tm_memory_stats_get(TM_MEM_PARAMETERS, &after);
+    ck_assert_int_gt(after.current, before.current);
+
+    _OK(tm_parf_delete(obj));
+
+    // nothing leaked
+    tm_memory_stats_get(TM_MEM_PARAMETERS, &after);
+    ck_assert_int_eq(after.current, before.current);
+}
+END_TEST
+
+START_TEST(test_memory_no_allocation_in_sweeps) {
+    tm_memory_stats before, after;
+
+    pcg32_init(42);
+    tm_mc* mc = tm_mc_new(64, .8, .9, 2., .3);
+    ck_assert_ptr_nonnull(mc);
+
+    mc->move_latency = tm_histogram_new();
+    ck_assert_ptr_nonnull(mc->move_latency);
+
+    tm_memory_stats_get(TM_MEM_LAST, &before);
+
+    for(int i=0; i < 5; i++)
+        _OK(tm_mc_sweep(mc));
+
+    tm_memory_stats_get(TM_MEM_LAST, &after);
+    ck_assert_int_eq(after.N_allocs, before.N_allocs);
+    ck_assert_int_eq(after.N_frees, before.N_frees);
+
+    _OK(tm_histogram_delete(mc->move_latency));
+    _OK(tm_mc_delete(mc));
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: memory");
+
+    TCase* tc_memory = tcase_create("memory");
+    tcase_add_test(tc_memory, test_memory_accounting);
+    tcase_add_test(tc_memory, test_memory_aligned);
+    tcase_add_test(tc_memory, test_memory_parameters);
+    tcase_add_test(tc_memory, test_memory_no_allocation_in_sweeps);
+
+    suite_add_tcase(s, tc_memory);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "../tests.h"
+#include "observables.h"
+#include "memory.h"
+
+// more than what fits in the buffer
+#define N_RECORDS (2 * TM_OBSERVABLES_BUFFER_SIZE + 7)
+
+static void write_and_read(char* path, tm_observables_format format) {
+    tm_observables_sink* sink = tm_observables_sink_new(path, format);
+    ck_assert_ptr_nonnull(sink);
+
+    for(int i=0; i < N_RECORDS; i++) {
+        tm_observables_record record = {i + 1, 100 * (i + 1), 42 * (i + 1), -5.5 + 1. / (i + 1), sqrt(i)};
+        _OK(tm_observables_sink_append(sink, &record));
+    }
+
+    ck_assert_int_eq(sink->N_records, N_RECORDS);
+    _OK(tm_observables_sink_delete(sink));
+
+    // read back
+    FILE* f = fopen(path, "rb");
+    ck_assert_ptr_nonnull(f);
+
+    tm_observables_record* records;
+    long N;
+    _OK(tm_observables_read(f, &records, &N));
+    fclose(f);
+
+    ck_assert_int_eq(N, N_RECORDS);
+    for(int i=0; i < N_RECORDS; i++) {
+        ck_assert_int_eq(records[i].sweep, i + 1);
+        ck_assert_int_eq(records[i].N_moves, 100 * (i + 1));
+        ck_assert_int_eq(records[i].N_accepted, 42 * (i + 1));
+
+        // exact, even in CSV
+        ck_assert_double_eq(records[i].U, -5.5 + 1. / (i + 1));
+        ck_assert_double_eq(records[i].P, sqrt(i));
+    }
+
+    tm_free(records);
+    remove(path);
+}
+
+START_TEST(test_observables_binary) {
+    write_and_read("test_observables.bin", TM_OBSERVABLES_BINARY);
+}
+END_TEST
+
+START_TEST(test_observables_csv) {
+    write_and_read("test_observables.csv", TM_OBSERVABLES_CSV);
+}
+END_TEST
+
+START_TEST(test_observables_invalid) {
+    tm_observables_record* records;
+    long N;
+
+    char* contents[] = {
+            "", // empty
+            "x,y,z\n1,2,3\n", // not the right header
+            "sweep,N_moves,N_accepted,U,P\n1,2,3,4.5\n", // missing field
+            "TMOB\x03", // wrong record size
+    };
+
+    for(int i=0; i < 4; i++) {
+        FILE* f = tmpfile();
+        ck_assert_ptr_nonnull(f);
+
+        fputs(contents[i], f);
+        rewind(f);
+
+        ck_assert_int_eq(tm_observables_read(f, &records, &N), TM_ERR_READ);
+        ck_assert_ptr_null(records);
+        ck_assert_int_eq(N, 0);
+
+        fclose(f);
+    }
+
+    // a truncated record (e.g., the run was interrupted) is ignored
+    FILE* f = tmpfile();
+    ck_assert_ptr_nonnull(f);
+
+    uint32_t record_size = sizeof(tm_observables_record);
+    fwrite(TM_OBSERVABLES_MAGIC, 1, 4, f);
+    fwrite(&record_size, sizeof(uint32_t), 1, f);
+    fwrite("abc", 1, 3, f);
+    rewind(f);
+
+    _OK(tm_observables_read(f, &records, &N));
+    ck_assert_int_eq(N, 0);
+    tm_free(records);
+
+    fclose(f);
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: observables");
+
+    TCase* tc_observables = tcase_create("observables");
+    tcase_add_test(tc_observables, test_observables_binary);
+    tcase_add_test(tc_observables, test_observables_csv);
+    tcase_add_test(tc_observables, test_observables_invalid);
+
+    suite_add_tcase(s, tc_observables);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
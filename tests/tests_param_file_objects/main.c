@@ -1,4 +1,5 @@
 #include "param_file_objects.h"
+#include "memory.h"
 #include "../tests.h"
 
 /* Booleans */
@@ -227,6 +228,22 @@ START_TEST(test_parf_list_iterate) {
 }
 END_TEST
 
+START_TEST(test_parf_list_delete_long) {
+    // deleting does not recurse over the elements
+    for(int i=0; i < 1000000; i++)
+        _OK(tm_parf_list_append(obj_list, tm_parf_integer_new(i)));
+
+    ck_assert_uint_eq(obj_list->val_size, 1000000);
+
+    // access by index
+    tm_parf_t* elm;
+    long v;
+    _OK(tm_parf_list_get(obj_list, 999999, &elm));
+    _OK(tm_parf_integer_value(elm, &v));
+    ck_assert_int_eq(v, 999999);
+}
+END_TEST
+
 /* objects */
 tm_parf_t* obj_object;
 
@@ -341,6 +358,70 @@ START_TEST(test_parf_object_iterate) {
 }
 END_TEST
 
+START_TEST(test_parf_object_many) {
+    char key[16];
+    int n = 10000;
+    long v;
+    tm_parf_t* elm;
+
+    for(int i=0; i < n; i++) {
+        sprintf(key, "key%d", i);
+        _OK(tm_parf_object_set(obj_object, key, tm_parf_integer_new(i)));
+    }
+
+    ck_assert_uint_eq(obj_object->val_size, n);
+
+    for(int i=0; i < n; i++) {
+        sprintf(key, "key%d", i);
+        _OK(tm_parf_object_get(obj_object, key, &elm));
+        _OK(tm_parf_integer_value(elm, &v));
+        ck_assert_int_eq(v, i);
+    }
+
+    // replace one in the middle, order is kept
+    tm_parf_t* val = tm_parf_integer_new(-1);
+    _OK(tm_parf_object_set(obj_object, "key42", val));
+    ck_assert_uint_eq(obj_object->val_size, n);
+    _OK(tm_parf_object_get(obj_object, "key41", &elm));
+    ck_assert_ptr_eq(elm->next, val);
+    ck_assert_str_eq(val->next->key, "key43");
+
+    _NOK(tm_parf_object_get(obj_object, "key", &elm));
+}
+END_TEST
+
+START_TEST(test_parf_object_arena_with_heap) {
+    tm_memory_stats before, after;
+    tm_memory_stats_get(TM_MEM_PARAMETERS, &before);
+
+    tm_arena* arena = tm_arena_new(256);
+    ck_assert_ptr_nonnull(arena);
+
+    tm_parf_t* root = tm_parf_new_in(arena, TM_T_OBJECT);
+    ck_assert_ptr_nonnull(root);
+    root->owns_arena = 1;
+
+    // objects from the arena and from the heap, at any depth
+    tm_parf_t* list = tm_parf_new_in(arena, TM_T_LIST);
+    _OK(tm_parf_object_set(root, "list", list));
+    _OK(tm_parf_list_append(list, tm_parf_string_new("heap")));
+    _OK(tm_parf_list_append(list, tm_parf_new_in(arena, TM_T_INTEGER)));
+
+    tm_parf_t* heap_list = tm_parf_list_new();
+    _OK(tm_parf_list_append_integer(heap_list, 42));
+    _OK(tm_parf_object_set(root, "heap_list", heap_list));
+    _OK(tm_parf_object_set(root, "heap", tm_parf_integer_new(1)));
+
+    // replaced
+    _OK(tm_parf_object_set(root, "heap", tm_parf_real_new(2.)));
+
+    _OK(tm_parf_delete(root));
+
+    tm_memory_stats_get(TM_MEM_PARAMETERS, &after);
+    ck_assert_int_eq(after.current, before.current);
+}
+END_TEST
+
 int main(int argc, char* argv[]) {
     Suite* s = suite_create("tests: param_file_objects");
 
@@ -384,6 +465,7 @@ int main(int argc, char* argv[]) {
     tcase_add_test(tc_list, test_parf_list_get);
     tcase_add_test(tc_list, test_parf_list_length);
     tcase_add_test(tc_list, test_parf_list_iterate);
+    tcase_add_test(tc_list, test_parf_list_delete_long);
 
     suite_add_tcase(s, tc_list);
 
@@ -393,6 +475,8 @@ int main(int argc, char* argv[]) {
     tcase_add_test(tc_object, test_parf_object_set);
     tcase_add_test(tc_object, test_parf_object_get);
     tcase_add_test(tc_object, test_parf_object_iterate);
+    tcase_add_test(tc_object, test_parf_object_many);
+    tcase_add_test(tc_object, test_parf_object_arena_with_heap);
 
     suite_add_tcase(s, tc_object);
 
@@ -3,29 +3,29 @@
 #include "lexer.h"
 
 int tm_lexer_advance(tm_parf_token *tk, char *input, int shift);
-tm_parf_t *tm_parf_parse_string(tm_parf_token *tk, char *input);
-tm_parf_t *tm_parf_parse_number(tm_parf_token *tk, char *input);
-tm_parf_t *tm_parf_parse_boolean(tm_parf_token *tk, char *input);
-tm_parf_t *tm_parf_parse_list(tm_parf_token *tk, char *input);
+tm_parf_t *tm_parf_parse_string(tm_parf_token *tk, char *input, tm_arena* arena);
+tm_parf_t *tm_parf_parse_number(tm_parf_token *tk, char *input, tm_arena* arena);
+tm_parf_t *tm_parf_parse_boolean(tm_parf_token *tk, char *input, tm_arena* arena);
+tm_parf_t *tm_parf_parse_list(tm_parf_token *tk, char *input, tm_arena* arena);
 
 tm_parf_t *parse_string(tm_parf_token *t, char *input) {
     _OK(tm_lexer_token_init(t, input));
-    return tm_parf_parse_string(t, input);
+    return tm_parf_parse_string(t, input, NULL);
 }
 
 tm_parf_t *parse_number(tm_parf_token *t, char *input) {
     _OK(tm_lexer_token_init(t, input));
-    return tm_parf_parse_number(t, input);
+    return tm_parf_parse_number(t, input, NULL);
 }
 
 tm_parf_t *parse_boolean(tm_parf_token *t, char *input) {
     _OK(tm_lexer_token_init(t, input));
-    return tm_parf_parse_boolean(t, input);
+    return tm_parf_parse_boolean(t, input, NULL);
 }
 
 tm_parf_t *parse_list(tm_parf_token *t, char *input) {
     _OK(tm_lexer_token_init(t, input));
-    return tm_parf_parse_list(t, input);
+    return tm_parf_parse_list(t, input, NULL);
 }
 
 START_TEST(test_parser_string) {
@@ -228,6 +228,54 @@ START_TEST(test_parser_list) {
 }
 END_TEST
 
+START_TEST(test_parser_list_packed) {
+    tm_parf_token t;
+    tm_parf_t* obj_list, *elmt;
+    unsigned int sz;
+    double* vals_real;
+    long* vals_int;
+
+    // reals
+    char* input = "[5. 5.5 6.]";
+    obj_list = parse_list(&t, input);
+    ck_assert_ptr_nonnull(obj_list);
+
+    _OK(tm_parf_list_reals(obj_list, &vals_real, &sz));
+    ck_assert_uint_eq(sz, 3);
+    ck_assert_double_eq(vals_real[1], 5.5);
+    _NOK(tm_parf_list_integers(obj_list, &vals_int, &sz));
+
+    // accessing an element unpacks the list
+    _OK(tm_parf_list_get(obj_list, 2, &elmt));
+    ck_assert_int_eq(elmt->val_type, TM_T_REAL);
+    _NOK(tm_parf_list_reals(obj_list, &vals_real, &sz));
+    tm_parf_delete(obj_list);
+
+    // not homogeneous
+    char* others[] = {"[1 2 3.]", "[1. 2. \"x\"]", "[\"x\" 1 2]"};
+    tm_parf_type types[][3] = {
+            {TM_T_INTEGER, TM_T_INTEGER, TM_T_REAL},
+            {TM_T_REAL, TM_T_REAL, TM_T_STRING},
+            {TM_T_STRING, TM_T_INTEGER, TM_T_INTEGER}
+    };
+
+    for(int i=0; i < 3; i++) {
+        obj_list = parse_list(&t, others[i]);
+        ck_assert_ptr_nonnull(obj_list);
+        ck_assert_int_eq(obj_list->val_packed, TM_T_LAST);
+        _NOK(tm_parf_list_reals(obj_list, &vals_real, &sz));
+        _NOK(tm_parf_list_integers(obj_list, &vals_int, &sz));
+
+        for(int j=0; j < 3; j++) {
+            _OK(tm_parf_list_get(obj_list, j, &elmt));
+            ck_assert_int_eq(elmt->val_type, types[i][j]);
+        }
+
+        tm_parf_delete(obj_list);
+    }
+}
+END_TEST
+
 START_TEST(test_parser_object) {
     char tmp[100];
     char* key[] = {
@@ -275,6 +323,69 @@ START_TEST(test_parser_object) {
 }
 END_TEST
 
+START_TEST(test_parser_boolean_from_file) {
+    FILE* f = fopen("test_booleans.inp", "r");
+    ck_assert_ptr_nonnull(f);
+
+    char input[256];
+    size_t sz = fread(input, sizeof(char), 255, f);
+    input[sz] = '\0';
+    fclose(f);
+
+    // words start a boolean value
+    tm_parf_t* obj = tm_parf_loads(input);
+    ck_assert_ptr_nonnull(obj);
+
+    char* keys[] = {"a", "b", "c", "d", "e", "f"};
+    int values[] = {1, 0, 1, 0, 1, 0}, val;
+    tm_parf_t* elmt;
+
+    for(int i=0; i < 6; i++) {
+        _OK(tm_parf_object_get(obj, keys[i], &elmt));
+        _OK(tm_parf_boolean_value(elmt, &val));
+        ck_assert_int_eq(val, values[i]);
+    }
+
+    tm_parf_delete(obj);
+}
+END_TEST
+
+START_TEST(test_parser_large) {
+    int n = 100000;
+    char* input = malloc((16 + 8 * n) * sizeof(char));
+    ck_assert_ptr_nonnull(input);
+
+    int pos = sprintf(input, "key \"value\"\nlist [");
+    for(int i=0; i < n; i++)
+        pos += sprintf(input + pos, " %d", i);
+    sprintf(input + pos, "]");
+
+    tm_parf_t* obj_object = tm_parf_loads(input);
+    ck_assert_ptr_nonnull(obj_object);
+    ck_assert_ptr_nonnull(obj_object->arena);
+
+    tm_parf_t* elmt;
+    char* val_str;
+    _OK(tm_parf_object_get(obj_object, "key", &elmt));
+    _OK(tm_parf_string_value(elmt, &val_str));
+    ck_assert_str_eq(val_str, "value");
+
+    unsigned int sz;
+    long* vals;
+    _OK(tm_parf_object_get(obj_object, "list", &elmt));
+    _OK(tm_parf_list_length(elmt, &sz));
+    ck_assert_uint_eq(sz, n);
+
+    // packed
+    ck_assert_int_eq(elmt->val_packed, TM_T_INTEGER);
+    _OK(tm_parf_list_integers(elmt, &vals, &sz));
+    ck_assert_uint_eq(sz, n);
+    ck_assert_int_eq(vals[n - 1], n - 1);
+
+    _OK(tm_parf_delete(obj_object));
+    free(input);
+}
+END_TEST
 
 int main(int argc, char* argv[]) {
     Suite* s = suite_create("tests: param_file_parser");
@@ -285,7 +396,10 @@ int main(int argc, char* argv[]) {
     tcase_add_test(tc_parser, test_parser_number);
     tcase_add_test(tc_parser, test_parser_boolean);
     tcase_add_test(tc_parser, test_parser_list);
+    tcase_add_test(tc_parser, test_parser_list_packed);
     tcase_add_test(tc_parser, test_parser_object);
+    tcase_add_test(tc_parser, test_parser_boolean_from_file);
+    tcase_add_test(tc_parser, test_parser_large);
 
     suite_add_tcase(s, tc_parser);
 
@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "../tests.h"
+#include "perf_counters.h"
+#include "profile.h"
+
+// counters may not be available (e.g., in a container), which should not be an error
+START_TEST(test_perf_counters_read) {
+    double values[TM_PERF_LAST], values2[TM_PERF_LAST];
+
+    tm_perf_counters* counters = tm_perf_counters_new();
+    ck_assert_ptr_nonnull(counters);
+
+    int err = tm_perf_counters_read(counters, values);
+
+    if(counters->N_available == 0) {
+        ck_assert_int_eq(err, TM_ERR_NOT_FOUND);
+        for(int i=0; i < TM_PERF_LAST; i++)
+            ck_assert(isnan(values[i]));
+    } else {
+        _OK(err);
+
+        // do something
+        double x = 0;
+        for(int i=0; i < 100000; i++)
+            x += sqrt((double) i);
+        ck_assert_double_gt(x, 0);
+
+        _OK(tm_perf_counters_read(counters, values2));
+
+        for(int i=0; i < TM_PERF_LAST; i++) {
+            if(counters->fds[i] < 0)
+                ck_assert(isnan(values[i]));
+            else
+                ck_assert_double_ge(values2[i], values[i]);
+        }
+    }
+
+    _OK(tm_perf_counters_delete(counters));
+}
+END_TEST
+
+START_TEST(test_perf_counters_in_profile) {
+    tm_profile_region path[] = {TM_REGION_RUN};
+    double values[TM_PERF_LAST];
+
+    _OK(tm_profile_init(0));
+    int err = tm_profile_use_counters(1);
+
+    tm_profile_begin(TM_REGION_RUN);
+    tm_profile_end(TM_REGION_RUN);
+
+    if(err == TM_ERR_OK)
+        _OK(tm_profile_get_counters(path, 1, values));
+    else {
+        ck_assert_int_eq(err, TM_ERR_NOT_FOUND);
+        _NOK(tm_profile_get_counters(path, 1, values));
+    }
+
+    _OK(tm_profile_finalize());
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: perf counters");
+
+    TCase* tc_perf = tcase_create("perf counters");
+    tcase_add_test(tc_perf, test_perf_counters_read);
+    tcase_add_test(tc_perf, test_perf_counters_in_profile);
+
+    suite_add_tcase(s, tc_perf);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "../tests.h"
 #include "potentials.h"
@@ -33,6 +34,118 @@ START_TEST(test_compute_LJ_3p_with_PBC) {
 }
 END_TEST
 
+START_TEST(test_pair_functions_virial) {
+    // the virial is -r/3 dU/dr
+    double params_LJ[] = {4., 4.}, params_morse[] = {1., 2., 1.2}, params_buck[] = {1000., 5., 2.};
+    tm_pair_function functions[] = {tm_pair_LJ, tm_pair_morse, tm_pair_buckingham};
+    double* params[] = {params_LJ, params_morse, params_buck};
+
+    for(int f=0; f < 3; f++) {
+        for(double r=.9; r < 3.; r += .1) {
+            double U1, U2, U, vir, vir_h, h = 1e-6;
+            functions[f](r * r, params[f], &U, &vir);
+            functions[f]((r - h) * (r - h), params[f], &U1, &vir_h);
+            functions[f]((r + h) * (r + h), params[f], &U2, &vir_h);
+            ck_assert_double_eq_tol(vir, -r / 3 * (U2 - U1) / (2 * h), 1e-6 * fmax(1, fabs(vir)));
+        }
+    }
+
+    // well depth and position
+    double U, vir;
+    tm_pair_LJ(pow(2, 1. / 3), params_LJ, &U, &vir);
+    ck_assert_double_eq_tol(U, -1., 1e-12);
+    ck_assert_double_eq_tol(vir, 0, 1e-12);
+
+    tm_pair_morse(1.2 * 1.2, params_morse, &U, &vir);
+    ck_assert_double_eq_tol(U, -1., 1e-12);
+    ck_assert_double_eq_tol(vir, 0, 1e-12);
+}
+END_TEST
+
+START_TEST(test_registry) {
+    char* names[] = {"lj", "wca", "sf-lj", "morse", "buckingham"};
+    double r2[40];
+
+    for(int j=0; j < 40; j++)
+        r2[j] = (.85 + .06 * j) * (.85 + .06 * j);
+
+    r2[39] = INFINITY;
+
+    for(int p=0; p < 5; p++) {
+        tm_potential* potential;
+        double params[TM_POTENTIAL_MAX_PARAMS], rc2 = 2.5 * 2.5 * 1.1 * 1.1, U = 0, vir = 0, Us = 0, virs = 0, Ui, viri;
+
+        _OK(tm_potential_find(names[p], &potential));
+        ck_assert_str_eq(potential->name, names[p]);
+        potential->setup(1.5, 1.1, potential->alpha, params, &rc2);
+
+        // the kernel sums the scalar version within the cutoff
+        potential->kernels[1][1](40, r2, params, rc2, &U, &vir);
+        for(int j=0; j < 40; j++) {
+            if(r2[j] < rc2) {
+                potential->function(r2[j], params, &Ui, &viri);
+                Us += Ui;
+                virs += viri;
+            }
+        }
+
+        ck_assert_double_eq_tol(U, Us, 1e-10);
+        ck_assert_double_eq_tol(vir, virs, 1e-10);
+
+        // same minimum as LJ (WCA is zero there, and shifted-force LJ is shifted)
+        if(p != 1 && p != 2) {
+            potential->function(cbrt(2.) * 1.1 * 1.1, params, &Ui, &viri);
+            ck_assert_double_eq_tol(Ui, -1.5, 1e-10);
+            ck_assert_double_eq_tol(viri, 0, 1e-10);
+        }
+
+        // the integral of r^2 U(r) beyond the cutoff
+        if(potential->tail != NULL) {
+            double integral = 0, h = 1e-3;
+            for(double r=sqrt(rc2) + h / 2; r < 200.; r += h) {
+                potential->function(r * r, params, &Ui, &viri);
+                integral += h * r * r * Ui;
+            }
+
+            ck_assert_double_eq_tol(potential->tail(params, rc2), integral, 1e-6);
+        }
+    }
+
+    tm_potential* potential;
+    ck_assert_int_eq(tm_potential_find("coulomb", &potential), TM_ERR_NOT_FOUND);
+}
+END_TEST
+
+START_TEST(test_truncated_potentials) {
+    tm_potential* potential;
+    double params[TM_POTENTIAL_MAX_PARAMS], rc2 = 2.5 * 2.5, U, vir, U1, U2, h = 1e-6;
+
+    // WCA is purely repulsive and zero at its cutoff
+    _OK(tm_potential_find("wca", &potential));
+    potential->setup(1., 1., 0, params, &rc2);
+    ck_assert_double_eq_tol(rc2, cbrt(2.), 1e-12);
+    potential->function(rc2, params, &U, &vir);
+    ck_assert_double_eq_tol(U, 0, 1e-12);
+
+    // shifted-force LJ: energy and force are zero at the cutoff
+    rc2 = 2.5 * 2.5;
+    _OK(tm_potential_find("sf-lj", &potential));
+    potential->setup(1., 1., 0, params, &rc2);
+    ck_assert_double_eq_tol(rc2, 6.25, 1e-12);
+    potential->function(rc2, params, &U, &vir);
+    ck_assert_double_eq_tol(U, 0, 1e-12);
+    ck_assert_double_eq_tol(vir, 0, 1e-12);
+
+    // ... and the virial is still -r/3 dU/dr
+    for(double r=.9; r < 2.5; r += .1) {
+        potential->function(r * r, params, &U, &vir);
+        potential->function((r - h) * (r - h), params, &U1, &U);
+        potential->function((r + h) * (r + h), params, &U2, &U);
+        ck_assert_double_eq_tol(vir, -r / 3 * (U2 - U1) / (2 * h), 1e-6 * fmax(1, fabs(vir)));
+    }
+}
+END_TEST
+
 int main(int argc, char* argv[]) {
     Suite* s = suite_create("tests: potentials");
 
@@ -42,6 +155,19 @@ int main(int argc, char* argv[]) {
 
     suite_add_tcase(s, tc_LJ);
 
+    // pair functions
+    TCase* tc_pair = tcase_create("pair functions");
+    tcase_add_test(tc_pair, test_pair_functions_virial);
+
+    suite_add_tcase(s, tc_pair);
+
+    // registry
+    TCase* tc_registry = tcase_create("registry");
+    tcase_add_test(tc_registry, test_registry);
+    tcase_add_test(tc_registry, test_truncated_potentials);
+
+    suite_add_tcase(s, tc_registry);
+
     // run suite
     SRunner *sr = srunner_create(s) ;
     srunner_run_all(sr, CK_VERBOSE);
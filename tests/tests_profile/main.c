@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../tests.h"
+#include "profile.h"
+
+START_TEST(test_profile_disabled) {
+    tm_profile_region path[] = {TM_REGION_RUN};
+    long count;
+    double total;
+
+    _OK(tm_profile_finalize());
+
+    // nothing is recorded
+    tm_profile_begin(TM_REGION_RUN);
+    tm_profile_end(TM_REGION_RUN);
+
+    _NOK(tm_profile_get(path, 1, &count, &total));
+}
+END_TEST
+
+START_TEST(test_profile_nested) {
+    long count;
+    double total, total_sweep;
+
+    _OK(tm_profile_init(0));
+
+    tm_profile_begin(TM_REGION_RUN);
+    for(int i=0; i < 3; i++) {
+        tm_profile_begin(TM_REGION_SWEEP);
+        for(int j=0; j < 4; j++) {
+            tm_profile_begin(TM_REGION_ENERGY);
+            tm_profile_end(TM_REGION_ENERGY);
+        }
+        tm_profile_end(TM_REGION_SWEEP);
+    }
+
+    tm_profile_begin(TM_REGION_ENERGY);
+    tm_profile_end(TM_REGION_ENERGY);
+    tm_profile_end(TM_REGION_RUN);
+
+    // each region is counted, given its parents
+    tm_profile_region path_run[] = {TM_REGION_RUN};
+    _OK(tm_profile_get(path_run, 1, &count, &total));
+    ck_assert_int_eq(count, 1);
+
+    tm_profile_region path_sweep[] = {TM_REGION_RUN, TM_REGION_SWEEP};
+    _OK(tm_profile_get(path_sweep, 2, &count, &total_sweep));
+    ck_assert_int_eq(count, 3);
+    ck_assert_double_le(total_sweep, total);
+
+    tm_profile_region path_energy[] = {TM_REGION_RUN, TM_REGION_SWEEP, TM_REGION_ENERGY};
+    _OK(tm_profile_get(path_energy, 3, &count, &total));
+    ck_assert_int_eq(count, 12);
+    ck_assert_double_le(total, total_sweep);
+
+    tm_profile_region path_energy2[] = {TM_REGION_RUN, TM_REGION_ENERGY};
+    _OK(tm_profile_get(path_energy2, 2, &count, &total));
+    ck_assert_int_eq(count, 1);
+
+    // never opened
+    tm_profile_region path_io[] = {TM_REGION_RUN, TM_REGION_IO};
+    _NOK(tm_profile_get(path_io, 2, &count, &total));
+
+    _OK(tm_profile_finalize());
+}
+END_TEST
+
+START_TEST(test_profile_trace) {
+    _OK(tm_profile_init(1));
+
+    for(int i=0; i < 2; i++) {
+        tm_profile_begin(TM_REGION_SWEEP);
+        tm_profile_begin(TM_REGION_ENERGY); // too deep to be traced
+        tm_profile_end(TM_REGION_ENERGY);
+        tm_profile_end(TM_REGION_SWEEP);
+    }
+
+    FILE* f = tmpfile();
+    ck_assert_ptr_nonnull(f);
+    _OK(tm_profile_write_trace(f));
+
+    char buffer[1024];
+    rewind(f);
+    size_t sz = fread(buffer, 1, 1023, f);
+    buffer[sz] = '\0';
+    fclose(f);
+
+    int N_events = 0;
+    for(char* c = strstr(buffer, "\"ph\""); c != NULL; c = strstr(c + 1, "\"ph\""))
+        N_events++;
+
+    ck_assert_int_eq(N_events, 2);
+    ck_assert_ptr_nonnull(strstr(buffer, "\"name\": \"sweep\""));
+    ck_assert_ptr_null(strstr(buffer, "\"name\": \"energy\""));
+
+    _OK(tm_profile_finalize());
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: profile");
+
+    TCase* tc_profile = tcase_create("profile");
+    tcase_add_test(tc_profile, test_profile_disabled);
+    tcase_add_test(tc_profile, test_profile_nested);
+    tcase_add_test(tc_profile, test_profile_trace);
+
+    suite_add_tcase(s, tc_profile);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -30,12 +30,78 @@ START_TEST(test_read) {
 }
 END_TEST
 
+START_TEST(test_read_species) {
+    sp = tm_simulation_parameters_new();
+    ck_assert_ptr_nonnull(sp);
+
+    // no species by default
+    ck_assert_int_eq(sp->N_species, 0);
+
+    FILE* f = fopen("test_dummy_species.inp", "r");
+    ck_assert_ptr_nonnull(f);
+
+    _OK(tm_simulation_parameters_read(sp, f));
+
+    ck_assert_int_eq(sp->N_species, 2);
+    ck_assert_str_eq(sp->species[0], "Ar");
+    ck_assert_str_eq(sp->species[1], "Kr");
+    ck_assert_int_eq(sp->composition[0], 200);
+    ck_assert_int_eq(sp->composition[1], 56);
+    ck_assert_double_eq(sp->epsilon[1], 1.4);
+    ck_assert_double_eq(sp->sigma[1], 1.07);
+    ck_assert_int_eq(sp->mixing_rule, TM_MIXING_GEOMETRIC);
+    ck_assert_int_eq(sp->sort_species, 0);
+    ck_assert_str_eq(sp->potential->name, "morse");
+    ck_assert_double_eq(sp->potential_alpha, 5.5);
+    ck_assert_int_eq(sp->single_precision, 1);
+    ck_assert_int_eq(sp->fixed_point, 1);
+    ck_assert_int_eq(sp->reorder_freq, 50);
+
+    fclose(f);
+    _OK(tm_simulation_parameters_delete(sp));
+}
+END_TEST
+
+START_TEST(test_read_species_invalid) {
+    char* inputs[] = {
+            "composition [1 2]", // no species
+            "species [\"A\" \"B\"]", // no composition
+            "species [\"A\" \"B\"]\ncomposition [1 2 3]", // wrong size
+            "species [\"A\" \"A\"]\ncomposition [1 2]", // twice the same
+            "species [\"A\"]\ncomposition [1]\nsigma [-1.]", // negative
+            "species [\"A\"]\ncomposition [1]\nmixing_rule \"arithmetic\"", // unknown rule
+            "species \"A\"\ncomposition [1]", // not a list
+            "potential \"coulomb\"", // unknown potential
+            "potential_alpha -1.", // negative
+            "potential \"morse\"\npotential_alpha -1.", // negative
+            "potential \"buckingham\"\npotential_alpha 6.", // not steep enough
+    };
+
+    for(int i=0; i < 11; i++) {
+        sp = tm_simulation_parameters_new();
+        ck_assert_ptr_nonnull(sp);
+
+        FILE* f = tmpfile();
+        ck_assert_ptr_nonnull(f);
+        fputs(inputs[i], f);
+        rewind(f);
+
+        _NOK(tm_simulation_parameters_read(sp, f));
+
+        fclose(f);
+        _OK(tm_simulation_parameters_delete(sp));
+    }
+}
+END_TEST
+
 int main(int argc, char* argv[]) {
     Suite* s = suite_create("tests: simulation_parameters");
 
     // read
     TCase* tc_lexer = tcase_create("read");
     tcase_add_test(tc_lexer, test_read);
+    tcase_add_test(tc_lexer, test_read_species);
+    tcase_add_test(tc_lexer, test_read_species_invalid);
 
     suite_add_tcase(s, tc_lexer);
 
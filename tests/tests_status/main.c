@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../tests.h"
+#include "status.h"
+
+#define SOCKET_PATH "test_status.sock"
+
+static int query(char* path, char* buffer, size_t size) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0)
+        return -1;
+
+    size_t total = 0;
+    ssize_t sz;
+    while ((sz = read(fd, buffer + total, size - 1 - total)) > 0)
+        total += sz;
+
+    buffer[total] = '\0';
+    close(fd);
+
+    return (int) total;
+}
+
+START_TEST(test_status_publish_read) {
+    tm_status_server* server = tm_status_server_new(SOCKET_PATH);
+    ck_assert_ptr_nonnull(server);
+
+    tm_status status = {3, 10, 1.5, 300, 150, -42., .5}, found;
+    tm_status_server_publish(server, &status);
+
+    _OK(tm_status_server_read(server, &found));
+    ck_assert_int_eq(found.sweep, 3);
+    ck_assert_int_eq(found.N_accepted, 150);
+    ck_assert_double_eq(found.U, -42.);
+
+    _OK(tm_status_server_delete(server));
+    ck_assert_int_ne(access(SOCKET_PATH, F_OK), 0);
+}
+END_TEST
+
+START_TEST(test_status_query) {
+    char buffer[1024];
+
+    tm_status_server* server = tm_status_server_new(SOCKET_PATH);
+    ck_assert_ptr_nonnull(server);
+
+    tm_status status = {3, 10, 1.5, 300, 150, -42., .5};
+    tm_status_server_publish(server, &status);
+
+    ck_assert_int_gt(query(SOCKET_PATH, buffer, 1024), 0);
+    ck_assert_ptr_nonnull(strstr(buffer, "\"sweep\": 3,"));
+    ck_assert_ptr_nonnull(strstr(buffer, "\"moves_per_s\": 200.0,"));
+    ck_assert_ptr_nonnull(strstr(buffer, "\"acceptance\": 0.5000,"));
+    ck_assert_ptr_nonnull(strstr(buffer, "\"eta\": 3.500,"));
+
+    // a new status
+    status.sweep = 4;
+    tm_status_server_publish(server, &status);
+
+    ck_assert_int_gt(query(SOCKET_PATH, buffer, 1024), 0);
+    ck_assert_ptr_nonnull(strstr(buffer, "\"sweep\": 4,"));
+
+    _OK(tm_status_server_delete(server));
+}
+END_TEST
+
+START_TEST(test_status_client_hangup) {
+    char buffer[1024];
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET_PATH);
+
+    tm_status_server* server = tm_status_server_new(SOCKET_PATH);
+    ck_assert_ptr_nonnull(server);
+
+    tm_status status = {3, 10, 1.5, 300, 150, -42., .5};
+    tm_status_server_publish(server, &status);
+
+    // clients that leave before the reply must not raise SIGPIPE
+    for (int i = 0; i < 5; ++i) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        ck_assert_int_ge(fd, 0);
+        ck_assert_int_eq(connect(fd, (struct sockaddr*) &addr, sizeof(addr)), 0);
+        close(fd);
+    }
+
+    usleep(300000);
+
+    ck_assert_int_gt(query(SOCKET_PATH, buffer, 1024), 0);
+    ck_assert_ptr_nonnull(strstr(buffer, "\"sweep\": 3,"));
+
+    _OK(tm_status_server_delete(server));
+}
+END_TEST
+
+START_TEST(test_status_invalid_path) {
+    char path[256];
+    memset(path, 'a', 255);
+    path[255] = '\0';
+
+    ck_assert_ptr_null(tm_status_server_new(path));
+    ck_assert_ptr_null(tm_status_server_new("/this/does/not/exist.sock"));
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: status");
+
+    TCase* tc_status = tcase_create("status");
+    tcase_add_test(tc_status, test_status_publish_read);
+    tcase_add_test(tc_status, test_status_query);
+    tcase_add_test(tc_status, test_status_client_hangup);
+    tcase_add_test(tc_status, test_status_invalid_path);
+
+    suite_add_tcase(s, tc_status);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
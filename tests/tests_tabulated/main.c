@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "../tests.h"
+#include "tabulated.h"
+#include "mc.h"
+#include "pcg32.h"
+
+// largest error of the table, relative to the largest value of the potential over [r_check, rc)
+static void check_table(tm_table* table, tm_pair_function f, double* params, double r_check, double rc, double tol) {
+    double U, vir, U_max = 0, vir_max = 0, err_U = 0, err_vir = 0;
+
+    for(int i=0; i < 10000; i++) {
+        double r = r_check + (rc - r_check) * (i + .5) / 10000, Ut = 0, virt = 0;
+        f(r * r, params, &U, &vir);
+        tm_table_eval(table, r * r, &Ut, &virt);
+
+        U_max = fmax(U_max, fabs(U));
+        vir_max = fmax(vir_max, fabs(vir));
+        err_U = fmax(err_U, fabs(Ut - U));
+        err_vir = fmax(err_vir, fabs(virt - vir));
+    }
+
+    ck_assert_double_le(err_U / U_max, tol);
+    ck_assert_double_le(err_vir / vir_max, tol);
+
+    // nothing beyond the cutoff, and the value at the start of the grid below it
+    double Ut = 0, virt = 0;
+    tm_table_eval(table, rc * rc, &Ut, &virt);
+    tm_table_eval(table, 1e3, &Ut, &virt);
+    tm_table_eval(table, INFINITY, &Ut, &virt);
+    ck_assert_double_eq(Ut, 0);
+    ck_assert_double_eq(virt, 0);
+
+    f(table->s_min, params, &U, &vir);
+    tm_table_eval(table, table->s_min / 4, &Ut, &virt);
+    ck_assert_double_eq_tol(Ut, U, 1e-8 * fabs(U));
+}
+
+START_TEST(test_table_LJ) {
+    double epsilon[] = {1., .5}, sigma[] = {1., 1.5};
+
+    tm_pair_coefs* coefs = tm_pair_coefs_new(2, epsilon, sigma, 2.5, TM_MIXING_LORENTZ_BERTHELOT);
+    ck_assert_ptr_nonnull(coefs);
+
+    tm_pair_tables* tables = tm_pair_tables_new_from_coefs(coefs, 2048);
+    ck_assert_ptr_nonnull(tables);
+
+    for(int p=0; p < 4; p++) {
+        double* params = coefs->params + p * TM_POTENTIAL_MAX_PARAMS;
+        ck_assert_int_eq(((uintptr_t) tables->tables[p].coefs) % 64, 0);
+        check_table(&(tables->tables[p]), tm_pair_LJ, params, .8 * coefs->sigma[p], sqrt(coefs->rc2[p]), 1e-6);
+    }
+
+    _OK(tm_pair_tables_delete(tables));
+    _OK(tm_pair_coefs_delete(coefs));
+}
+END_TEST
+
+START_TEST(test_table_morse_buckingham) {
+    double params_morse[] = {1., 2., 1.2}, params_buck[] = {1000., 5., 2.}, r2_min = .64, rc2 = 9.;
+
+    tm_pair_tables* tables = tm_pair_tables_new(1, tm_pair_morse, params_morse, 3, &r2_min, &rc2, 1024);
+    ck_assert_ptr_nonnull(tables);
+    check_table(&(tables->tables[0]), tm_pair_morse, params_morse, .8, 3., 1e-6);
+    _OK(tm_pair_tables_delete(tables));
+
+    tables = tm_pair_tables_new(1, tm_pair_buckingham, params_buck, 3, &r2_min, &rc2, 1024);
+    ck_assert_ptr_nonnull(tables);
+    check_table(&(tables->tables[0]), tm_pair_buckingham, params_buck, .8, 3., 1e-6);
+    _OK(tm_pair_tables_delete(tables));
+}
+END_TEST
+
+START_TEST(test_table_sum_N) {
+    double params[] = {4., 4.}, r2_min = .49, rc2 = 6.25, r2[1000];
+
+    tm_pair_tables* tables = tm_pair_tables_new(1, tm_pair_LJ, params, 2, &r2_min, &rc2, 512);
+    ck_assert_ptr_nonnull(tables);
+
+    pcg32_init(42);
+    for(int i=0; i < 1000; i++)
+        r2[i] = drand() * 8;
+
+    double U1 = 0, vir1 = 0, U2 = 0, vir2 = 0;
+    tm_table_sum_N(&(tables->tables[0]), 1000, r2, &U1, &vir1);
+    for(int i=0; i < 1000; i++)
+        tm_table_eval(&(tables->tables[0]), r2[i], &U2, &vir2);
+
+    ck_assert_double_eq_tol(U1, U2, 1e-8 * fabs(U2));
+    ck_assert_double_eq_tol(vir1, vir2, 1e-8 * fabs(vir2));
+
+    _OK(tm_pair_tables_delete(tables));
+}
+END_TEST
+
+START_TEST(test_table_mc) {
+    long composition[] = {40, 24};
+    double epsilon[] = {1., .5}, sigma[] = {1., 1.3};
+
+    for(int sort=0; sort < 2; sort++) {
+        pcg32_init(42);
+        tm_mc* mc = tm_mc_new_mixture(2, composition, epsilon, sigma, TM_MIXING_LORENTZ_BERTHELOT, .6, 1.5, 2.5, .3, sort);
+        ck_assert_ptr_nonnull(mc);
+
+        double U_LJ = mc->U, vir_LJ = mc->vir;
+
+        tm_pair_tables* tables = tm_pair_tables_new_from_coefs(mc->coefs, 2048);
+        ck_assert_ptr_nonnull(tables);
+
+        _OK(tm_mc_use_tables(mc, tables));
+        ck_assert_double_eq_tol(mc->U, U_LJ, 1e-6 * fabs(U_LJ));
+        ck_assert_double_eq_tol(mc->vir, vir_LJ, 1e-6 * fabs(vir_LJ));
+
+        // energy is still tracked move after move
+        for(int i=0; i < 10; i++)
+            _OK(tm_mc_sweep(mc));
+
+        double U, vir;
+        tm_mc_compute_U(mc, &U, &vir);
+        ck_assert_double_eq_tol(U, mc->U, 1e-8);
+        ck_assert_double_eq_tol(vir, mc->vir, 1e-8);
+
+        // ... and is close to the LJ one
+        _OK(tm_mc_use_tables(mc, NULL));
+        ck_assert_double_eq_tol(mc->U, U, 1e-6 * fabs(U));
+
+        _OK(tm_mc_delete(mc));
+        _OK(tm_pair_tables_delete(tables));
+    }
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: tabulated");
+
+    TCase* tc_tabulated = tcase_create("tabulated");
+    tcase_add_test(tc_tabulated, test_table_LJ);
+    tcase_add_test(tc_tabulated, test_table_morse_buckingham);
+    tcase_add_test(tc_tabulated, test_table_sum_N);
+    tcase_add_test(tc_tabulated, test_table_mc);
+
+    suite_add_tcase(s, tc_tabulated);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
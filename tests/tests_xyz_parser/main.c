@@ -5,10 +5,11 @@
 #include "xyz_parser.h"
 #include "../tests.h"
 #include "files.h"
+#include "memory.h"
 
 int tm_xyz_parse_real(tm_parf_token* tk, char* input, double *out);
 int tm_xyz_parse_positive_int(tm_parf_token* tk, char* input, long *out);
-int tm_xyz_parse_atom_type(tm_parf_token* tk, char* input, char **out);
+int tm_xyz_parse_atom_type(tm_parf_token* tk, char* input, char **out, int* len);
 
 
 START_TEST(test_parser_positive_int) {
@@ -66,16 +67,16 @@ START_TEST(test_parser_atom_type) {
     };
 
     tm_parf_token t;
-    int sz;
+    int sz, len;
     char* found;
 
     sz = sizeof(correct_input) / sizeof(*correct_input);
     for(int i=0; i < sz; i++) {
         _OK(tm_lexer_token_init(&t, correct_input[i]));
-        _OK(tm_xyz_parse_atom_type(&t, correct_input[i], &found));
-        ck_assert_str_eq(correct_input[i], found);
+        _OK(tm_xyz_parse_atom_type(&t, correct_input[i], &found, &len));
+        ck_assert_ptr_eq(found, correct_input[i]);
+        ck_assert_int_eq(len, strlen(correct_input[i]));
         ck_assert_int_eq(t.type, TM_TK_EOS);
-        free(found);
     }
 
 } END_TEST
@@ -97,6 +98,7 @@ START_TEST(test_read_file) {
 
     ck_assert_int_eq(g->N, 3);
 
+    ck_assert_int_eq(g->N_types, 2);
     ck_assert_str_eq(g->type_vals[0], "O");
     ck_assert_str_eq(g->type_vals[1], "H");
 
@@ -105,7 +107,7 @@ START_TEST(test_read_file) {
     ck_assert_int_eq(g->types[2], 1);
 
     _OK(tm_geometry_delete(g));
-    free(buffer);
+    tm_free(buffer);
 }
 END_TEST
 
@@ -136,6 +138,65 @@ START_TEST(test_read_errors) {
 }
 END_TEST
 
+START_TEST(test_reader) {
+    FILE* f = fopen("test_dummy_traj.xyz", "r");
+    ck_assert_ptr_nonnull(f);
+
+    tm_xyz_reader* reader = tm_xyz_reader_new(f, 1);
+    ck_assert_ptr_nonnull(reader);
+
+    // read all frames
+    tm_geometry* g = NULL, *g_prev = NULL;
+    long frame = 0;
+
+    while(tm_xyz_reader_next(reader, &g) == TM_ERR_OK) {
+        if(g_prev != NULL)
+            ck_assert_ptr_eq(g, g_prev); // the geometry is reused
+
+        ck_assert_double_eq_tol(g->positions[0 * g->stride + (frame < 2 ? 0 : 1)], .1 * frame, 1e-12);
+        g_prev = g;
+        frame++;
+    }
+
+    ck_assert_int_eq(frame, 3);
+    ck_assert_int_eq(reader->N_offsets, 3);
+
+    // last frame, where types are kept from one frame to the other
+    ck_assert_int_eq(g->N, 3);
+    ck_assert_int_eq(g->N_types, 3);
+    ck_assert_int_eq(g->types[0], 1);
+    ck_assert_int_eq(g->types[1], 0);
+    ck_assert_str_eq(g->type_vals[g->types[2]], "Ne");
+
+    // go back to frame 1
+    _OK(tm_xyz_reader_seek(reader, 1));
+    _OK(tm_xyz_reader_next(reader, &g));
+    ck_assert_int_eq(g->N, 2);
+    ck_assert_double_eq_tol(g->positions[0], .1, 1e-12);
+
+    // no frame 3
+    _OK(tm_xyz_reader_seek(reader, 3));
+    _NOK(tm_xyz_reader_next(reader, &g));
+    _NOK(tm_xyz_reader_seek(reader, 4));
+
+    _OK(tm_xyz_reader_delete(reader));
+
+    // seek directly, without an index
+    rewind(f);
+    reader = tm_xyz_reader_new(f, 0);
+    ck_assert_ptr_nonnull(reader);
+
+    _OK(tm_xyz_reader_seek(reader, 2));
+    _OK(tm_xyz_reader_next(reader, &g));
+    ck_assert_int_eq(g->N, 3);
+    ck_assert_double_eq_tol(g->positions[0], 1.2, 1e-12);
+    _NOK(tm_xyz_reader_next(reader, &g));
+
+    _OK(tm_xyz_reader_delete(reader));
+    fclose(f);
+}
+END_TEST
+
 int main(int argc, char* argv[]) {
     Suite* s = suite_create("tests: xyz_parser");
 
@@ -151,6 +212,7 @@ int main(int argc, char* argv[]) {
     TCase* tc_read = tcase_create("read");
     tcase_add_test(tc_read, test_read_file);
     tcase_add_test(tc_read, test_read_errors);
+    tcase_add_test(tc_read, test_reader);
 
     suite_add_tcase(s, tc_read);
 
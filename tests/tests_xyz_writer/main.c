@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "../tests.h"
+#include "xyz_writer.h"
+#include "xyz_parser.h"
+#include "files.h"
+#include "memory.h"
+#include "pcg32.h"
+
+static void check_format(double value) {
+    char expected[TM_XYZ_REAL_MAX_LENGTH], found[TM_XYZ_REAL_MAX_LENGTH];
+
+    int length = snprintf(expected, TM_XYZ_REAL_MAX_LENGTH, "%9.5f", value);
+    ck_assert_int_eq(tm_xyz_format_real(value, found), length);
+    ck_assert_str_eq(found, expected);
+}
+
+START_TEST(test_format_real_special) {
+    double values[] = {
+            0., -0., 1., -1., 1e-9, -1e-9, 5e-6, -5e-6, 4.999999e-6, 1234.5, 9.999995, -9.999995, 99.999995, 999.999995,
+            123456.789, -123456.789, 39999999999.999, 4e10, -4e10, 1e300, -DBL_MAX, DBL_MIN, 4.9e-324,
+            INFINITY, -INFINITY, NAN
+    };
+
+    for(size_t i=0; i < sizeof(values) / sizeof(double); i++)
+        check_format(values[i]);
+
+    // halfway cases (multiples of 1/64 are exact), rounded to even
+    for(int i=-2000; i < 2000; i++)
+        check_format(i / 64.);
+}
+END_TEST
+
+START_TEST(test_format_real_random) {
+    pcg32_init(42);
+
+    for(int i=0; i < 200000; i++) {
+        double scale = pow(10, (int) (drand() * 16) - 6);
+        check_format((drand() - .5) * scale);
+    }
+
+    // close to the rounding points
+    for(int i=0; i < 100000; i++) {
+        double value = ((double) (pcg32() % 10000000) + .5) / 1e5;
+        check_format(value);
+        check_format(nextafter(value, 0));
+        check_format(nextafter(value, 1e6));
+    }
+}
+END_TEST
+
+static void check_write(long N, int n_threads) {
+    tm_geometry* g = tm_geometry_new(N);
+    ck_assert_ptr_nonnull(g);
+
+    char* names[] = {"He", "Ar", "Xe123"};
+    tm_type_id types[3];
+    for(int t=0; t < 3; t++)
+        _OK(tm_geometry_type_intern(g, names[t], strlen(names[t]), &types[t]));
+
+    pcg32_init(42);
+    for(long i=0; i < N; i++) {
+        g->types[i] = types[i % 3];
+        for(int k=0; k < 3; k++)
+            g->positions[k * g->stride + i] = (drand() - .5) * 200;
+    }
+
+    // reference
+    FILE* f = tmpfile();
+    ck_assert_ptr_nonnull(f);
+
+    fprintf(f, "%ld\ntitle\n", N);
+    for(long i=0; i < N; i++)
+        fprintf(f, "%s %9.5f %9.5f %9.5f\n", names[i % 3], g->positions[i], g->positions[g->stride + i], g->positions[2 * g->stride + i]);
+
+    rewind(f);
+    char* expected;
+    _OK(tm_read_file(f, &expected));
+    fclose(f);
+
+    // writer
+    f = tmpfile();
+    ck_assert_ptr_nonnull(f);
+
+    _OK(tm_xyz_write(f, g, "title", n_threads));
+
+    rewind(f);
+    char* found;
+    _OK(tm_read_file(f, &found));
+    fclose(f);
+
+    ck_assert_str_eq(found, expected);
+
+    // and it can be read back
+    tm_geometry* g2 = tm_xyz_loads(found);
+    ck_assert_ptr_nonnull(g2);
+    ck_assert_int_eq(g2->N, N);
+    ck_assert_int_eq(g2->N_types, N < 3 ? N : 3);
+    _OK(tm_geometry_delete(g2));
+
+    tm_free(expected);
+    tm_free(found);
+    _OK(tm_geometry_delete(g));
+}
+
+START_TEST(test_write_single_thread) {
+    check_write(1, 1);
+    check_write(100, 1);
+}
+END_TEST
+
+START_TEST(test_write_threads) {
+    check_write(100, 4); // not worth splitting
+    check_write(4 * TM_XYZ_MIN_ATOMS_PER_THREAD + 17, 4);
+    check_write(3 * TM_XYZ_MIN_ATOMS_PER_THREAD + 5, 8);
+}
+END_TEST
+
+int main(int argc, char* argv[]) {
+    Suite* s = suite_create("tests: xyz writer");
+
+    TCase* tc_format = tcase_create("format");
+    tcase_add_test(tc_format, test_format_real_special);
+    tcase_add_test(tc_format, test_format_real_random);
+
+    suite_add_tcase(s, tc_format);
+
+    TCase* tc_write = tcase_create("write");
+    tcase_add_test(tc_write, test_write_single_thread);
+    tcase_add_test(tc_write, test_write_threads);
+
+    suite_add_tcase(s, tc_write);
+
+    // run suite
+    SRunner *sr = srunner_create(s) ;
+    srunner_run_all(sr, CK_VERBOSE);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    // exit
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}